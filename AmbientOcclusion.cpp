@@ -0,0 +1,140 @@
+//== INCLUDES =================================================================
+#include <cmath>
+#include <algorithm>
+
+#include "AmbientOcclusion.h"
+
+//== IMPLEMENTATION ==========================================================
+namespace {
+
+/// steps of the R2 sequence, the 2D generalization of the golden ratio
+/// (Roberts, "The Unreasonable Effectiveness of Quasirandom Sequences")
+const float r2_step[2] = { 0.7548776662f, 0.5698402910f };
+
+/// origins move this fraction of the radius off the surface
+const float origin_offset = 1e-3f;
+
+/// uniform in [0,1) from a vertex index
+inline float hash_unit(unsigned int _x)
+{
+    _x ^= _x >> 16;
+    _x *= 0x7feb352du;
+    _x ^= _x >> 15;
+    _x *= 0x846ca68bu;
+    _x ^= _x >> 16;
+    return (_x >> 8)*(1.0f/16777216.0f);
+}
+
+/// tangents _t, _b completing unit _n to an orthonormal basis (Duff et al.,
+/// "Building an Orthonormal Basis, Revisited")
+inline void tangent_basis(const float* _n, float* _t, float* _b)
+{
+    const float sign = _n[2] >= 0.0f ? 1.0f : -1.0f;
+    const float a = -1.0f/(sign + _n[2]);
+    const float c = _n[0]*_n[1]*a;
+    _t[0] = 1.0f + sign*_n[0]*_n[0]*a;
+    _t[1] = sign*c;
+    _t[2] = -sign*_n[0];
+    _b[0] = c;
+    _b[1] = sign + _n[1]*_n[1]*a;
+    _b[2] = -_n[1];
+}
+
+}
+
+//-----------------------------------------------------------------------------
+AmbientOcclusion::AmbientOcclusion()
+    : radius_(0.0f), rays_(0)
+{
+}
+
+void AmbientOcclusion::begin(const float* _points, const float* _normals, size_t _n_vertices,
+                             const unsigned int* _triangles, size_t _n_faces, float _radius)
+{
+    clear();
+    if ( !_n_vertices || !_n_faces )
+        return;
+
+    bvh_.build(_points, _n_vertices, _triangles, _n_faces);
+    points_.assign(_points, _points + 3*_n_vertices);
+    normals_.assign(_normals, _normals + 3*_n_vertices);
+    escaped_.assign(_n_vertices, 0);
+    accessibility_.assign(_n_vertices, 1.0f);
+    radius_ = _radius;
+}
+
+bool AmbientOcclusion::refine(int _rays)
+{
+    if ( bvh_.empty() || _rays <= 0 )
+        return false;
+
+    const long  n      = static_cast<long>(escaped_.size());
+    const int   first  = rays_, last = rays_ + _rays;
+    const float offset = origin_offset*radius_;
+    const float scale  = 1.0f/last;
+    const float two_pi = 6.28318530718f;
+
+    /// rays from neighboring vertices traverse similar nodes
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (long v = 0; v < n; ++v)
+    {
+        const float* p  = &points_[3*v];
+        const float* nv = &normals_[3*v];
+        if ( nv[0] == 0.0f && nv[1] == 0.0f && nv[2] == 0.0f )
+        {
+            /// no hemisphere without a normal: counts as open
+            escaped_[v] += _rays;
+            accessibility_[v] = 1.0f;
+            continue;
+        }
+
+        float t[3], b[3];
+        tangent_basis(nv, t, b);
+        const float o[3] = { p[0] + offset*nv[0], p[1] + offset*nv[1], p[2] + offset*nv[2] };
+        const float u0 = hash_unit(2*static_cast<unsigned int>(v));
+        const float w0 = hash_unit(2*static_cast<unsigned int>(v)+1);
+
+        unsigned int open = 0;
+        for (int r = first; r < last; ++r)
+        {
+            /// cosine distribution: uniform on the disk, lifted onto the hemisphere
+            float u = u0 + r*r2_step[0], w = w0 + r*r2_step[1];
+            u -= std::floor(u);
+            w -= std::floor(w);
+            const float phi = two_pi*u, s = std::sqrt(w), z = std::sqrt(1.0f-w);
+            const float x = s*std::cos(phi), y = s*std::sin(phi);
+            const float d[3] = { x*t[0] + y*b[0] + z*nv[0],
+                                 x*t[1] + y*b[1] + z*nv[1],
+                                 x*t[2] + y*b[2] + z*nv[2] };
+            if ( !bvh_.occluded(o, d, radius_) )
+                ++open;
+        }
+        escaped_[v] += open;
+        accessibility_[v] = escaped_[v]*scale;
+    }
+
+    rays_ = last;
+    return true;
+}
+
+void AmbientOcclusion::finish()
+{
+    bvh_.clear();
+    std::vector<float>().swap(points_);
+    std::vector<float>().swap(normals_);
+    std::vector<unsigned int>().swap(escaped_);
+}
+
+void AmbientOcclusion::clear()
+{
+    finish();
+    std::vector<float>().swap(accessibility_);
+    radius_ = 0.0f;
+    rays_ = 0;
+}
+
+size_t AmbientOcclusion::bytes() const
+{
+    return bvh_.bytes() + (points_.capacity() + normals_.capacity() + accessibility_.capacity())*sizeof(float) +
+           escaped_.capacity()*sizeof(unsigned int);
+}
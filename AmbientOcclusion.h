@@ -0,0 +1,57 @@
+#ifndef AMBIENTOCCLUSION_H
+#define AMBIENTOCCLUSION_H
+
+//== INCLUDES =================================================================
+#include <vector>
+#include <cstddef>
+
+#include "TriangleBVH.h"
+
+//== CLASS DEFINITION =========================================================
+/// Per-vertex ambient occlusion by ray casting against a TriangleBVH of the
+/// mesh. Every vertex shoots cosine distributed rays over the hemisphere of
+/// its normal, up to a radius; its accessibility is the fraction that
+/// escape. Rays are added in passes, so a bake can be shown after every
+/// pass and refine while the viewer stays responsive. Ray directions follow
+/// an open-ended low discrepancy sequence, rotated per vertex, so every
+/// prefix of the passes is evenly spread and neighboring vertices do not
+/// band.
+class AmbientOcclusion
+{
+public:
+    AmbientOcclusion();
+
+    /// Start a bake of the mesh given by _points, _normals (3 floats per
+    /// vertex, normals of unit length) and _triangles (3 indices per face);
+    /// all are copied. Rays end after _radius.
+    void begin(const float* _points, const float* _normals, size_t _n_vertices,
+               const unsigned int* _triangles, size_t _n_faces, float _radius);
+
+    /// _rays more rays from every vertex, in parallel; false if no bake runs
+    bool refine(int _rays);
+
+    /// release BVH and copies, keeping the values
+    void finish();
+    void clear();
+
+    bool running() const { return !bvh_.empty(); }
+    int  rays() const    { return rays_; }
+
+    /// per vertex, 1: nothing within the radius, 0: fully enclosed
+    const std::vector<float>& accessibility() const { return accessibility_; }
+
+    size_t bytes() const;
+
+private:
+    TriangleBVH               bvh_;
+    std::vector<float>        points_;
+    std::vector<float>        normals_;
+    std::vector<unsigned int> escaped_;       ///< rays that hit nothing, per vertex
+    std::vector<float>        accessibility_;
+    float                     radius_;
+    int                       rays_;          ///< rays per vertex so far
+};
+
+//=============================================================================
+#endif // AMBIENTOCCLUSION_H defined
+//=============================================================================
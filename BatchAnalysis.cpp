@@ -0,0 +1,429 @@
+//== INCLUDES =================================================================
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDirIterator>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QSemaphore>
+#include <QMutex>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "BatchAnalysis.h"
+#include "TCMesh.h"
+#include "MeshReader.h"
+#include "MeshKernelsT.h"
+#include "MeshAnalysis.h"
+#include "MeshTopology.h"
+#include "ScalarHistogram.h"
+
+//== IMPLEMENTATION ==========================================================
+namespace {
+
+/// extensions of the formats OpenMesh reads
+const char* mesh_suffixes[] = { "off", "obj", "ply", "stl", "om" };
+
+/// rough bytes of mesh and analysis per byte of a binary file; text files
+/// take less
+const qint64 memory_per_file_byte = 6;
+
+bool is_mesh_file(const QFileInfo& _info)
+{
+    const QString suffix = _info.suffix().toLower();
+    for (size_t i = 0; i < sizeof(mesh_suffixes)/sizeof(mesh_suffixes[0]); ++i)
+        if ( suffix == mesh_suffixes[i] )
+            return true;
+    return false;
+}
+
+void collect(const QString& _input, QStringList& _files)
+{
+    if ( _input.startsWith('@') )
+    {
+        QFile list(_input.mid(1));
+        if ( !list.open(QIODevice::ReadOnly | QIODevice::Text) )
+        {
+            std::cerr << "Batch: cannot read list '" << _input.mid(1).toLocal8Bit().constData() << "'" << std::endl;
+            return;
+        }
+        /// relative entries are relative to the list
+        const QDir base = QFileInfo(list).absoluteDir();
+        QTextStream in(&list);
+        while ( !in.atEnd() )
+        {
+            const QString line = in.readLine().trimmed();
+            if ( !line.isEmpty() && !line.startsWith('#') )
+                collect(base.absoluteFilePath(line), _files);
+        }
+        return;
+    }
+
+    const QFileInfo info(_input);
+    if ( info.isDir() )
+    {
+        QDirIterator it(info.absoluteFilePath(), QDir::Files, QDirIterator::Subdirectories);
+        while ( it.hasNext() )
+        {
+            it.next();
+            if ( is_mesh_file(it.fileInfo()) )
+                _files << it.filePath();
+        }
+    }
+    else
+        _files << info.absoluteFilePath();
+}
+
+double seconds_since(QElapsedTimer& _timer)
+{
+    const double seconds = 1e-9*_timer.nsecsElapsed();
+    _timer.start();
+    return seconds;
+}
+
+/// 2nd, 50th and 98th percentile of _values
+void summarize(const std::vector<float>& _values, float _out[3])
+{
+    ScalarHistogram histogram;
+    histogram.compute(_values.empty() ? 0 : &_values[0], _values.size());
+    _out[0] = histogram.percentile(0.02f);
+    _out[1] = histogram.percentile(0.50f);
+    _out[2] = histogram.percentile(0.98f);
+}
+
+//-----------------------------------------------------------------------------
+// rows
+//-----------------------------------------------------------------------------
+/// _text in double quotes, quotes doubled
+std::string csv_quote(const std::string& _text)
+{
+    std::string quoted = "\"";
+    for (size_t i = 0; i < _text.size(); ++i)
+    {
+        if ( _text[i] == '"' )
+            quoted += '"';
+        quoted += _text[i];
+    }
+    return quoted + "\"";
+}
+
+std::string json_quote(const std::string& _text)
+{
+    static const char hex[] = "0123456789abcdef";
+    std::string quoted = "\"";
+    for (size_t i = 0; i < _text.size(); ++i)
+    {
+        const unsigned char c = static_cast<unsigned char>(_text[i]);
+        if ( c == '"' || c == '\\' )
+            (quoted += '\\') += c;
+        else if ( c < 0x20 )
+            ((quoted += "\\u00") += hex[c >> 4]) += hex[c & 15];
+        else
+            quoted += c;
+    }
+    return quoted + "\"";
+}
+
+/// Writes a CSV header, a CSV row or a JSON object per line from the same
+/// sequence of named fields, so the formats cannot drift apart.
+class RowWriter
+{
+public:
+    enum Format { Header, CSV, JSON };
+
+    RowWriter(std::ostream& _os, Format _format)
+        : os_(_os), format_(_format), first_(true)
+    {
+        if ( format_ == JSON )
+            os_ << "{";
+    }
+
+    template <typename T>
+    void value(const char* _name, const T& _value)
+    {
+        if ( next(_name) )
+            os_ << _value;
+    }
+
+    /// JSON has no NaN or infinity
+    void value(const char* _name, float _value)
+    {
+        if ( !next(_name) )
+            return;
+        if ( format_ == JSON && !std::isfinite(_value) )
+            os_ << "null";
+        else
+            os_ << _value;
+    }
+
+    void text(const char* _name, const std::string& _text)
+    {
+        if ( next(_name) )
+            os_ << (format_ == JSON ? json_quote(_text) : csv_quote(_text));
+    }
+
+    void end()
+    {
+        os_ << (format_ == JSON ? "}\n" : "\n");
+    }
+
+private:
+    /// separator and key; false for the header, which has names only
+    bool next(const char* _name)
+    {
+        if ( !first_ )
+            os_ << (format_ == JSON ? ", " : ",");
+        first_ = false;
+        if ( format_ == Header )
+        {
+            os_ << _name;
+            return false;
+        }
+        if ( format_ == JSON )
+            os_ << json_quote(_name) << ": ";
+        return true;
+    }
+
+    std::ostream& os_;
+    Format        format_;
+    bool          first_;
+};
+
+void write_row(std::ostream& _os, RowWriter::Format _format, const MeshSummary& _s)
+{
+    static const char* axes[3] = { "x", "y", "z" };
+    static const char* percentiles[3] = { "p2", "p50", "p98" };
+
+    RowWriter row(_os, _format);
+    row.text ("file",          std::string(_s.file.toUtf8().constData()));
+    row.text ("status",        _s.error.empty() ? std::string("ok") : _s.error);
+    row.value("bytes",         _s.bytes);
+    row.value("vertices",      _s.vertices);
+    row.value("edges",         _s.edges);
+    row.value("faces",         _s.faces);
+    row.value("skipped_faces", _s.skipped_faces);
+    row.value("split_faces",   _s.split_faces);
+    row.value("read_s",        _s.read_seconds);
+    row.value("normals_s",     _s.normals_seconds);
+    row.value("topology_s",    _s.topology_seconds);
+    row.value("valence_s",     _s.valence_seconds);
+    row.value("curvature_s",   _s.curvature_seconds);
+    row.value("total_s",       _s.total_seconds);
+    for (int k = 0; k < 3; ++k)
+        row.value((std::string("bb_min_") + axes[k]).c_str(), _s.bb_min[k]);
+    for (int k = 0; k < 3; ++k)
+        row.value((std::string("bb_max_") + axes[k]).c_str(), _s.bb_max[k]);
+    row.value("diagonal",        _s.diagonal);
+    row.value("valence_min",     _s.valence_min);
+    row.value("valence_max",     _s.valence_max);
+    row.value("valence_mean",    _s.valence_mean);
+    row.value("valence_regular", _s.valence_regular);
+    for (int k = 0; k < 3; ++k)
+        row.value((std::string("gaussian_") + percentiles[k]).c_str(), _s.gaussian[k]);
+    for (int k = 0; k < 3; ++k)
+        row.value((std::string("mean_") + percentiles[k]).c_str(), _s.mean[k]);
+    row.value("components",           _s.components);
+    row.value("isolated_vertices",    _s.isolated_vertices);
+    row.value("boundary_loops",       _s.boundary_loops);
+    row.value("boundary_edges",       _s.boundary_edges);
+    row.value("nonmanifold_vertices", _s.nonmanifold_vertices);
+    row.value("degenerate_faces",     _s.degenerate_faces);
+    row.value("euler_characteristic", _s.euler_characteristic);
+    row.end();
+}
+
+}
+
+//-----------------------------------------------------------------------------
+MeshSummary::MeshSummary()
+    : bytes(0), vertices(0), edges(0), faces(0), skipped_faces(0), split_faces(0),
+      read_seconds(0), normals_seconds(0), topology_seconds(0),
+      valence_seconds(0), curvature_seconds(0), total_seconds(0),
+      diagonal(0), valence_min(0), valence_max(0), valence_mean(0), valence_regular(0),
+      components(0), isolated_vertices(0), boundary_loops(0), boundary_edges(0),
+      nonmanifold_vertices(0), degenerate_faces(0), euler_characteristic(0)
+{
+    for (int k = 0; k < 3; ++k)
+        bb_min[k] = bb_max[k] = gaussian[k] = mean[k] = 0.0f;
+}
+
+QStringList collect_mesh_files(const QStringList& _inputs)
+{
+    QStringList files;
+    for (int i = 0; i < _inputs.size(); ++i)
+        collect(_inputs[i], files);
+    files.sort();
+    files.removeDuplicates();
+    return files;
+}
+
+bool analyze_mesh_file(const QString& _file, MeshSummary& _s)
+{
+    QElapsedTimer total, timer;
+    total.start();
+    timer.start();
+
+    _s = MeshSummary();
+    _s.file  = _file;
+    _s.bytes = QFileInfo(_file).size();
+
+    /// only what the analysis reads: no colors or texture coordinates
+    TCMesh mesh;
+    mesh.request_face_normals();
+    mesh.request_vertex_normals();
+    OpenMesh::IO::Options opt;
+    MeshReadStats stats;
+    if ( !read_mesh_fast(mesh, _file, opt, &stats) )
+    {
+        _s.error = "cannot read mesh";
+        _s.total_seconds = 1e-9*total.nsecsElapsed();
+        return false;
+    }
+    _s.read_seconds  = seconds_since(timer);
+    _s.vertices      = mesh.n_vertices();
+    _s.edges         = mesh.n_edges();
+    _s.faces         = mesh.n_faces();
+    _s.skipped_faces = stats.skipped_faces;
+    _s.split_faces   = stats.split_faces;
+    if ( !mesh.n_faces() )
+    {
+        _s.error = "no faces";
+        _s.total_seconds = 1e-9*total.nsecsElapsed();
+        return false;
+    }
+
+    /// the viewer's load pipeline, minus the GPU
+    update_normals(mesh);
+    TCMesh::Point lo, hi;
+    bounding_box(mesh, lo, hi);
+    for (int k = 0; k < 3; ++k)
+    {
+        _s.bb_min[k] = lo[k];
+        _s.bb_max[k] = hi[k];
+    }
+    _s.diagonal = (hi-lo).norm();
+    _s.normals_seconds = seconds_since(timer);
+
+    TopologyReport topology;
+    analyze_topology(mesh, topology);
+    _s.components           = topology.components;
+    _s.isolated_vertices    = topology.isolated_vertices;
+    _s.boundary_loops       = topology.boundary_loops;
+    _s.boundary_edges       = topology.boundary_edges;
+    _s.nonmanifold_vertices = topology.nonmanifold_vertices;
+    _s.degenerate_faces     = topology.degenerate_faces;
+    _s.euler_characteristic = topology.euler_characteristic;
+    _s.topology_seconds = seconds_since(timer);
+
+    std::vector<float> values;
+    compute_valence(mesh, values);
+    double sum = 0.0;
+    size_t regular = 0;
+    _s.valence_min = _s.valence_max = values[0];
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        _s.valence_min = std::min(_s.valence_min, values[i]);
+        _s.valence_max = std::max(_s.valence_max, values[i]);
+        sum += values[i];
+        regular += values[i] == 6.0f;
+    }
+    _s.valence_mean    = static_cast<float>(sum/values.size());
+    _s.valence_regular = static_cast<float>(regular)/values.size();
+    _s.valence_seconds = seconds_since(timer);
+
+    compute_gaussian_curvature(mesh, values);
+    summarize(values, _s.gaussian);
+    compute_mean_curvature(mesh, values);
+    summarize(values, _s.mean);
+    _s.curvature_seconds = seconds_since(timer);
+
+    _s.total_seconds = 1e-9*total.nsecsElapsed();
+    return true;
+}
+
+int run_batch(const BatchOptions& _options, std::ostream& _log)
+{
+    const QStringList files = collect_mesh_files(_options.inputs);
+    if ( files.isEmpty() )
+    {
+        _log << "Batch: no mesh files found" << std::endl;
+        return -1;
+    }
+
+    std::ofstream file;
+    std::ostream* out = &std::cout;
+    if ( !_options.output.isEmpty() )
+    {
+        file.open(_options.output.toLocal8Bit().constData());
+        if ( !file )
+        {
+            _log << "Batch: cannot write '" << _options.output.toLocal8Bit().constData() << "'" << std::endl;
+            return -1;
+        }
+        out = &file;
+    }
+    const bool json = _options.output.endsWith(".json", Qt::CaseInsensitive) ||
+                      _options.output.endsWith(".jsonl", Qt::CaseInsensitive);
+    const RowWriter::Format format = json ? RowWriter::JSON : RowWriter::CSV;
+    if ( !json )
+        write_row(*out, RowWriter::Header, MeshSummary());
+
+    /// One mesh per worker, the kernels inside a worker run serially.
+    /// With a single worker the kernels keep their own threads.
+    const int n = files.size();
+#ifdef _OPENMP
+    int jobs = _options.jobs > 0 ? _options.jobs : omp_get_max_threads();
+    omp_set_max_active_levels(1);
+#else
+    int jobs = 1;
+#endif
+    jobs = std::min(jobs, n);
+
+    /// megabytes, a mesh larger than the budget runs alone
+    const int budget = static_cast<int>(std::min<size_t>(std::max<size_t>(_options.memory_mb, 1), 1 << 30));
+    QSemaphore memory(budget);
+    QMutex     mutex;
+    int        done = 0, failed = 0;
+
+    _log << "Batch: " << n << " meshes on " << jobs << " workers, "
+         << budget << " MB memory budget" << std::endl;
+    QElapsedTimer timer;
+    timer.start();
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(jobs)
+    for (int i = 0; i < n; ++i)
+    {
+        const qint64 estimate = memory_per_file_byte*QFileInfo(files[i]).size()/(1024*1024) + 1;
+        const int units = static_cast<int>(std::min<qint64>(estimate, budget));
+        memory.acquire(units);
+        MeshSummary summary;
+        const bool ok = analyze_mesh_file(files[i], summary);
+        memory.release(units);
+
+        /// rows as they complete, so an interrupted run keeps its results
+        QMutexLocker lock(&mutex);
+        write_row(*out, format, summary);
+        out->flush();
+
+        ++done;
+        if ( !ok )
+            ++failed;
+        _log << "[" << done << "/" << n << "] " << files[i].toLocal8Bit().constData() << ": ";
+        if ( ok )
+            _log << summary.faces << " faces, " << summary.total_seconds << " s" << std::endl;
+        else
+            _log << summary.error << std::endl;
+    }
+
+    const double seconds = 1e-3*timer.elapsed();
+    _log << "Batch: " << n << " meshes, " << failed << " failed, in " << seconds << " s ("
+         << n/std::max(seconds, 1e-9) << " meshes/s)" << std::endl;
+    return failed;
+}
@@ -0,0 +1,68 @@
+#ifndef BATCHANALYSIS_H
+#define BATCHANALYSIS_H
+
+//== INCLUDES =================================================================
+#include <string>
+#include <ostream>
+#include <cstddef>
+
+#include <QString>
+#include <QStringList>
+
+//== TYPES ====================================================================
+/// what a batch run reads and where it writes
+struct BatchOptions
+{
+    BatchOptions() : jobs(0), memory_mb(4096) {}
+
+    QStringList inputs;     ///< mesh files, directories (searched recursively) or @file lists
+    QString     output;     ///< CSV, or JSON lines for *.json / *.jsonl; empty: CSV to stdout
+    int         jobs;       ///< meshes analyzed at once, 0: one per core
+    size_t      memory_mb;  ///< estimated memory of the meshes in flight
+};
+
+/// one row of a batch run
+struct MeshSummary
+{
+    MeshSummary();
+
+    QString     file;
+    std::string error;                 ///< empty if the mesh was analyzed
+    size_t      bytes, vertices, edges, faces;
+    size_t      skipped_faces, split_faces;   ///< repaired by the reader
+
+    /// wall clock seconds per stage
+    double      read_seconds, normals_seconds, topology_seconds,
+                valence_seconds, curvature_seconds, total_seconds;
+
+    float       bb_min[3], bb_max[3], diagonal;
+
+    float       valence_min, valence_max, valence_mean;
+    float       valence_regular;       ///< fraction of vertices of valence 6
+    /// 2nd, 50th and 98th percentile, the viewer's default color range
+    float       gaussian[3], mean[3];
+
+    size_t      components, isolated_vertices, boundary_loops, boundary_edges,
+                nonmanifold_vertices, degenerate_faces;
+    long        euler_characteristic;
+};
+
+//== FUNCTIONS ================================================================
+/// Mesh files below the inputs: directories are searched recursively for
+/// the formats OpenMesh reads, "@list" names a file with one input per line.
+/// Sorted, without duplicates.
+QStringList collect_mesh_files(const QStringList& _inputs);
+
+/// Read _file and run the viewer's load time analysis on it: normals,
+/// topology, valence and curvature, serially on the calling thread.
+bool analyze_mesh_file(const QString& _file, MeshSummary& _summary);
+
+/// Analyze all meshes below _options.inputs on a pool of workers, one mesh
+/// per worker, and write one row per mesh as it completes. A worker only
+/// starts on a mesh once its estimated memory fits into what the running
+/// ones leave of the budget. Returns the number of meshes that failed.
+int run_batch(const BatchOptions& _options, std::ostream& _log);
+
+//=============================================================================
+#endif // BATCHANALYSIS_H defined
+//=============================================================================
@@ -0,0 +1,171 @@
+//== INCLUDES =================================================================
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+#include <QGLFramebufferObject>
+#include <QRunnable>
+#include <QThread>
+
+#include "FrameExporter.h"
+
+//== IMPLEMENTATION ==========================================================
+namespace {
+
+/// encodes one frame on a pool thread
+class PngWriter : public QRunnable
+{
+public:
+    PngWriter(const QImage& _image, const QString& _file, QSemaphore* _queue)
+        : image_(_image), file_(_file), queue_(_queue) {}
+
+    void run()
+    {
+        /// GL rows start at the bottom
+        if ( !image_.mirrored().save(file_, "PNG") )
+            std::cerr << "Cannot write '" << file_.toLocal8Bit().constData() << "'" << std::endl;
+        queue_->release();
+    }
+
+private:
+    QImage      image_;
+    QString     file_;
+    QSemaphore* queue_;
+};
+
+/// number of frames in flight between glReadPixels and mapping
+const int ring_size = 3;
+
+}
+
+//-----------------------------------------------------------------------------
+FrameExporter::FrameExporter(int _width, int _height, const QString& _pattern, int _n_workers)
+    : width_(_width),
+      height_(_height),
+      pattern_(_pattern),
+      fbo_(0),
+      use_pbo_(false),
+      next_slot_(0)
+{
+    int n = _n_workers > 0 ? _n_workers : std::max(1, QThread::idealThreadCount()-1);
+    pool_.setMaxThreadCount(n);
+    queue_.release(2*n);
+}
+
+FrameExporter::~FrameExporter()
+{
+    pool_.waitForDone();
+    for (size_t i = 0; i < pbos_.size(); ++i)
+        pbos_[i].destroy();
+    delete fbo_;
+}
+
+bool FrameExporter::begin()
+{
+    if ( !QGLFramebufferObject::hasOpenGLFramebufferObjects() )
+    {
+        std::cerr << "Offscreen export needs framebuffer object support" << std::endl;
+        return false;
+    }
+
+    fbo_ = new QGLFramebufferObject(width_, height_, QGLFramebufferObject::Depth);
+    if ( !fbo_->isValid() )
+    {
+        std::cerr << "Cannot create " << width_ << "x" << height_ << " framebuffer" << std::endl;
+        return false;
+    }
+
+    /// pixel buffer ring, fall back to synchronous reads if unavailable
+    use_pbo_ = true;
+    for (int i = 0; i < ring_size && use_pbo_; ++i)
+    {
+        QGLBuffer pbo(QGLBuffer::PixelPackBuffer);
+        pbo.setUsagePattern(QGLBuffer::StreamRead);
+        if ( pbo.create() && pbo.bind() )
+        {
+            pbo.allocate(4*width_*height_);
+            pbo.release();
+            pbos_.push_back(pbo);
+        }
+        else
+            use_pbo_ = false;
+    }
+    pending_.assign(pbos_.size(), -1);
+
+    std::clog << "Exporting " << width_ << "x" << height_ << " frames, "
+              << (use_pbo_ ? "asynchronous" : "synchronous") << " readback, "
+              << pool_.maxThreadCount() << " encoder threads" << std::endl;
+    return true;
+}
+
+void FrameExporter::bind()
+{
+    fbo_->bind();
+    glViewport(0, 0, width_, height_);
+}
+
+void FrameExporter::release()
+{
+    fbo_->release();
+}
+
+void FrameExporter::capture(int _frame)
+{
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+
+    if ( !use_pbo_ )
+    {
+        QImage image(width_, height_, QImage::Format_RGB32);
+        glReadPixels(0, 0, width_, height_, GL_BGRA, GL_UNSIGNED_BYTE, image.bits());
+        encode(image, _frame);
+        return;
+    }
+
+    /// the slot still holds the oldest frame in flight, collect it first
+    int slot = next_slot_;
+    if ( pending_[slot] >= 0 )
+        read_slot(slot);
+
+    pbos_[slot].bind();
+    glReadPixels(0, 0, width_, height_, GL_BGRA, GL_UNSIGNED_BYTE, 0);
+    pbos_[slot].release();
+
+    pending_[slot] = _frame;
+    next_slot_ = (slot+1) % pbos_.size();
+}
+
+void FrameExporter::finish()
+{
+    for (size_t i = 0; i < pending_.size(); ++i)
+    {
+        int slot = (next_slot_+i) % pending_.size();
+        if ( pending_[slot] >= 0 )
+            read_slot(slot);
+    }
+    pool_.waitForDone();
+}
+
+void FrameExporter::read_slot(int _slot)
+{
+    QImage image(width_, height_, QImage::Format_RGB32);
+
+    pbos_[_slot].bind();
+    const void* pixels = pbos_[_slot].map(QGLBuffer::ReadOnly);
+    if ( pixels )
+    {
+        std::memcpy(image.bits(), pixels, 4*width_*height_);
+        pbos_[_slot].unmap();
+    }
+    pbos_[_slot].release();
+
+    if ( pixels )
+        encode(image, pending_[_slot]);
+    pending_[_slot] = -1;
+}
+
+void FrameExporter::encode(const QImage& _image, int _frame)
+{
+    queue_.acquire();
+    pool_.start(new PngWriter(_image, pattern_.arg(_frame, 5, 10, QChar('0')), &queue_));
+}
@@ -0,0 +1,65 @@
+#ifndef FRAMEEXPORTER_H
+#define FRAMEEXPORTER_H
+
+//== INCLUDES =================================================================
+#include <vector>
+
+#include <QString>
+#include <QImage>
+#include <QGLBuffer>
+#include <QThreadPool>
+#include <QSemaphore>
+
+//== FORWARDS =================================================================
+class QGLFramebufferObject;
+
+//== CLASS DEFINITION =========================================================
+/// Renders frames into an offscreen framebuffer and writes them as PNG files.
+/// Readback goes through a ring of pixel buffer objects, so glReadPixels of
+/// frame i returns immediately and the copy is only mapped a few frames
+/// later; PNG encoding runs on a worker pool. Without PBO support the
+/// readback is synchronous. All GL calls need the viewer's context current.
+class FrameExporter
+{
+public:
+    /// _pattern gets the frame number as %1, e.g. "out/frame_%1.png"
+    FrameExporter(int _width, int _height, const QString& _pattern, int _n_workers=0);
+    ~FrameExporter();
+
+    /// create framebuffer and pixel buffers
+    bool begin();
+    /// render target on/off
+    void bind();
+    void release();
+
+    /// start reading back the current framebuffer content as frame _frame
+    void capture(int _frame);
+    /// drain the readback ring and wait for all encoders
+    void finish();
+
+    int  width()  const { return width_; }
+    int  height() const { return height_; }
+    bool uses_pbo() const { return use_pbo_; }
+
+private:
+    /// map a ring slot and hand its pixels to the encoders
+    void read_slot(int _slot);
+    void encode(const QImage& _image, int _frame);
+
+private:
+    int                    width_, height_;
+    QString                pattern_;
+    QGLFramebufferObject*  fbo_;
+
+    bool                   use_pbo_;
+    std::vector<QGLBuffer> pbos_;
+    std::vector<int>       pending_;  // frame read into each slot, -1 if none
+    int                    next_slot_;
+
+    QThreadPool            pool_;
+    QSemaphore             queue_;    // bounds the images waiting for encoding
+};
+
+//=============================================================================
+#endif // FRAMEEXPORTER_H defined
+//=============================================================================
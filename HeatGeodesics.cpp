@@ -0,0 +1,287 @@
+//== INCLUDES =================================================================
+#include <cmath>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+
+#include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
+
+#include "HeatGeodesics.h"
+
+//== IMPLEMENTATION ==========================================================
+typedef Eigen::SparseMatrix<double> SparseMatrix;
+
+/// CONFIG += cholmod selects SuiteSparse's supernodal factorization
+#ifdef TCVIEWER_CHOLMOD
+#include <Eigen/CholmodSupport>
+typedef Eigen::CholmodSupernodalLLT<SparseMatrix> Cholesky;
+#else
+typedef Eigen::SimplicialLDLT<SparseMatrix> Cholesky;
+#endif
+
+struct HeatGeodesics::Operators
+{
+    size_t                    n_vertices, n_faces;
+    std::vector<float>        points;     // 3 per vertex
+    std::vector<unsigned int> triangles;  // 3 per face
+    std::vector<float>        gradient;   // 9 per face: basis of the face gradient
+    std::vector<float>        cotan;      // 3 per face: cotangent of each corner
+    Cholesky                  heat, poisson;
+    Eigen::VectorXd           delta, u, divergence, phi;
+    std::vector<float>        field;      // 3 per face: normalized -grad u
+};
+
+static double seconds_since(std::chrono::steady_clock::time_point _start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+}
+
+static inline void sub(const float* _a, const float* _b, float* _out)
+{
+    _out[0] = _a[0]-_b[0]; _out[1] = _a[1]-_b[1]; _out[2] = _a[2]-_b[2];
+}
+
+static inline void cross(const float* _a, const float* _b, float* _out)
+{
+    _out[0] = _a[1]*_b[2] - _a[2]*_b[1];
+    _out[1] = _a[2]*_b[0] - _a[0]*_b[2];
+    _out[2] = _a[0]*_b[1] - _a[1]*_b[0];
+}
+
+static inline float dot(const float* _a, const float* _b)
+{
+    return _a[0]*_b[0] + _a[1]*_b[1] + _a[2]*_b[2];
+}
+
+static inline float norm(const float* _a)
+{
+    return std::sqrt(dot(_a, _a));
+}
+
+//-----------------------------------------------------------------------------
+HeatGeodesics::HeatGeodesics()
+    : ops_(0), factor_seconds_(0), solve_seconds_(0)
+{
+}
+
+HeatGeodesics::~HeatGeodesics()
+{
+    clear();
+}
+
+void HeatGeodesics::clear()
+{
+    delete ops_;
+    ops_ = 0;
+}
+
+size_t HeatGeodesics::n_vertices() const
+{
+    return ops_ ? ops_->n_vertices : 0;
+}
+
+bool HeatGeodesics::factor(const float* _points, size_t _n_vertices,
+                           const unsigned int* _triangles, size_t _n_faces,
+                           double _time_scale)
+{
+    clear();
+    if ( !_n_vertices || !_n_faces )
+        return false;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    Operators* ops = new Operators;
+    ops->n_vertices = _n_vertices;
+    ops->n_faces    = _n_faces;
+    ops->points.assign(_points, _points + 3*_n_vertices);
+    ops->triangles.assign(_triangles, _triangles + 3*_n_faces);
+    ops->gradient.resize(9*_n_faces);
+    ops->cotan.resize(3*_n_faces);
+    ops->field.resize(3*_n_faces);
+
+    /// per face: gradient basis, corner cotangents, area and Laplacian
+    /// entries; every face writes its own slots only
+    typedef Eigen::Triplet<double> Triplet;
+    std::vector<Triplet> stiffness(12*_n_faces);
+    std::vector<double>  face_area(_n_faces);
+    double edge_sum = 0.0;
+
+    const long nf = static_cast<long>(_n_faces);
+#pragma omp parallel for schedule(static) reduction(+:edge_sum)
+    for (long f = 0; f < nf; ++f)
+    {
+        const unsigned int* v = &ops->triangles[3*f];
+        const float* p[3] = { &ops->points[3*v[0]], &ops->points[3*v[1]], &ops->points[3*v[2]] };
+
+        /// e[i]: edge opposite corner i, counter-clockwise
+        float e[3][3], n[3];
+        sub(p[2], p[1], e[0]);
+        sub(p[0], p[2], e[1]);
+        sub(p[1], p[0], e[2]);
+        cross(e[2], e[0], n);   // = (p1-p0) x (p2-p0)
+        const float twice_area = norm(n);
+        face_area[f] = 0.5*twice_area;
+        edge_sum += norm(e[0]) + norm(e[1]) + norm(e[2]);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            float* g = &ops->gradient[9*f + 3*i];
+            if ( twice_area > 0.0f )
+            {
+                float un[3] = { n[0]/twice_area, n[1]/twice_area, n[2]/twice_area };
+                cross(un, e[i], g);
+                g[0] /= twice_area; g[1] /= twice_area; g[2] /= twice_area;
+            }
+            else
+                g[0] = g[1] = g[2] = 0.0f;
+
+            /// angle at corner i lies between the two other edges
+            const float* a = e[(i+1)%3];
+            const float* b = e[(i+2)%3];
+            const float  c = twice_area > 0.0f ? -dot(a, b)/twice_area : 0.0f;
+            ops->cotan[3*f+i] = c;
+
+            /// 0.5 cot at corner i couples the two other vertices
+            const unsigned int j = v[(i+1)%3], k = v[(i+2)%3];
+            const double w = 0.5*c;
+            stiffness[12*f + 4*i    ] = Triplet(j, j,  w);
+            stiffness[12*f + 4*i + 1] = Triplet(k, k,  w);
+            stiffness[12*f + 4*i + 2] = Triplet(j, k, -w);
+            stiffness[12*f + 4*i + 3] = Triplet(k, j, -w);
+        }
+    }
+
+    /// lumped mass: a third of each incident face
+    std::vector<Triplet> mass(_n_vertices);
+    std::vector<double>  vertex_area(_n_vertices, 0.0);
+    for (size_t f = 0; f < _n_faces; ++f)
+        for (int i = 0; i < 3; ++i)
+            vertex_area[ops->triangles[3*f+i]] += face_area[f]/3.0;
+
+    /// Heat from one step of backward Euler decays like exp(-d/sqrt(t)); on
+    /// very fine meshes it would underflow doubles before reaching the far
+    /// side, so t never drops below (diagonal/400)^2
+    float lo[3] = {  std::numeric_limits<float>::max(),  std::numeric_limits<float>::max(),
+                     std::numeric_limits<float>::max() };
+    float hi[3] = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(),
+                    -std::numeric_limits<float>::max() };
+    for (size_t i = 0; i < _n_vertices; ++i)
+        for (int k = 0; k < 3; ++k)
+        {
+            lo[k] = std::min(lo[k], _points[3*i+k]);
+            hi[k] = std::max(hi[k], _points[3*i+k]);
+        }
+    float extent[3];
+    sub(hi, lo, extent);
+    const double diagonal = norm(extent);
+
+    const double h = edge_sum/(3.0*_n_faces);
+    const double t = std::max(_time_scale*h*h, (diagonal/400.0)*(diagonal/400.0));
+    double mean_area = 0.0;
+    for (size_t i = 0; i < _n_vertices; ++i)
+    {
+        /// isolated vertices keep the systems definite
+        if ( vertex_area[i] <= 0.0 )
+            vertex_area[i] = h*h*1e-3;
+        mean_area += vertex_area[i]/_n_vertices;
+        mass[i] = Triplet(i, i, vertex_area[i]);
+    }
+
+    const int n = static_cast<int>(_n_vertices);
+    SparseMatrix L(n, n), M(n, n);
+    L.setFromTriplets(stiffness.begin(), stiffness.end());
+    M.setFromTriplets(mass.begin(), mass.end());
+    std::vector<Triplet>().swap(stiffness);
+
+    /// heat: (M + tL) u = delta; Poisson: L phi = -div, made definite by a
+    /// tiny mass term that only shifts phi by a constant per component
+    SparseMatrix heat    = M + t*L;
+    SparseMatrix poisson = L + (1e-8/mean_area)*M;
+
+    ops->heat.compute(heat);
+    if ( ops->heat.info() == Eigen::Success )
+        ops->poisson.compute(poisson);
+    if ( ops->heat.info() != Eigen::Success || ops->poisson.info() != Eigen::Success )
+    {
+        delete ops;
+        return false;
+    }
+
+    ops->delta      = Eigen::VectorXd::Zero(n);
+    ops->divergence = Eigen::VectorXd::Zero(n);
+    ops_ = ops;
+
+    factor_seconds_ = seconds_since(start);
+    return true;
+}
+
+bool HeatGeodesics::distances(unsigned int _source, std::vector<float>& _distances)
+{
+    if ( !ops_ || _source >= ops_->n_vertices )
+        return false;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Operators& ops = *ops_;
+    const long nf = static_cast<long>(ops.n_faces);
+
+    /// 1. diffuse
+    ops.delta.setZero();
+    ops.delta[_source] = 1.0;
+    ops.u = ops.heat.solve(ops.delta);
+
+    /// 2. normalized negative gradient per face
+#pragma omp parallel for schedule(static)
+    for (long f = 0; f < nf; ++f)
+    {
+        const unsigned int* v = &ops.triangles[3*f];
+        const float*        g = &ops.gradient[9*f];
+        /// u decays exponentially away from the source, far below float range
+        double grad[3] = { 0.0, 0.0, 0.0 };
+        for (int i = 0; i < 3; ++i)
+        {
+            const double ui = ops.u[v[i]];
+            grad[0] += ui*g[3*i]; grad[1] += ui*g[3*i+1]; grad[2] += ui*g[3*i+2];
+        }
+        const double l = std::sqrt(grad[0]*grad[0] + grad[1]*grad[1] + grad[2]*grad[2]);
+        float* x = &ops.field[3*f];
+        for (int k = 0; k < 3; ++k)
+            x[k] = l > 0.0 ? static_cast<float>(-grad[k]/l) : 0.0f;
+    }
+
+    /// 3. integrated divergence, per face in parallel then summed per vertex
+    std::vector<float> contribution(3*ops.n_faces);
+#pragma omp parallel for schedule(static)
+    for (long f = 0; f < nf; ++f)
+    {
+        const unsigned int* v = &ops.triangles[3*f];
+        const float*        x = &ops.field[3*f];
+        const float*        c = &ops.cotan[3*f];
+        for (int i = 0; i < 3; ++i)
+        {
+            const int j = (i+1)%3, k = (i+2)%3;
+            float e1[3], e2[3];
+            sub(&ops.points[3*v[j]], &ops.points[3*v[i]], e1);
+            sub(&ops.points[3*v[k]], &ops.points[3*v[i]], e2);
+            /// edge i->j is opposite corner k, edge i->k opposite corner j
+            contribution[3*f+i] = 0.5f*(c[k]*dot(e1, x) + c[j]*dot(e2, x));
+        }
+    }
+    ops.divergence.setZero();
+    for (size_t f = 0; f < ops.n_faces; ++f)
+        for (int i = 0; i < 3; ++i)
+            ops.divergence[ops.triangles[3*f+i]] += contribution[3*f+i];
+
+    /// 4. recover the distance, shifted to be 0 at the source
+    ops.phi = ops.poisson.solve(-ops.divergence);
+    const double shift = ops.phi[_source];
+
+    const long n = static_cast<long>(ops.n_vertices);
+    _distances.resize(ops.n_vertices);
+#pragma omp parallel for schedule(static)
+    for (long i = 0; i < n; ++i)
+        _distances[i] = static_cast<float>(std::max(0.0, ops.phi[i] - shift));
+
+    solve_seconds_ = seconds_since(start);
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef HEATGEODESICS_H
+#define HEATGEODESICS_H
+
+//== INCLUDES =================================================================
+#include <vector>
+#include <cstddef>
+
+//== CLASS DEFINITION =========================================================
+/// Geodesic distance on a triangle mesh by the heat method (Crane et al.,
+/// "Geodesics in Heat"): diffuse heat from the source for a short time,
+/// normalize its gradient and recover the distance from a Poisson problem.
+/// Both sparse systems, heat (M + tL) and Poisson (L), depend on the
+/// geometry only and are Cholesky factored once; each query is two
+/// back-substitutions plus a parallel gradient/divergence pass.
+class HeatGeodesics
+{
+public:
+    HeatGeodesics();
+    ~HeatGeodesics();
+
+    /// Assemble cotangent Laplacian L and lumped mass M of the mesh given by
+    /// _points (3 floats per vertex) and _triangles (3 indices per face), and
+    /// factor both systems. The time step is _time_scale times the squared
+    /// mean edge length, but at least (diagonal/400)^2 so the heat does not
+    /// underflow on very fine meshes. False if a factorization fails.
+    bool factor(const float* _points, size_t _n_vertices,
+                const unsigned int* _triangles, size_t _n_faces,
+                double _time_scale=1.0);
+
+    bool   factored() const { return ops_ != 0; }
+    size_t n_vertices() const;
+    void   clear();
+
+    /// distance of every vertex to vertex _source, 0 at the source
+    bool distances(unsigned int _source, std::vector<float>& _distances);
+
+    /// wall clock seconds of the last factor() and distances() calls
+    double factor_seconds() const { return factor_seconds_; }
+    double solve_seconds()  const { return solve_seconds_; }
+
+private:
+    /// Eigen types stay in the .cpp
+    struct Operators;
+    Operators* ops_;
+
+    double factor_seconds_, solve_seconds_;
+
+private:
+    HeatGeodesics(const HeatGeodesics&);
+    HeatGeodesics& operator=(const HeatGeodesics&);
+};
+
+//=============================================================================
+#endif // HEATGEODESICS_H defined
+//=============================================================================
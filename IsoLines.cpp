@@ -0,0 +1,99 @@
+//== INCLUDES =================================================================
+#include <algorithm>
+
+#include "IsoLines.h"
+
+//== IMPLEMENTATION ==========================================================
+/// faces per parallel block
+static const size_t block_size = 4096;
+
+void even_levels(float _lo, float _hi, int _n, std::vector<float>& _levels)
+{
+    _levels.resize(std::max(_n, 0));
+    for (int i = 0; i < _n; ++i)
+        _levels[i] = _lo + (_hi-_lo)*(i+1)/(_n+1);
+}
+
+/// levels crossing a face with the given values
+static inline void crossing_levels(const std::vector<float>& _levels, const float* _v,
+                                   size_t& _first, size_t& _last)
+{
+    const float lo = std::min(_v[0], std::min(_v[1], _v[2]));
+    const float hi = std::max(_v[0], std::max(_v[1], _v[2]));
+    _first = std::upper_bound(_levels.begin(), _levels.end(), lo) - _levels.begin();
+    _last  = std::upper_bound(_levels.begin(), _levels.end(), hi) - _levels.begin();
+}
+
+/// point where the field crosses _level on edge (_a,_b), interpolated from
+/// the lower vertex index
+static inline void crossing(const float* _points, const float* _values,
+                            unsigned int _a, unsigned int _b, float _level, float* _out)
+{
+    if ( _a > _b )
+        std::swap(_a, _b);
+    const float va = _values[_a], vb = _values[_b];
+    const float t = vb != va ? (_level-va)/(vb-va) : 0.5f;
+    for (int k = 0; k < 3; ++k)
+        _out[k] = _points[3*_a+k] + t*(_points[3*_b+k] - _points[3*_a+k]);
+}
+
+void extract_isolines(const float* _points, const float* _values,
+                      const unsigned int* _triangles, size_t _n_faces,
+                      const std::vector<float>& _levels, std::vector<float>& _segments)
+{
+    _segments.clear();
+    if ( _levels.empty() || !_n_faces )
+        return;
+
+    const long n_blocks = static_cast<long>((_n_faces + block_size-1)/block_size);
+    std::vector<size_t> offsets(n_blocks+1, 0);
+
+    /// segments per block, then their prefix sum
+#pragma omp parallel for schedule(dynamic, 4)
+    for (long b = 0; b < n_blocks; ++b)
+    {
+        const size_t end = std::min(_n_faces, (b+1)*block_size);
+        size_t count = 0;
+        for (size_t f = b*block_size; f < end; ++f)
+        {
+            const unsigned int* t = &_triangles[3*f];
+            const float v[3] = { _values[t[0]], _values[t[1]], _values[t[2]] };
+            size_t first, last;
+            crossing_levels(_levels, v, first, last);
+            count += last-first;
+        }
+        offsets[b+1] = count;
+    }
+    for (long b = 0; b < n_blocks; ++b)
+        offsets[b+1] += offsets[b];
+
+    _segments.resize(6*offsets[n_blocks]);
+
+#pragma omp parallel for schedule(dynamic, 4)
+    for (long b = 0; b < n_blocks; ++b)
+    {
+        const size_t end = std::min(_n_faces, (b+1)*block_size);
+        float* out = _segments.empty() ? 0 : &_segments[6*offsets[b]];
+        for (size_t f = b*block_size; f < end; ++f)
+        {
+            const unsigned int* t = &_triangles[3*f];
+            const float v[3] = { _values[t[0]], _values[t[1]], _values[t[2]] };
+            size_t first, last;
+            crossing_levels(_levels, v, first, last);
+
+            for (size_t l = first; l < last; ++l)
+            {
+                /// the two edges whose ends lie on different sides
+                const float level = _levels[l];
+                int found = 0;
+                for (int i = 0; i < 3 && found < 2; ++i)
+                {
+                    const int j = (i+1)%3;
+                    if ( (v[i] >= level) != (v[j] >= level) )
+                        crossing(_points, _values, t[i], t[j], level, out + 3*found++);
+                }
+                out += 6;
+            }
+        }
+    }
+}
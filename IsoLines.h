@@ -0,0 +1,27 @@
+#ifndef ISOLINES_H
+#define ISOLINES_H
+
+//== INCLUDES =================================================================
+#include <vector>
+#include <cstddef>
+
+//== FUNCTIONS ================================================================
+/// Level sets of a per-vertex scalar field, linear over each triangle. A
+/// vertex counts as above a level if its value is >= the level, so a face
+/// holds one segment per level in (min,max] of its three values. Crossings
+/// are interpolated along each edge in the same direction from both sides,
+/// which makes segments of neighboring faces meet exactly.
+
+/// _n levels evenly spaced strictly inside (_lo,_hi)
+void even_levels(float _lo, float _hi, int _n, std::vector<float>& _levels);
+
+/// Segments of all _levels (sorted ascending) as 6 floats each, the two end
+/// points. _points: 3 floats per vertex, _values: 1 per vertex, _triangles:
+/// 3 indices per face. Faces are counted, then filled, in parallel blocks.
+void extract_isolines(const float* _points, const float* _values,
+                      const unsigned int* _triangles, size_t _n_faces,
+                      const std::vector<float>& _levels, std::vector<float>& _segments);
+
+//=============================================================================
+#endif // ISOLINES_H defined
+//=============================================================================
@@ -0,0 +1,111 @@
+//== INCLUDES =================================================================
+#include <QMenu>
+#include <QMouseEvent>
+
+#include "LinkedView.h"
+#include "TCViewer.h"
+
+//== IMPLEMENTATION ==========================================================
+/// draw modes offered by the context menu: label, mode
+static const char* const view_modes[][2] = {
+    { "Smooth",             "Smooth" },
+    { "Flat",               "Flat" },
+    { "Wireframe",          "Wireframe" },
+    { "Points",             "Points" },
+    { "Hidden-Line",        "Hidden-Line" },
+    { "Valence",            "Valence" },
+    { "Gaussian Curvature", "GaussianCurvature" },
+    { "Mean Curvature",     "MeanCurvature" },
+    { "Geodesic Distance",  "Geodesic" },
+    { "Components",         "Components" },
+    { "Distance",           "Distance" }
+};
+
+LinkedView::LinkedView(TCViewer* _source, const std::string& _mode, QWidget* _parent)
+    : QGLViewer(_parent, _source),
+      source_(_source),
+      mode_(_mode),
+      syncing_(false)
+{
+    connect(source_->camera()->frame(), SIGNAL(modified()), this, SLOT(follow_source()));
+    connect(camera()->frame(), SIGNAL(modified()), this, SLOT(lead_source()));
+    connect(source_, SIGNAL(frame_drawn()), this, SLOT(update()));
+    follow_source();
+}
+
+void LinkedView::set_mode(const std::string& _mode)
+{
+    mode_ = _mode;
+    update();
+}
+
+void LinkedView::init()
+{
+    /// lights, material and fog are per context
+    source_->setup_gl_state();
+    setMouseBindingDescription(Qt::ControlModifier, Qt::MiddleButton, "Choose Render Mode", true);
+}
+
+void LinkedView::draw()
+{
+    glFogf(GL_FOG_START, 1.5*sceneRadius());
+    glFogf(GL_FOG_END,   3.0*sceneRadius());
+
+    source_->draw_as(mode_);
+
+    glDisable(GL_LIGHTING);
+    glColor3f(1.0f, 1.0f, 1.0f);
+    drawText(10, height()-10, QString::fromStdString(mode_));
+}
+
+void LinkedView::mousePressEvent(QMouseEvent* _e)
+{
+    if ( _e->button() == Qt::MiddleButton && _e->modifiers() == Qt::ControlModifier )
+    {
+        QMenu menu(this);
+        for (size_t i = 0; i < sizeof(view_modes)/sizeof(view_modes[0]); ++i)
+        {
+            QAction* action = menu.addAction(tr(view_modes[i][0]));
+            action->setCheckable(true);
+            action->setChecked(mode_ == view_modes[i][1]);
+            action->setData(QString(view_modes[i][1]));
+        }
+        QAction* chosen = menu.exec(_e->globalPos());
+        if ( chosen )
+            set_mode(chosen->data().toString().toStdString());
+    }
+    else
+        QGLViewer::mousePressEvent(_e);
+}
+
+//-----------------------------------------------------------------------------
+void LinkedView::follow_source()
+{
+    if ( syncing_ )
+        return;
+    syncing_ = true;
+
+    /// scene bounds change with every loaded mesh
+    setSceneRadius(source_->sceneRadius());
+    setSceneCenter(source_->sceneCenter());
+    camera()->setFieldOfView(source_->camera()->fieldOfView());
+    camera()->frame()->setPosition(source_->camera()->frame()->position());
+    camera()->frame()->setOrientation(source_->camera()->frame()->orientation());
+
+    syncing_ = false;
+    update();
+}
+
+void LinkedView::lead_source()
+{
+    if ( syncing_ )
+        return;
+    syncing_ = true;
+
+    /// the other views follow through the source's frame
+    source_->camera()->frame()->setPosition(camera()->frame()->position());
+    source_->camera()->frame()->setOrientation(camera()->frame()->orientation());
+    source_->request_redraw(false);
+
+    syncing_ = false;
+}
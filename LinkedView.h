@@ -0,0 +1,44 @@
+#ifndef LINKEDVIEW_H
+#define LINKEDVIEW_H
+
+//== INCLUDES =================================================================
+#include <string>
+
+#include <QGLViewer/qglviewer.h>
+
+class TCViewer;
+
+//== CLASS DEFINITION =========================================================
+/// Additional viewport on the mesh of a TCViewer. The GL context is shared
+/// with the source viewer, so its vertex and index buffers, textures and
+/// shaders are drawn directly: a view adds no mesh data, only a camera and
+/// a draw mode. The cameras of all views and the source stay in sync.
+class LinkedView : public QGLViewer
+{
+    Q_OBJECT
+
+public:
+    LinkedView(TCViewer* _source, const std::string& _mode, QWidget* _parent=0);
+
+    const std::string& mode() const { return mode_; }
+    void set_mode(const std::string& _mode);
+
+protected:
+    virtual void init();
+    virtual void draw();
+    /// ctrl+middle click chooses the draw mode of this view
+    virtual void mousePressEvent(QMouseEvent* _e);
+
+private slots:
+    void follow_source();
+    void lead_source();
+
+private:
+    TCViewer*   source_;
+    std::string mode_;
+    bool        syncing_;
+};
+
+//=============================================================================
+#endif // LINKEDVIEW_H defined
+//=============================================================================
@@ -1,15 +1,24 @@
 #include <QtGui>
+#include <QGridLayout>
+#include <QToolBar>
+#include <QSlider>
+#include <QLabel>
 #include <iostream>
+#include <algorithm>
 
 #include "MainWindow.h"
 #include "TCViewer.h"
+#include "LinkedView.h"
 
 MainWindow::MainWindow()
+    : sequenceBar(0), sequenceSlider(0), sequenceLabel(0), viewer(0), viewGrid(0)
 {
 }
 
 void MainWindow::createActions(TCViewer* viewer)
 {
+    this->viewer = viewer;
+
     openAct= new QAction(tr("&Open Mesh..."), this);
     openAct->setShortcut(tr("Ctrl+O"));
     openAct->setStatusTip(tr("Open a mesh file"));
@@ -20,6 +29,36 @@ void MainWindow::createActions(TCViewer* viewer)
     texAct->setStatusTip(tr("Open a texture file"));
     connect(texAct, SIGNAL(triggered()), viewer, SLOT(query_open_texture_file()));
 
+    referenceAct = new QAction(tr("Open &Reference Mesh..."), this);
+    referenceAct->setStatusTip(tr("Load a mesh to measure distances to"));
+    connect(referenceAct, SIGNAL(triggered()), viewer, SLOT(query_open_reference_file()));
+
+    sequenceAct = new QAction(tr("Open Scalar &Sequence..."), this);
+    sequenceAct->setStatusTip(tr("Stream per-vertex float32 frames from a file and play them"));
+    connect(sequenceAct, SIGNAL(triggered()), viewer, SLOT(query_open_scalar_sequence()));
+
+    animationAct = new QAction(tr("Open Vertex &Animation..."), this);
+    animationAct->setStatusTip(tr("Stream per-frame vertex positions of the current mesh from a file and play them"));
+    connect(animationAct, SIGNAL(triggered()), viewer, SLOT(query_open_animation()));
+
+    watchAct = new QAction(tr("&Watch Mesh File"), this);
+    watchAct->setCheckable(true);
+    watchAct->setStatusTip(tr("Reload the mesh whenever its file changes on disk"));
+    connect(watchAct, SIGNAL(toggled(bool)), viewer, SLOT(set_watch_file(bool)));
+
+    viewOnlyAct = new QAction(tr("&View-Only Loading"), this);
+    viewOnlyAct->setCheckable(true);
+    viewOnlyAct->setStatusTip(tr("Keep only GPU buffers of the next loaded meshes to save memory"));
+    connect(viewOnlyAct, SIGNAL(toggled(bool)), viewer, SLOT(set_view_only(bool)));
+
+    exportAct = new QAction(tr("&Export Turntable..."), this);
+    exportAct->setStatusTip(tr("Render a camera orbit offscreen into PNG frames"));
+    connect(exportAct, SIGNAL(triggered()), viewer, SLOT(query_export_animation()));
+
+    smoothAct = new QAction(tr("&Smooth Mesh..."), this);
+    smoothAct->setStatusTip(tr("Laplacian or Taubin smoothing with a live preview of every iteration"));
+    connect(smoothAct, SIGNAL(triggered()), viewer, SLOT(query_smooth()));
+
     aboutAct = new QAction(tr("&About"), this);
     aboutAct->setStatusTip(tr("Show the application's About box"));
     connect(aboutAct, SIGNAL(triggered()), viewer, SLOT(about()));
@@ -77,6 +116,98 @@ void MainWindow::createActions(TCViewer* viewer)
     MeanCurvatureAct->setStatusTip(tr("View Mean Curvature"));
     connect(MeanCurvatureAct, SIGNAL(triggered()), viewer, SLOT(MeanCurvature()));
 
+    GeodesicAct = new QAction(tr("Geo&desic Distance"), this);
+    GeodesicAct->setCheckable(true);
+    GeodesicAct->setShortcut(tr("Shift+D"));
+    GeodesicAct->setStatusTip(tr("View Geodesic Distance, shift+click picks the source vertex"));
+    connect(GeodesicAct, SIGNAL(triggered()), viewer, SLOT(Geodesic()));
+
+    ComponentsAct = new QAction(tr("&Connected Components"), this);
+    ComponentsAct->setCheckable(true);
+    ComponentsAct->setShortcut(tr("Shift+T"));
+    ComponentsAct->setStatusTip(tr("Color each connected component"));
+    connect(ComponentsAct, SIGNAL(triggered()), viewer, SLOT(Components()));
+
+    DistanceAct = new QAction(tr("Distance to &Reference"), this);
+    DistanceAct->setCheckable(true);
+    DistanceAct->setShortcut(tr("Shift+R"));
+    DistanceAct->setStatusTip(tr("View the distance of each vertex to the reference mesh"));
+    connect(DistanceAct, SIGNAL(triggered()), viewer, SLOT(Distance()));
+
+    SequenceAct = new QAction(tr("Scalar Se&quence"), this);
+    SequenceAct->setCheckable(true);
+    SequenceAct->setShortcut(tr("Shift+Q"));
+    SequenceAct->setStatusTip(tr("View the current frame of the scalar sequence"));
+    connect(SequenceAct, SIGNAL(triggered()), viewer, SLOT(Sequence()));
+
+    playSequenceAct = new QAction(tr("&Play Sequence"), this);
+    playSequenceAct->setCheckable(true);
+    playSequenceAct->setEnabled(false);
+    playSequenceAct->setShortcut(tr("Ctrl+P"));
+    playSequenceAct->setStatusTip(tr("Play or pause the scalar sequence and vertex animation, comma and period step single frames"));
+    connect(playSequenceAct, SIGNAL(toggled(bool)), viewer, SLOT(set_sequence_playing(bool)));
+    connect(viewer, SIGNAL(scalar_sequence_opened()), this, SLOT(scalar_sequence_opened()));
+    connect(viewer, SIGNAL(sequence_length_changed(int)), this, SLOT(sequence_length_changed(int)));
+    connect(viewer, SIGNAL(sequence_frame_changed(int)), this, SLOT(sequence_frame_changed(int)));
+
+    isolinesAct = new QAction(tr("&Isolines"), this);
+    isolinesAct->setCheckable(true);
+    isolinesAct->setShortcut(tr("Shift+I"));
+    isolinesAct->setStatusTip(tr("Overlay level lines of the last scalar field shown"));
+    connect(isolinesAct, SIGNAL(toggled(bool)), viewer, SLOT(set_isolines(bool)));
+
+    isolineLevelsAct = new QAction(tr("Isoline &Levels..."), this);
+    isolineLevelsAct->setStatusTip(tr("Number of evenly spaced isolines or their values"));
+    connect(isolineLevelsAct, SIGNAL(triggered()), viewer, SLOT(query_isoline_levels()));
+
+    occlusionAct = new QAction(tr("Ambient &Occlusion"), this);
+    occlusionAct->setCheckable(true);
+    occlusionAct->setShortcut(tr("Shift+O"));
+    occlusionAct->setStatusTip(tr("Bake ambient occlusion on every load and darken Smooth shading by it"));
+    connect(occlusionAct, SIGNAL(toggled(bool)), viewer, SLOT(set_ambient_occlusion(bool)));
+
+    occlusionRadiusAct = new QAction(tr("Occlusion &Radius..."), this);
+    occlusionRadiusAct->setStatusTip(tr("Length of the occlusion rays"));
+    connect(occlusionRadiusAct, SIGNAL(triggered()), viewer, SLOT(query_occlusion_radius()));
+
+    clipPlaneAct = new QAction(tr("Add &Clipping Plane"), this);
+    clipPlaneAct->setShortcut(tr("Ctrl+K"));
+    clipPlaneAct->setStatusTip(tr("Cut the mesh open and outline the cross-section, ctrl+drag moves the plane"));
+    connect(clipPlaneAct, SIGNAL(triggered()), viewer, SLOT(add_clip_plane()));
+
+    clearClipPlanesAct = new QAction(tr("Remove Clipping Planes"), this);
+    clearClipPlanesAct->setShortcut(tr("Ctrl+Shift+K"));
+    clearClipPlanesAct->setStatusTip(tr("Remove all clipping planes"));
+    connect(clearClipPlanesAct, SIGNAL(triggered()), viewer, SLOT(clear_clip_planes()));
+
+    quantizeAct = new QAction(tr("&Quantized Vertices"), this);
+    quantizeAct->setCheckable(true);
+    quantizeAct->setStatusTip(tr("16-bit positions, octahedral normals and half-float texture coordinates on the GPU"));
+    connect(quantizeAct, SIGNAL(toggled(bool)), viewer, SLOT(set_quantized_vertices(bool)));
+
+    singleViewAct = new QAction(tr("Single View"), this);
+    singleViewAct->setCheckable(true);
+    singleViewAct->setShortcut(tr("Ctrl+1"));
+    connect(singleViewAct, SIGNAL(triggered()), this, SLOT(single_view()));
+
+    sideBySideAct = new QAction(tr("Side by Side"), this);
+    sideBySideAct->setCheckable(true);
+    sideBySideAct->setShortcut(tr("Ctrl+2"));
+    sideBySideAct->setStatusTip(tr("Second view with its own render mode and a linked camera"));
+    connect(sideBySideAct, SIGNAL(triggered()), this, SLOT(side_by_side()));
+
+    grid2x2Act = new QAction(tr("2x2 Grid"), this);
+    grid2x2Act->setCheckable(true);
+    grid2x2Act->setShortcut(tr("Ctrl+4"));
+    grid2x2Act->setStatusTip(tr("Four views with their own render modes and linked cameras"));
+    connect(grid2x2Act, SIGNAL(triggered()), this, SLOT(grid_2x2()));
+
+    viewCountGroup = new QActionGroup(this);
+    viewCountGroup->addAction(singleViewAct);
+    viewCountGroup->addAction(sideBySideAct);
+    viewCountGroup->addAction(grid2x2Act);
+    singleViewAct->setChecked(true);
+
     renderModeGroup = new QActionGroup(this);
     renderModeGroup->addAction(SmoothAct);
     renderModeGroup->addAction(FlatAct);
@@ -86,6 +217,10 @@ void MainWindow::createActions(TCViewer* viewer)
     renderModeGroup->addAction(ValenceAct);
     renderModeGroup->addAction(GaussianCurvatureAct);
     renderModeGroup->addAction(MeanCurvatureAct);
+    renderModeGroup->addAction(GeodesicAct);
+    renderModeGroup->addAction(ComponentsAct);
+    renderModeGroup->addAction(DistanceAct);
+    renderModeGroup->addAction(SequenceAct);
     SmoothAct->setChecked(true);
 }
 
@@ -94,6 +229,13 @@ void MainWindow::createMenus()
     fileMenu = menuBar()->addMenu(tr("&File"));
     fileMenu->addAction(openAct);
     fileMenu->addAction(texAct);
+    fileMenu->addAction(referenceAct);
+    fileMenu->addAction(sequenceAct);
+    fileMenu->addAction(animationAct);
+    fileMenu->addSeparator();
+    fileMenu->addAction(watchAct);
+    fileMenu->addAction(viewOnlyAct);
+    fileMenu->addAction(exportAct);
 
     renderMenu = menuBar()->addMenu(tr("&Render"));
     renderMenu->addAction(SmoothAct);
@@ -104,10 +246,45 @@ void MainWindow::createMenus()
     renderMenu->addAction(ValenceAct);
     renderMenu->addAction(GaussianCurvatureAct);
     renderMenu->addAction(MeanCurvatureAct);
+    renderMenu->addAction(GeodesicAct);
+    renderMenu->addAction(ComponentsAct);
+    renderMenu->addAction(DistanceAct);
+    renderMenu->addAction(SequenceAct);
+    renderMenu->addAction(playSequenceAct);
+    renderMenu->addSeparator();
+    renderMenu->addAction(isolinesAct);
+    renderMenu->addAction(isolineLevelsAct);
+    renderMenu->addSeparator();
+    renderMenu->addAction(occlusionAct);
+    renderMenu->addAction(occlusionRadiusAct);
+    renderMenu->addSeparator();
+    renderMenu->addAction(clipPlaneAct);
+    renderMenu->addAction(clearClipPlanesAct);
+    renderMenu->addSeparator();
+    renderMenu->addAction(quantizeAct);
+    renderMenu->addSeparator();
+    renderMenu->addAction(singleViewAct);
+    renderMenu->addAction(sideBySideAct);
+    renderMenu->addAction(grid2x2Act);
+
+    toolsMenu = menuBar()->addMenu(tr("&Tools"));
+    toolsMenu->addAction(smoothAct);
 
     helpMenu = menuBar()->addMenu(tr("&Help"));
     helpMenu->addAction(aboutAct);
     helpMenu->addAction(aboutQtAct);
+
+    /// play button and frame slider, shown while a sequence is open
+    sequenceBar = new QToolBar(tr("Sequence"), this);
+    sequenceBar->addAction(playSequenceAct);
+    sequenceSlider = new QSlider(Qt::Horizontal, sequenceBar);
+    sequenceSlider->setStatusTip(tr("Scrub through the scalar sequence"));
+    connect(sequenceSlider, SIGNAL(valueChanged(int)), viewer, SLOT(set_sequence_frame(int)));
+    sequenceBar->addWidget(sequenceSlider);
+    sequenceLabel = new QLabel(sequenceBar);
+    sequenceBar->addWidget(sequenceLabel);
+    addToolBar(Qt::BottomToolBarArea, sequenceBar);
+    sequenceBar->hide();
 }
 
 void MainWindow::mousePressEvent(QMouseEvent *event)
@@ -123,6 +300,10 @@ void MainWindow::mousePressEvent(QMouseEvent *event)
         menu.addAction(ValenceAct);
         menu.addAction(GaussianCurvatureAct);
         menu.addAction(MeanCurvatureAct);
+        menu.addAction(GeodesicAct);
+        menu.addAction(ComponentsAct);
+        menu.addAction(DistanceAct);
+        menu.addAction(SequenceAct);
         menu.exec(event->globalPos());
     }
     else {
@@ -130,3 +311,65 @@ void MainWindow::mousePressEvent(QMouseEvent *event)
     }
 }
 
+void MainWindow::set_view_count(int _n)
+{
+    if ( !viewer )
+        return;
+
+    /// the main viewer moves into a grid on first use
+    if ( !viewGrid )
+    {
+        QWidget* container = new QWidget;
+        viewGrid = new QGridLayout(container);
+        viewGrid->setContentsMargins(0, 0, 0, 0);
+        viewGrid->setSpacing(2);
+        takeCentralWidget();
+        viewGrid->addWidget(viewer, 0, 0);
+        setCentralWidget(container);
+    }
+
+    qDeleteAll(linkedViews);
+    linkedViews.clear();
+
+    /// the main view keeps its mode, the others start with the usual
+    /// companions; ctrl+middle click in a view changes its mode
+    static const char* const modes[] = { "MeanCurvature", "GaussianCurvature", "Wireframe" };
+    for (int i = 1; i < std::min(_n, 4); ++i)
+    {
+        LinkedView* view = new LinkedView(viewer, modes[i-1]);
+        viewGrid->addWidget(view, i/2, i%2);
+        linkedViews.append(view);
+    }
+}
+
+void MainWindow::scalar_sequence_opened()
+{
+    SequenceAct->setChecked(true);
+}
+
+void MainWindow::sequence_length_changed(int _n_frames)
+{
+    if ( !sequenceBar )
+        return;
+
+    /// a closed sequence stops playback, an opened one waits for play
+    playSequenceAct->setChecked(false);
+    playSequenceAct->setEnabled(_n_frames > 0);
+    sequenceSlider->blockSignals(true);
+    sequenceSlider->setRange(0, std::max(_n_frames-1, 0));
+    sequenceSlider->blockSignals(false);
+    sequenceBar->setVisible(_n_frames > 0);
+    sequence_frame_changed(sequenceSlider->value());
+}
+
+void MainWindow::sequence_frame_changed(int _frame)
+{
+    if ( !sequenceBar )
+        return;
+
+    /// moved by playback, not by the user: no feedback into the viewer
+    sequenceSlider->blockSignals(true);
+    sequenceSlider->setValue(_frame);
+    sequenceSlider->blockSignals(false);
+    sequenceLabel->setText(tr(" %1 / %2 ").arg(_frame+1).arg(sequenceSlider->maximum()+1));
+}
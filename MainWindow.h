@@ -4,12 +4,17 @@
 #include <QMainWindow>
 #include <QMenu>
 #include <QMenuBar>
+#include <QList>
 
 class QAction;
 class QActionGroup;
 class QLabel;
 class QMenu;
+class QGridLayout;
+class QSlider;
+class QToolBar;
 class TCViewer;
+class LinkedView;
 
 class MainWindow : public QMainWindow
 {
@@ -22,12 +27,33 @@ public:
     void createActions(TCViewer *viewer);
     void createMenus();
 
+public slots:
+    /// one, two side by side or 2x2 views with linked cameras
+    void set_view_count(int _n);
+    void single_view() { set_view_count(1); }
+    void side_by_side() { set_view_count(2); }
+    void grid_2x2() { set_view_count(4); }
+
+    /// the sequence bar follows the viewer's sequences
+    void scalar_sequence_opened();
+    void sequence_length_changed(int _n_frames);
+    void sequence_frame_changed(int _frame);
+
+public:
+
     QMenu *fileMenu;
     QMenu *renderMenu;
+    QMenu *toolsMenu;
     QMenu *helpMenu;
     QActionGroup *renderModeGroup;
     QAction *openAct;
     QAction *texAct;
+    QAction *referenceAct;
+    QAction *sequenceAct;
+    QAction *animationAct;
+    QAction *watchAct;
+    QAction *viewOnlyAct;
+    QAction *exportAct;
     QAction *exitAct;
     QAction *SmoothAct;
     QAction *FlatAct;
@@ -37,9 +63,34 @@ public:
     QAction *ValenceAct;
     QAction *GaussianCurvatureAct;
     QAction *MeanCurvatureAct;
+    QAction *GeodesicAct;
+    QAction *ComponentsAct;
+    QAction *DistanceAct;
+    QAction *SequenceAct;
+    QAction *playSequenceAct;
+    QAction *isolinesAct;
+    QAction *isolineLevelsAct;
+    QAction *occlusionAct;
+    QAction *occlusionRadiusAct;
+    QAction *clipPlaneAct;
+    QAction *clearClipPlanesAct;
+    QAction *quantizeAct;
+    QActionGroup *viewCountGroup;
+    QAction *singleViewAct;
+    QAction *sideBySideAct;
+    QAction *grid2x2Act;
+    QAction *smoothAct;
     QAction *aboutAct;
     QAction *aboutQtAct;
     QLabel *infoLabel;
+    QToolBar *sequenceBar;
+    QSlider *sequenceSlider;
+    QLabel *sequenceLabel;
+
+private:
+    TCViewer           *viewer;
+    QGridLayout        *viewGrid;
+    QList<LinkedView*>  linkedViews;
 
 protected:
     virtual void mousePressEvent (QMouseEvent * event);
@@ -0,0 +1,115 @@
+//== INCLUDES =================================================================
+#include <cstdio>
+#include <iomanip>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+#include <OpenMesh/Core/Mesh/Handles.hh>
+
+#include "MemoryReport.h"
+
+//== IMPLEMENTATION ==========================================================
+static void add_properties(MemoryReport& _report, const std::string& _group,
+                           OpenMesh::BaseKernel::const_prop_iterator _begin,
+                           OpenMesh::BaseKernel::const_prop_iterator _end)
+{
+    for (; _begin != _end; ++_begin)
+        if ( *_begin )
+            _report.add(_group, (*_begin)->name(), (*_begin)->size_of());
+}
+
+void MemoryReport::add(const std::string& _group, const std::string& _name, size_t _bytes)
+{
+    Entry e;
+    e.group = _group;
+    e.name  = _name;
+    e.bytes = _bytes;
+    entries_.push_back(e);
+}
+
+void MemoryReport::add_mesh(const OpenMesh::BaseKernel& _mesh, size_t _n_vertices,
+                            size_t _n_halfedges, size_t _n_faces)
+{
+    /// array kernel items: outgoing halfedge per vertex and face,
+    /// face/to-vertex/next/prev per halfedge
+    add("connectivity", "vertices",  _n_vertices*sizeof(OpenMesh::HalfedgeHandle));
+    add("connectivity", "halfedges", _n_halfedges*4*sizeof(OpenMesh::VertexHandle));
+    add("connectivity", "faces",     _n_faces*sizeof(OpenMesh::HalfedgeHandle));
+
+    add_properties(*this, "vertex property",   _mesh.vprops_begin(), _mesh.vprops_end());
+    add_properties(*this, "halfedge property", _mesh.hprops_begin(), _mesh.hprops_end());
+    add_properties(*this, "edge property",     _mesh.eprops_begin(), _mesh.eprops_end());
+    add_properties(*this, "face property",     _mesh.fprops_begin(), _mesh.fprops_end());
+}
+
+size_t MemoryReport::total(const std::string& _group) const
+{
+    size_t sum = 0;
+    for (size_t i = 0; i < entries_.size(); ++i)
+        if ( _group.empty() || entries_[i].group == _group )
+            sum += entries_[i].bytes;
+    return sum;
+}
+
+void MemoryReport::print(std::ostream& _os) const
+{
+    const double MB = 1024.0*1024.0;
+    std::ios::fmtflags flags = _os.flags();
+    _os << std::fixed << std::setprecision(2);
+
+    std::string group;
+    for (size_t i = 0; i < entries_.size(); ++i)
+    {
+        if ( entries_[i].group != group )
+        {
+            group = entries_[i].group;
+            _os << "  " << std::left << std::setw(20) << group
+                << std::right << std::setw(10) << total(group)/MB << " MB\n";
+        }
+        _os << "    " << std::left << std::setw(28) << entries_[i].name
+            << std::right << std::setw(10) << entries_[i].bytes/MB << " MB\n";
+    }
+
+    _os << "  " << std::left << std::setw(20) << "total accounted"
+        << std::right << std::setw(10) << total()/MB << " MB\n";
+    _os << "  " << std::left << std::setw(20) << "process RSS"
+        << std::right << std::setw(10) << current_rss()/MB << " MB (peak "
+        << peak_rss()/MB << " MB)" << std::endl;
+
+    _os.flags(flags);
+}
+
+size_t MemoryReport::current_rss()
+{
+#if defined(__linux__)
+    long pages = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if ( !f )
+        return 0;
+    if ( fscanf(f, "%ld %ld", &pages, &resident) != 2 )
+        resident = 0;
+    fclose(f);
+    return static_cast<size_t>(resident)*sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+size_t MemoryReport::peak_rss()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if ( getrusage(RUSAGE_SELF, &usage) != 0 )
+        return 0;
+#if defined(__APPLE__)
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss)*1024;
+#endif
+#else
+    return 0;
+#endif
+}
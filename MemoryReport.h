@@ -0,0 +1,42 @@
+#ifndef MEMORYREPORT_H
+#define MEMORYREPORT_H
+
+//== INCLUDES =================================================================
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstddef>
+
+#include <OpenMesh/Core/Mesh/BaseKernel.hh>
+
+//== CLASS DEFINITION =========================================================
+/// Table of memory consumers, grouped as e.g. "vertex property", "derived" or
+/// "GPU", printed with per-group totals and the process resident set size.
+class MemoryReport
+{
+public:
+    void add(const std::string& _group, const std::string& _name, size_t _bytes);
+
+    /// connectivity arrays and every vertex/halfedge/edge/face property
+    void add_mesh(const OpenMesh::BaseKernel& _mesh, size_t _n_vertices,
+                  size_t _n_halfedges, size_t _n_faces);
+
+    size_t total(const std::string& _group="") const;
+    void   print(std::ostream& _os) const;
+
+    /// resident set size of this process now and at its peak, 0 if unknown
+    static size_t current_rss();
+    static size_t peak_rss();
+
+private:
+    struct Entry
+    {
+        std::string group, name;
+        size_t      bytes;
+    };
+    std::vector<Entry> entries_;
+};
+
+//=============================================================================
+#endif // MEMORYREPORT_H defined
+//=============================================================================
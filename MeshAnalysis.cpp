@@ -0,0 +1,113 @@
+//== INCLUDES =================================================================
+#include <cmath>
+
+#include "MeshAnalysis.h"
+
+//== IMPLEMENTATION ==========================================================
+typedef TCMesh::Point Point;
+
+static inline float cotan(const Point& _a, const Point& _b)
+{
+    float s = (_a % _b).norm();
+    return s > 1e-12f ? (_a | _b)/s : 0.0f;
+}
+
+static float gaussian_curvature(const TCMesh& _mesh, TCMesh::VertexHandle _vh)
+{
+    const Point& p = _mesh.point(_vh);
+    float angles = 0.0f, area = 0.0f;
+
+    for (TCMesh::ConstVertexOHalfedgeIter voh=_mesh.cvoh_iter(_vh); voh.is_valid(); ++voh)
+    {
+        if ( _mesh.is_boundary(*voh) )
+            continue;
+        Point e0 = _mesh.point(_mesh.to_vertex_handle(*voh)) - p;
+        Point e1 = _mesh.point(_mesh.from_vertex_handle(_mesh.prev_halfedge_handle(*voh))) - p;
+        float l = e0.norm()*e1.norm();
+        if ( l > 0.0f )
+            angles += std::acos(std::max(-1.0f, std::min(1.0f, (e0 | e1)/l)));
+        area += (e0 % e1).norm()/6.0f;
+    }
+
+    float deficit = (_mesh.is_boundary(_vh) ? float(M_PI) : 2.0f*float(M_PI)) - angles;
+    return area > 0.0f ? deficit/area : 0.0f;
+}
+
+static float mean_curvature(const TCMesh& _mesh, TCMesh::VertexHandle _vh)
+{
+    const Point& p = _mesh.point(_vh);
+    Point lap(0,0,0);
+    float area = 0.0f;
+
+    for (TCMesh::ConstVertexOHalfedgeIter voh=_mesh.cvoh_iter(_vh); voh.is_valid(); ++voh)
+    {
+        const Point& q = _mesh.point(_mesh.to_vertex_handle(*voh));
+        float w = 0.0f;
+
+        if ( !_mesh.is_boundary(*voh) )
+        {
+            const Point& o = _mesh.point(_mesh.to_vertex_handle(_mesh.next_halfedge_handle(*voh)));
+            w    += cotan(p-o, q-o);
+            area += ((q-p) % (o-p)).norm()/6.0f;
+        }
+        TCMesh::HalfedgeHandle opp = _mesh.opposite_halfedge_handle(*voh);
+        if ( !_mesh.is_boundary(opp) )
+        {
+            const Point& o = _mesh.point(_mesh.to_vertex_handle(_mesh.next_halfedge_handle(opp)));
+            w += cotan(p-o, q-o);
+        }
+        lap += w*(q-p);
+    }
+    if ( area <= 0.0f )
+        return 0.0f;
+
+    lap /= 4.0f*area;
+    float h = lap.norm();
+    if ( _mesh.has_vertex_normals() && (lap | _mesh.normal(_vh)) > 0.0f )
+        h = -h;
+    return h;
+}
+
+//-----------------------------------------------------------------------------
+void compute_valence(const TCMesh& _mesh, std::vector<float>& _values)
+{
+    const int n = static_cast<int>(_mesh.n_vertices());
+    _values.resize(n);
+
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; ++i)
+        _values[i] = static_cast<float>(_mesh.valence(TCMesh::VertexHandle(i)));
+}
+
+template <typename Kernel>
+static void evaluate(const TCMesh& _mesh, std::vector<float>& _values,
+                     const std::vector<unsigned int>* _vertices, Kernel _kernel)
+{
+    if ( _vertices )
+    {
+        const int n = static_cast<int>(_vertices->size());
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; ++i)
+            _values[(*_vertices)[i]] = _kernel(_mesh, TCMesh::VertexHandle((*_vertices)[i]));
+    }
+    else
+    {
+        const int n = static_cast<int>(_mesh.n_vertices());
+        _values.resize(n);
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; ++i)
+            _values[i] = _kernel(_mesh, TCMesh::VertexHandle(i));
+    }
+}
+
+void compute_gaussian_curvature(const TCMesh& _mesh, std::vector<float>& _values,
+                                const std::vector<unsigned int>* _vertices)
+{
+    evaluate(_mesh, _values, _vertices, gaussian_curvature);
+}
+
+void compute_mean_curvature(const TCMesh& _mesh, std::vector<float>& _values,
+                            const std::vector<unsigned int>* _vertices)
+{
+    evaluate(_mesh, _values, _vertices, mean_curvature);
+}
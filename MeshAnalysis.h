@@ -0,0 +1,28 @@
+#ifndef MESHANALYSIS_H
+#define MESHANALYSIS_H
+
+//== INCLUDES =================================================================
+#include <vector>
+
+#include "TCMesh.h"
+
+//== FUNCTIONS ================================================================
+/// Per-vertex scalar fields of a TCMesh, evaluated in parallel over vertices.
+/// With _vertices given, only those entries of an already sized _values are
+/// re-evaluated; otherwise _values is resized and filled completely.
+
+/// number of neighbors
+void compute_valence(const TCMesh& _mesh, std::vector<float>& _values);
+
+/// angle deficit over barycentric vertex area
+void compute_gaussian_curvature(const TCMesh& _mesh, std::vector<float>& _values,
+                                const std::vector<unsigned int>* _vertices=0);
+
+/// half the norm of the cotangent Laplace-Beltrami of the positions, negative
+/// where the surface bends away from the vertex normal
+void compute_mean_curvature(const TCMesh& _mesh, std::vector<float>& _values,
+                            const std::vector<unsigned int>* _vertices=0);
+
+//=============================================================================
+#endif // MESHANALYSIS_H defined
+//=============================================================================
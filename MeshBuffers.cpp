@@ -0,0 +1,249 @@
+//== INCLUDES =================================================================
+#include <algorithm>
+
+#include "MeshBuffers.h"
+#include "VertexSplit.h"
+
+//== IMPLEMENTATION ==========================================================
+void DirtyRanges::add(size_t _first, size_t _last)
+{
+    if (_first >= _last)
+        return;
+
+    ranges_.push_back(Range(_first, _last));
+    normalized_ = false;
+}
+
+void DirtyRanges::add_sorted(const std::vector<unsigned int>& _ids)
+{
+    /// collapse runs of consecutive ids while appending
+    size_t i = 0;
+    while (i < _ids.size())
+    {
+        size_t first = _ids[i], last = first+1;
+        for (++i; i < _ids.size() && _ids[i] <= last+merge_gap_; ++i)
+            last = std::max<size_t>(last, _ids[i]+1);
+        ranges_.push_back(Range(first, last));
+    }
+    normalized_ = false;
+}
+
+size_t DirtyRanges::n_elements()
+{
+    normalize();
+
+    size_t n = 0;
+    for (size_t i = 0; i < ranges_.size(); ++i)
+        n += ranges_[i].second - ranges_[i].first;
+    return n;
+}
+
+const std::vector<DirtyRanges::Range>& DirtyRanges::ranges()
+{
+    normalize();
+    return ranges_;
+}
+
+void DirtyRanges::normalize()
+{
+    if (normalized_)
+        return;
+
+    std::sort(ranges_.begin(), ranges_.end());
+
+    size_t n = 0;
+    for (size_t i = 1; i < ranges_.size(); ++i)
+    {
+        if (ranges_[i].first <= ranges_[n].second+merge_gap_)
+            ranges_[n].second = std::max(ranges_[n].second, ranges_[i].second);
+        else
+            ranges_[++n] = ranges_[i];
+    }
+    if (!ranges_.empty())
+        ranges_.resize(n+1);
+
+    normalized_ = true;
+}
+
+
+//-----------------------------------------------------------------------------
+MeshBuffers::MeshBuffers()
+    : split_(0)
+{
+    slots_[Index].buffer = QGLBuffer(QGLBuffer::IndexBuffer);
+}
+
+MeshBuffers::~MeshBuffers()
+{
+    /// buffers die with the GL context of the owning widget
+}
+
+void MeshBuffers::upload(Attribute _attr, const void* _data, size_t _elem_size, size_t _n_elems)
+{
+    Slot& s = slots_[_attr];
+    s.source = -1;
+    s.offset = 0;
+
+    /// one element per mesh vertex goes to each of its render vertices
+    if (split(_attr) && _n_elems == split_->n_vertices())
+    {
+        _n_elems = split_->n_render_vertices();
+        if (_data)
+        {
+            staging_.resize(_n_elems*_elem_size);
+            split_->gather(_data, _elem_size, 0, _n_elems, &staging_[0]);
+            _data = &staging_[0];
+        }
+    }
+
+    if (!s.buffer.isCreated())
+    {
+        s.buffer.setUsagePattern(_attr == Index ? QGLBuffer::StaticDraw : QGLBuffer::DynamicDraw);
+        if (!s.buffer.create())
+            return;
+    }
+
+    s.buffer.bind();
+    s.buffer.allocate(_data, static_cast<int>(_elem_size*_n_elems));
+    s.buffer.release();
+
+    s.elem_size = _elem_size;
+    s.n_elems   = _n_elems;
+    s.dirty.clear();
+    std::vector<char>().swap(staging_);
+}
+
+bool MeshBuffers::split(Attribute _attr) const
+{
+    return split_ && _attr <= Occlusion && split_->n_render_vertices() != split_->n_vertices();
+}
+
+void MeshBuffers::alias(Attribute _attr, Attribute _source, size_t _offset)
+{
+    clear(_attr);
+    Slot& s = slots_[_attr];
+    s.source  = _source;
+    s.offset  = _offset;
+    s.n_elems = slots_[_source].n_elems;
+}
+
+void MeshBuffers::mark_dirty(Attribute _attr, size_t _first, size_t _last)
+{
+    Slot& s = slots_[_attr];
+    if (split(_attr))
+    {
+        _last = std::min(_last, split_->n_vertices());
+        if (_first < _last)
+            s.dirty.add(split_->first(_first), split_->first(_last));
+        return;
+    }
+    s.dirty.add(_first, std::min(_last, s.n_elems));
+}
+
+void MeshBuffers::mark_dirty(Attribute _attr, const std::vector<unsigned int>& _ids)
+{
+    Slot& s = slots_[_attr];
+    if (split(_attr))
+    {
+        /// the render vertices of a mesh vertex are contiguous
+        for (size_t i = 0; i < _ids.size() && _ids[i] < split_->n_vertices(); ++i)
+            s.dirty.add(split_->first(_ids[i]), split_->first(_ids[i]+1));
+        return;
+    }
+    s.dirty.add_sorted(_ids);
+}
+
+size_t MeshBuffers::flush(Attribute _attr, const void* _data)
+{
+    Slot& s = slots_[_attr];
+    if (s.dirty.empty() || !s.buffer.isCreated())
+        return 0;
+
+    const char* src = static_cast<const char*>(_data);
+    const bool  gathered = split(_attr);
+    size_t written = 0;
+
+    s.buffer.bind();
+    if (2*s.dirty.n_elements() > s.n_elems)
+    {
+        /// mostly dirty: one contiguous write is cheaper than many small
+        /// ones, into fresh storage so it never waits for frames in flight
+        written = s.n_elems*s.elem_size;
+        if (gathered)
+        {
+            staging_.resize(written);
+            split_->gather(src, s.elem_size, 0, s.n_elems, &staging_[0]);
+        }
+        s.buffer.allocate(gathered ? &staging_[0] : src, static_cast<int>(written));
+    }
+    else
+    {
+        const std::vector<DirtyRanges::Range>& r = s.dirty.ranges();
+        for (size_t i = 0; i < r.size(); ++i)
+        {
+            size_t offset = r[i].first*s.elem_size;
+            size_t count  = std::min(r[i].second, s.n_elems)*s.elem_size - offset;
+            if (gathered)
+            {
+                staging_.resize(count);
+                split_->gather(src, s.elem_size, r[i].first, count/s.elem_size, &staging_[0]);
+                s.buffer.write(static_cast<int>(offset), &staging_[0], static_cast<int>(count));
+            }
+            else
+                s.buffer.write(static_cast<int>(offset), src+offset, static_cast<int>(count));
+            written += count;
+        }
+    }
+    s.buffer.release();
+
+    s.dirty.clear();
+    return written;
+}
+
+void MeshBuffers::write(Attribute _attr, size_t _first, size_t _n, const void* _data)
+{
+    Slot& s = slots_[_attr];
+    if (!s.buffer.isCreated() || _first >= s.n_elems)
+        return;
+
+    _n = std::min(_n, s.n_elems-_first);
+    s.buffer.bind();
+    if (_first == 0 && _n == s.n_elems)
+        s.buffer.allocate(_data, static_cast<int>(_n*s.elem_size));   // orphans the old storage
+    else
+        s.buffer.write(static_cast<int>(_first*s.elem_size), _data, static_cast<int>(_n*s.elem_size));
+    s.buffer.release();
+}
+
+bool MeshBuffers::bind(Attribute _attr)
+{
+    Slot& s = slots_[source(_attr)];
+    return s.buffer.isCreated() && s.buffer.bind();
+}
+
+void MeshBuffers::release(Attribute _attr)
+{
+    slots_[source(_attr)].buffer.release();
+}
+
+void MeshBuffers::clear(Attribute _attr)
+{
+    Slot& s = slots_[_attr];
+    if (s.buffer.isCreated())
+        s.buffer.destroy();
+    s.elem_size = s.n_elems = 0;
+    s.dirty.clear();
+    s.source = -1;
+    s.offset = 0;
+
+    /// aliases of _attr go with it
+    for (int i = 0; i < NAttributes; ++i)
+        if (slots_[i].source == _attr)
+            clear(Attribute(i));
+}
+
+void MeshBuffers::clear()
+{
+    for (int i = 0; i < NAttributes; ++i)
+        clear(Attribute(i));
+}
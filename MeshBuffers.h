@@ -0,0 +1,143 @@
+#ifndef MESHBUFFERS_H
+#define MESHBUFFERS_H
+
+//== INCLUDES =================================================================
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+#include <QGLBuffer>
+
+class VertexSplit;
+
+//== CLASS DEFINITION =========================================================
+/// Sorted, merged list of half-open element ranges [first,last) that need to
+/// be re-uploaded. Ranges closer than merge_gap elements are fused, trading a
+/// few redundant bytes for fewer glBufferSubData calls.
+class DirtyRanges
+{
+public:
+    typedef std::pair<size_t, size_t> Range;
+
+    explicit DirtyRanges(size_t _merge_gap=64)
+        : merge_gap_(_merge_gap), normalized_(true) {}
+
+    /// add range [_first,_last)
+    void add(size_t _first, size_t _last);
+    /// add single elements, _ids must be sorted ascending
+    void add_sorted(const std::vector<unsigned int>& _ids);
+
+    void clear() { ranges_.clear(); normalized_ = true; }
+    bool empty() const { return ranges_.empty(); }
+
+    /// number of elements covered by all ranges
+    size_t n_elements();
+    const std::vector<Range>& ranges();
+
+private:
+    void normalize();
+
+    std::vector<Range> ranges_;
+    size_t             merge_gap_;
+    bool               normalized_;
+};
+
+
+//== CLASS DEFINITION =========================================================
+/// GPU copies of the per-vertex arrays and the triangle index list of a mesh,
+/// plus the isoline segments extracted from it.
+/// All methods that touch GL require the owning widget's context to be current.
+class MeshBuffers
+{
+public:
+    enum Attribute {
+        Position = 0,
+        Normal,
+        Color,
+        TexCoord,
+        Scalar,
+        Occlusion,    ///< baked ambient occlusion as RGB diffuse bytes
+        Vertices,     ///< interleaved attributes of a VertexLayouts.h layout
+        Index,
+        Isoline,      ///< line segment end points, not indexed
+        NAttributes
+    };
+
+public:
+    MeshBuffers();
+    ~MeshBuffers();
+
+    /// (re)allocate an attribute buffer and fill it completely
+    void upload(Attribute _attr, const void* _data, size_t _elem_size, size_t _n_elems);
+
+    /// Draw through the split render vertices of _split (VertexSplit.h), 0
+    /// for one per mesh vertex. The per-vertex attributes, Position to
+    /// Occlusion, still take mesh vertex data: an upload of one element per
+    /// mesh vertex and every flush are gathered to the render vertices,
+    /// mark_dirty() takes mesh vertices and dirty_ranges() returns the render
+    /// vertices they cover. Vertices and write() address render vertices.
+    /// _split has to outlive its use.
+    void set_vertex_split(const VertexSplit* _split) { split_ = _split; }
+
+    /// mark elements [_first,_last) of _attr as modified on the CPU side
+    void mark_dirty(Attribute _attr, size_t _first, size_t _last);
+    /// mark single elements of _attr as modified, _ids must be sorted
+    void mark_dirty(Attribute _attr, const std::vector<unsigned int>& _ids);
+
+    /// Re-upload the dirty ranges of _attr from _data, returns bytes written.
+    /// Whole buffer writes (here and in write()) respecify the storage
+    /// instead: the driver orphans the old one, still read by frames in
+    /// flight, rather than stalling until they are done.
+    size_t flush(Attribute _attr, const void* _data);
+
+    /// For attributes stored in a different layout than on the CPU: the
+    /// caller encodes each dirty range, writes it and clears the ranges.
+    const std::vector<DirtyRanges::Range>& dirty_ranges(Attribute _attr) { return slots_[_attr].dirty.ranges(); }
+    void   clear_dirty(Attribute _attr) { slots_[_attr].dirty.clear(); }
+    /// overwrite elements [_first,_first+_n) of _attr, _data holds just those
+    void   write(Attribute _attr, size_t _first, size_t _n, const void* _data);
+
+    /// Serve _attr from _source at byte _offset of each element, e.g. the
+    /// position and normal of an interleaved Vertices buffer. The alias has
+    /// the element count of _source but owns no memory; marking it dirty
+    /// works as for any buffer, writing goes through _source.
+    void   alias(Attribute _attr, Attribute _source, size_t _offset);
+
+    bool   has(Attribute _attr) const { return slots_[source(_attr)].buffer.isCreated(); }
+    bool   bind(Attribute _attr);
+    void   release(Attribute _attr);
+    size_t n_elements(Attribute _attr) const { return slots_[_attr].n_elems; }
+    size_t bytes(Attribute _attr) const { return slots_[_attr].n_elems*slots_[_attr].elem_size; }
+    /// gl*Pointer() stride and offset of _attr, both 0 unless aliased
+    size_t stride(Attribute _attr) const { return source(_attr) == _attr ? 0 : slots_[source(_attr)].elem_size; }
+    size_t offset(Attribute _attr) const { return slots_[_attr].offset; }
+
+    /// destroy a single buffer / all buffers
+    void clear(Attribute _attr);
+    void clear();
+
+private:
+    Attribute source(Attribute _attr) const { return slots_[_attr].source < 0 ? _attr : Attribute(slots_[_attr].source); }
+    /// _attr holds mesh vertex data gathered to more render vertices
+    bool split(Attribute _attr) const;
+
+    struct Slot
+    {
+        Slot() : elem_size(0), n_elems(0), source(-1), offset(0) {}
+
+        QGLBuffer   buffer;
+        size_t      elem_size;
+        size_t      n_elems;
+        DirtyRanges dirty;
+        int         source;     ///< aliased attribute, -1 for an own buffer
+        size_t      offset;
+    };
+
+    Slot               slots_[NAttributes];
+    const VertexSplit* split_;
+    std::vector<char>  staging_;   ///< gathered elements of split attributes
+};
+
+//=============================================================================
+#endif // MESHBUFFERS_H defined
+//=============================================================================
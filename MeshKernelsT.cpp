@@ -0,0 +1,302 @@
+#define MESHKERNELST_CPP
+
+//== INCLUDES =================================================================
+#include <cmath>
+#include <algorithm>
+
+#include <OpenMesh/Core/Utils/vector_cast.hh>
+
+#include "MeshKernelsT.h"
+
+//== IMPLEMENTATION ==========================================================
+template <typename Mesh>
+void bounding_box(const Mesh& _mesh, typename Mesh::Point& _min, typename Mesh::Point& _max)
+{
+    typedef typename Mesh::Point Point;
+    const int n = static_cast<int>(_mesh.n_vertices());
+    if ( n == 0 )
+    {
+        _min = _max = Point(0,0,0);
+        return;
+    }
+
+    const Point* points = _mesh.points();
+    _min = _max = points[0];
+
+#pragma omp parallel
+    {
+        /// per-thread box, merged at the end
+        Point lo(points[0]), hi(points[0]);
+
+#pragma omp for nowait schedule(static)
+        for (int i = 0; i < n; ++i)
+        {
+            lo.minimize(points[i]);
+            hi.maximize(points[i]);
+        }
+
+#pragma omp critical
+        {
+            _min.minimize(lo);
+            _max.maximize(hi);
+        }
+    }
+}
+
+template <typename Mesh>
+void face_centroids(Mesh& _mesh, OpenMesh::FPropHandleT<typename Mesh::Point> _prop,
+                    const std::vector<unsigned int>* _faces)
+{
+    typedef typename Mesh::Point Point;
+    const int n = static_cast<int>(_faces ? _faces->size() : _mesh.n_faces());
+
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; ++i)
+    {
+        typename Mesh::FaceHandle fh(_faces ? (*_faces)[i] : i);
+        Point c(0,0,0);
+        int   k = 0;
+        for (typename Mesh::ConstFaceVertexIter fv_it=_mesh.cfv_iter(fh); fv_it.is_valid(); ++fv_it, ++k)
+            c += OpenMesh::vector_cast<Point>(_mesh.point(*fv_it));
+        _mesh.property(_prop, fh) = c/static_cast<typename Point::value_type>(k ? k : 1);
+    }
+}
+
+template <typename Mesh>
+void triangle_indices(const Mesh& _mesh, std::vector<unsigned int>& _indices)
+{
+    const int n = static_cast<int>(_mesh.n_faces());
+    _indices.resize(3*static_cast<size_t>(n));
+
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; ++i)
+    {
+        typename Mesh::ConstFaceVertexIter fv_it = _mesh.cfv_iter(typename Mesh::FaceHandle(i));
+        unsigned int* idx = &_indices[3*static_cast<size_t>(i)];
+        for (int k = 0; k < 3 && fv_it.is_valid(); ++k, ++fv_it)
+            idx[k] = fv_it->idx();
+    }
+}
+
+template <typename Mesh>
+void vertex_corners(const Mesh& _mesh, VertexCorners& _corners)
+{
+    const int n = static_cast<int>(_mesh.n_vertices());
+    _corners.offsets.assign(n+1, 0);
+
+    /// row lengths, their prefix sum, then the rows, each sorted into face
+    /// order as the array overload below fills them
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; ++i)
+    {
+        unsigned int k = 0;
+        for (typename Mesh::ConstVertexFaceIter vf_it=_mesh.cvf_iter(typename Mesh::VertexHandle(i)); vf_it.is_valid(); ++vf_it)
+            ++k;
+        _corners.offsets[i+1] = k;
+    }
+    for (int i = 0; i < n; ++i)
+        _corners.offsets[i+1] += _corners.offsets[i];
+
+    _corners.corners.resize(_corners.offsets[n]);
+
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; ++i)
+    {
+        typename Mesh::VertexHandle vh(i);
+        unsigned int* row = _corners.corners.data() + _corners.offsets[i];
+        unsigned int* end = row;
+        for (typename Mesh::ConstVertexFaceIter vf_it=_mesh.cvf_iter(vh); vf_it.is_valid(); ++vf_it)
+        {
+            unsigned int k = 0;
+            for (typename Mesh::ConstFaceVertexIter fv_it=_mesh.cfv_iter(*vf_it); fv_it.is_valid() && *fv_it != vh; ++fv_it)
+                ++k;
+            *end++ = 3*static_cast<unsigned int>(vf_it->idx()) + k;
+        }
+        std::sort(row, end);
+    }
+}
+
+inline void vertex_corners(const unsigned int* _triangles, size_t _n_faces, size_t _n_vertices,
+                           VertexCorners& _corners)
+{
+    const size_t nc = 3*_n_faces;
+    _corners.offsets.assign(_n_vertices+1, 0);
+    for (size_t c = 0; c < nc; ++c)
+        ++_corners.offsets[_triangles[c]+1];
+    for (size_t v = 0; v < _n_vertices; ++v)
+        _corners.offsets[v+1] += _corners.offsets[v];
+
+    _corners.corners.resize(nc);
+    std::vector<unsigned int> fill(_corners.offsets.begin(), _corners.offsets.end()-1);
+    for (size_t c = 0; c < nc; ++c)
+        _corners.corners[fill[_triangles[c]]++] = static_cast<unsigned int>(c);
+}
+
+template <typename Scalar>
+void triangle_cross(const Scalar* _p0, const Scalar* _p1, const Scalar* _p2, Scalar* _cross)
+{
+    const Scalar a[3] = { _p1[0]-_p0[0], _p1[1]-_p0[1], _p1[2]-_p0[2] };
+    const Scalar b[3] = { _p2[0]-_p0[0], _p2[1]-_p0[1], _p2[2]-_p0[2] };
+    _cross[0] = a[1]*b[2] - a[2]*b[1];
+    _cross[1] = a[2]*b[0] - a[0]*b[2];
+    _cross[2] = a[0]*b[1] - a[1]*b[0];
+}
+
+template <typename Scalar>
+void normalize_vector(const Scalar* _v, Scalar* _out)
+{
+    const Scalar l = std::sqrt(_v[0]*_v[0] + _v[1]*_v[1] + _v[2]*_v[2]);
+    const Scalar s = l > Scalar(0) ? Scalar(1)/l : Scalar(0);
+    _out[0] = _v[0]*s; _out[1] = _v[1]*s; _out[2] = _v[2]*s;
+}
+
+template <typename Scalar>
+void add_face_normal(const Scalar* _cross, const Scalar* _p0, const Scalar* _p1, const Scalar* _p2,
+                     NormalWeights _weights, Scalar* _n)
+{
+    /// cross itself for area weights, cross/|cross| times 1 or the angle
+    Scalar w = Scalar(1);
+    if ( _weights != AreaWeights )
+    {
+        const Scalar l = std::sqrt(_cross[0]*_cross[0] + _cross[1]*_cross[1] + _cross[2]*_cross[2]);
+        if ( !(l > Scalar(0)) )
+            return;
+        w = Scalar(1)/l;
+        if ( _weights == AngleWeights )
+        {
+            const Scalar a[3] = { _p1[0]-_p0[0], _p1[1]-_p0[1], _p1[2]-_p0[2] };
+            const Scalar b[3] = { _p2[0]-_p0[0], _p2[1]-_p0[1], _p2[2]-_p0[2] };
+            const Scalar la = std::sqrt((a[0]*a[0] + a[1]*a[1] + a[2]*a[2])*(b[0]*b[0] + b[1]*b[1] + b[2]*b[2]));
+            const Scalar d  = a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+            w *= la > Scalar(0) ? std::acos(std::max(Scalar(-1), std::min(Scalar(1), d/la))) : Scalar(0);
+        }
+    }
+    _n[0] += _cross[0]*w; _n[1] += _cross[1]*w; _n[2] += _cross[2]*w;
+}
+
+template <typename Scalar>
+void compute_normals(const Scalar* _points, const unsigned int* _triangles, size_t _n_faces,
+                     const VertexCorners& _corners, NormalWeights _weights, std::vector<Scalar>& _cross,
+                     Scalar* _face_normals, Scalar* _vertex_normals)
+{
+    _cross.resize(3*_n_faces);
+    Scalar* cr = _cross.empty() ? 0 : &_cross[0];
+
+    const long nf = static_cast<long>(_n_faces);
+#pragma omp parallel for schedule(static)
+    for (long f = 0; f < nf; ++f)
+    {
+        const unsigned int* t = _triangles + 3*f;
+        triangle_cross(_points + 3*t[0], _points + 3*t[1], _points + 3*t[2], cr + 3*f);
+        if ( _face_normals )
+            normalize_vector(cr + 3*f, _face_normals + 3*f);
+    }
+    if ( !_vertex_normals || _corners.offsets.empty() )
+        return;
+
+    const long nv = static_cast<long>(_corners.offsets.size()-1);
+#pragma omp parallel for schedule(static)
+    for (long v = 0; v < nv; ++v)
+    {
+        Scalar n[3] = { Scalar(0), Scalar(0), Scalar(0) };
+        for (unsigned int j = _corners.offsets[v]; j < _corners.offsets[v+1]; ++j)
+        {
+            const unsigned int c = _corners.corners[j], f = c/3, k = c%3;
+            const unsigned int* t = _triangles + 3*f;
+            add_face_normal(cr + 3*f, _points + 3*t[k], _points + 3*t[(k+1)%3], _points + 3*t[(k+2)%3],
+                            _weights, n);
+        }
+        normalize_vector(n, _vertex_normals + 3*v);
+    }
+}
+
+//-----------------------------------------------------------------------------
+template <typename Mesh>
+void update_normals(Mesh& _mesh, const VertexCorners& _corners,
+                    bool _faces, bool _vertices, NormalWeights _weights)
+{
+    typedef typename Mesh::Point::value_type Scalar;
+
+    _faces    = _faces && _mesh.has_face_normals();
+    _vertices = _vertices && _mesh.has_vertex_normals();
+    if ( (!_faces && !_vertices) || !_mesh.n_faces() )
+        return;
+
+    std::vector<unsigned int> triangles;
+    triangle_indices(_mesh, triangles);
+    std::vector<Scalar> cross;
+    compute_normals(&_mesh.points()[0][0], &triangles[0], _mesh.n_faces(), _corners, _weights, cross,
+                    _faces ? &_mesh.property(_mesh.face_normals_pph(), typename Mesh::FaceHandle(0))[0] : 0,
+                    _vertices ? &_mesh.property(_mesh.vertex_normals_pph(), typename Mesh::VertexHandle(0))[0] : 0);
+}
+
+template <typename Mesh>
+void update_normals(Mesh& _mesh, bool _faces, bool _vertices, NormalWeights _weights)
+{
+    VertexCorners corners;
+    if ( _vertices && _mesh.has_vertex_normals() )
+        vertex_corners(_mesh, corners);
+    update_normals(_mesh, corners, _faces, _vertices, _weights);
+}
+
+template <typename Mesh>
+void update_normals(Mesh& _mesh, const std::vector<unsigned int>& _faces,
+                    const std::vector<unsigned int>& _vertices, NormalWeights _weights)
+{
+    typedef typename Mesh::Point::value_type Scalar;
+
+    if ( _mesh.has_face_normals() )
+    {
+        const long n = static_cast<long>(_faces.size());
+#pragma omp parallel for schedule(static) if (n > 4096)
+        for (long i = 0; i < n; ++i)
+        {
+            const typename Mesh::FaceHandle fh(_faces[i]);
+            const Scalar* p[3];
+            typename Mesh::ConstFaceVertexIter fv_it = _mesh.cfv_iter(fh);
+            for (int k = 0; k < 3 && fv_it.is_valid(); ++k, ++fv_it)
+                p[k] = &_mesh.point(*fv_it)[0];
+            Scalar cross[3];
+            triangle_cross(p[0], p[1], p[2], cross);
+            normalize_vector(cross, &_mesh.property(_mesh.face_normals_pph(), fh)[0]);
+        }
+    }
+
+    if ( !_mesh.has_vertex_normals() )
+        return;
+
+    /// faces around each vertex in face order, as in the rows of
+    /// vertex_corners(), with the vertex as corner k of the face's vertices;
+    /// one face buffer per thread
+    const long n = static_cast<long>(_vertices.size());
+#pragma omp parallel if (n > 4096)
+    {
+        std::vector<unsigned int> faces;
+#pragma omp for schedule(static)
+        for (long i = 0; i < n; ++i)
+        {
+            const typename Mesh::VertexHandle vh(_vertices[i]);
+            faces.clear();
+            for (typename Mesh::ConstVertexFaceIter vf_it=_mesh.cvf_iter(vh); vf_it.is_valid(); ++vf_it)
+                faces.push_back(vf_it->idx());
+            std::sort(faces.begin(), faces.end());
+
+            Scalar sum[3] = { Scalar(0), Scalar(0), Scalar(0) };
+            for (size_t f = 0; f < faces.size(); ++f)
+            {
+                const Scalar* p[3];
+                int k = 0, j = 0;
+                for (typename Mesh::ConstFaceVertexIter fv_it=_mesh.cfv_iter(typename Mesh::FaceHandle(faces[f])); fv_it.is_valid() && j < 3; ++fv_it, ++j)
+                {
+                    p[j] = &_mesh.point(*fv_it)[0];
+                    if ( *fv_it == vh )
+                        k = j;
+                }
+                Scalar cross[3];
+                triangle_cross(p[0], p[1], p[2], cross);
+                add_face_normal(cross, p[k], p[(k+1)%3], p[(k+2)%3], _weights, sum);
+            }
+            normalize_vector(sum, &_mesh.property(_mesh.vertex_normals_pph(), vh)[0]);
+        }
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef MESHKERNELST_H
+#define MESHKERNELST_H
+
+//== INCLUDES =================================================================
+#include <vector>
+#include <cstddef>
+
+#include <OpenMesh/Core/Utils/Property.hh>
+
+//== TYPES ====================================================================
+/// Corners around every vertex in compressed rows: the corners of vertex i
+/// are corners[offsets[i]] .. corners[offsets[i+1]-1], where corner 3f+k is
+/// the k-th vertex of face f.
+struct VertexCorners
+{
+    std::vector<unsigned int> offsets;   // n_vertices+1
+    std::vector<unsigned int> corners;
+};
+
+/// how face normals are weighted in a vertex normal
+enum NormalWeights
+{
+    AreaWeights,      ///< by face area, the viewer's default
+    AngleWeights,     ///< by the corner angle at the vertex
+    UniformWeights    ///< all faces alike, as OpenMesh's update_vertex_normals()
+};
+
+//== ARRAY KERNELS ============================================================
+/// The normal computation itself on flat arrays: 3 coordinates per point and
+/// normal, 3 vertex indices per triangle. The mesh passes below, the vertex
+/// animation and the vertex split share these, so a vertex that sums the
+/// same corners in the same order gets the same normal from each of them.
+
+/// corner rows of _n_faces triangles over _n_vertices vertices by counting
+/// sort, in face order within each row
+inline void vertex_corners(const unsigned int* _triangles, size_t _n_faces, size_t _n_vertices,
+                           VertexCorners& _corners);
+
+/// (_p1-_p0) x (_p2-_p0), twice the area along the normal
+template <typename Scalar>
+void triangle_cross(const Scalar* _p0, const Scalar* _p1, const Scalar* _p2, Scalar* _cross);
+
+/// _v/|_v| into _out, zero for a zero vector
+template <typename Scalar>
+void normalize_vector(const Scalar* _v, Scalar* _out);
+
+/// Add the face with cross product _cross to the vertex normal sum _n, at
+/// the corner _p0 of its triangle (_p0,_p1,_p2) for angle weights
+template <typename Scalar>
+void add_face_normal(const Scalar* _cross, const Scalar* _p0, const Scalar* _p1, const Scalar* _p2,
+                     NormalWeights _weights, Scalar* _n);
+
+/// Face normals of all triangles in a parallel face pass, then vertex
+/// normals as a gather over the rows of _corners, in row order, so no two
+/// threads write the same vertex. Either output may be 0; _cross keeps the
+/// per-face cross products and can be reused between calls.
+template <typename Scalar>
+void compute_normals(const Scalar* _points, const unsigned int* _triangles, size_t _n_faces,
+                     const VertexCorners& _corners, NormalWeights _weights, std::vector<Scalar>& _cross,
+                     Scalar* _face_normals, Scalar* _vertex_normals);
+
+//== FUNCTIONS ================================================================
+/// Data-parallel passes over a triangle mesh, shared by the viewer's load
+/// pipeline, the benchmark and the batch tools.
+
+/// axis aligned bounding box of all points
+template <typename Mesh>
+void bounding_box(const Mesh& _mesh, typename Mesh::Point& _min, typename Mesh::Point& _max);
+
+/// face centroids into _prop, all faces or the listed (sorted) ones
+template <typename Mesh>
+void face_centroids(Mesh& _mesh, OpenMesh::FPropHandleT<typename Mesh::Point> _prop,
+                    const std::vector<unsigned int>* _faces=0);
+
+/// three vertex indices per face, in face order
+template <typename Mesh>
+void triangle_indices(const Mesh& _mesh, std::vector<unsigned int>& _indices);
+
+/// corner rows of all vertices of a triangle mesh, in face order within
+/// each row as the array overload gives them
+template <typename Mesh>
+void vertex_corners(const Mesh& _mesh, VertexCorners& _corners);
+
+/// compute_normals() on the mesh arrays, with _corners from
+/// vertex_corners(_mesh). Either kind is only written if requested and the
+/// mesh has it. AreaWeights differs from OpenMesh's update_vertex_normals(),
+/// which weights all faces alike (UniformWeights).
+template <typename Mesh>
+void update_normals(Mesh& _mesh, const VertexCorners& _corners,
+                    bool _faces=true, bool _vertices=true, NormalWeights _weights=AreaWeights);
+
+/// as above, with corner rows built on the fly
+template <typename Mesh>
+void update_normals(Mesh& _mesh, bool _faces=true, bool _vertices=true,
+                    NormalWeights _weights=AreaWeights);
+
+/// Normals of the listed faces and vertices only, for edits. Each vertex
+/// sums its faces in face order, the order of its vertex_corners(_mesh)
+/// row, so it gets the normal a full update_normals() would give it.
+template <typename Mesh>
+void update_normals(Mesh& _mesh, const std::vector<unsigned int>& _faces,
+                    const std::vector<unsigned int>& _vertices, NormalWeights _weights=AreaWeights);
+
+#ifndef MESHKERNELST_CPP
+#include "MeshKernelsT.cpp"
+#endif
+//=============================================================================
+#endif // MESHKERNELST_H defined
+//=============================================================================
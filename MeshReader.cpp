@@ -0,0 +1,941 @@
+//== INCLUDES =================================================================
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QElapsedTimer>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <OpenMesh/Core/IO/MeshIO.hh>
+
+#include "MeshReader.h"
+
+//== IMPLEMENTATION ==========================================================
+
+/// flat arrays a file is parsed into before the mesh is built
+struct ParsedMesh
+{
+    ParsedMesh() : n_vertices(0), has_normals(false), has_colors(false) {}
+
+    size_t                     n_vertices;
+    std::vector<float>         points;     // 3 per vertex
+    std::vector<float>         normals;    // 3 per vertex, if has_normals
+    std::vector<unsigned char> colors;     // 3 per vertex, if has_colors
+    std::vector<unsigned int>  triangles;  // 3 per face
+    bool                       has_normals, has_colors;
+};
+
+/// columns of a vertex record, -1 if absent
+struct VertexLayout
+{
+    VertexLayout() : n_columns(3), color_scale(1.0f), bare_faces(false)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            position[i] = i;
+            normal[i]   = -1;
+            color[i]    = -1;
+        }
+    }
+
+    int   n_columns;  ///< columns that have to be parsed
+    int   position[3], normal[3], color[3];
+    float color_scale;
+    bool  bare_faces; ///< polygon lines end after their indices (OFF face colors go to OpenMesh)
+};
+
+//-----------------------------------------------------------------------------
+// number parsing
+//-----------------------------------------------------------------------------
+static inline const char* skip_blanks(const char* _p, const char* _end)
+{
+    while ( _p < _end && (*_p == ' ' || *_p == '\t' || *_p == '\r') )
+        ++_p;
+    return _p;
+}
+
+static inline bool is_digit(char _c)
+{
+    return static_cast<unsigned int>(_c - '0') < 10u;
+}
+
+static inline double pow10i(int _e)
+{
+    static const double exact[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    return _e <= 22 ? exact[_e] : std::pow(10.0, _e);
+}
+
+/// Decimal to double without locale or errno: up to 19 significant digits
+/// are accumulated in an integer and scaled once by a power of ten, which is
+/// exact to well beyond float precision. Returns the end of the number, 0 if
+/// there is none.
+static const char* parse_real(const char* _p, const char* _end, double& _value)
+{
+    bool negative = false;
+    if ( _p < _end && (*_p == '-' || *_p == '+') )
+        negative = (*_p++ == '-');
+
+    unsigned long long mantissa = 0;
+    int  digits = 0, exponent = 0;
+    bool any = false;
+
+    for (; _p < _end && is_digit(*_p); ++_p, any = true)
+    {
+        if ( digits < 19 )
+        {
+            mantissa = mantissa*10 + (*_p - '0');
+            if ( mantissa ) ++digits;
+        }
+        else
+            ++exponent;
+    }
+    if ( _p < _end && *_p == '.' )
+    {
+        for (++_p; _p < _end && is_digit(*_p); ++_p, any = true)
+        {
+            if ( digits < 19 )
+            {
+                mantissa = mantissa*10 + (*_p - '0');
+                if ( mantissa ) ++digits;
+                --exponent;
+            }
+        }
+    }
+    if ( !any )
+        return 0;
+
+    if ( _p < _end && (*_p == 'e' || *_p == 'E') )
+    {
+        ++_p;
+        bool negative_exp = false;
+        if ( _p < _end && (*_p == '-' || *_p == '+') )
+            negative_exp = (*_p++ == '-');
+        if ( _p == _end || !is_digit(*_p) )
+            return 0;
+        int e = 0;
+        for (; _p < _end && is_digit(*_p); ++_p)
+            if ( e < 10000 )
+                e = e*10 + (*_p - '0');
+        exponent += negative_exp ? -e : e;
+    }
+
+    double v = static_cast<double>(mantissa);
+    if ( exponent > 0 )
+        v *= pow10i(exponent);
+    else if ( exponent < 0 )
+        v /= pow10i(-exponent);
+
+    _value = negative ? -v : v;
+    return _p;
+}
+
+static const char* parse_int(const char* _p, const char* _end, long& _value)
+{
+    bool negative = false;
+    if ( _p < _end && (*_p == '-' || *_p == '+') )
+        negative = (*_p++ == '-');
+    if ( _p == _end || !is_digit(*_p) )
+        return 0;
+
+    long v = 0;
+    for (; _p < _end && is_digit(*_p); ++_p)
+        v = v*10 + (*_p - '0');
+    _value = negative ? -v : v;
+    return _p;
+}
+
+static inline const char* line_end(const char* _p, const char* _end)
+{
+    const char* n = static_cast<const char*>(std::memchr(_p, '\n', _end-_p));
+    return n ? n : _end;
+}
+
+/// data lines are neither blank nor comments
+static inline bool is_data_line(const char* _p, const char* _eol)
+{
+    _p = skip_blanks(_p, _eol);
+    return _p < _eol && *_p != '#';
+}
+
+//-----------------------------------------------------------------------------
+// chunking
+//-----------------------------------------------------------------------------
+static int n_threads()
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/// cut [_begin,_end) into at most a few chunks per thread, each starting at
+/// the beginning of a line
+static void split_lines(const char* _begin, const char* _end, std::vector<const char*>& _bounds)
+{
+    const size_t size   = _end - _begin;
+    const size_t n      = std::max<size_t>(1, std::min<size_t>(8*n_threads(), size >> 20));
+
+    _bounds.assign(1, _begin);
+    for (size_t i = 1; i < n; ++i)
+    {
+        const char* p = _begin + size*i/n;
+        if ( p[-1] != '\n' )
+        {
+            p = line_end(p, _end);
+            if ( p < _end ) ++p;
+        }
+        if ( p > _bounds.back() && p < _end )
+            _bounds.push_back(p);
+    }
+    _bounds.push_back(_end);
+}
+
+/// append the per-chunk triangle lists in chunk order
+static void concatenate(std::vector< std::vector<unsigned int> >& _parts, std::vector<unsigned int>& _out)
+{
+    std::vector<size_t> offset(_parts.size()+1, 0);
+    for (size_t i = 0; i < _parts.size(); ++i)
+        offset[i+1] = offset[i] + _parts[i].size();
+    _out.resize(offset.back());
+
+    const int n = static_cast<int>(_parts.size());
+#pragma omp parallel for schedule(dynamic,1)
+    for (int i = 0; i < n; ++i)
+    {
+        if ( !_parts[i].empty() )
+            std::memcpy(&_out[offset[i]], &_parts[i][0], _parts[i].size()*sizeof(unsigned int));
+        std::vector<unsigned int>().swap(_parts[i]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// ASCII records
+//-----------------------------------------------------------------------------
+static bool parse_vertex(const char* _p, const char* _eol, const VertexLayout& _layout,
+                         size_t _i, ParsedMesh& _m)
+{
+    double column[32];
+    for (int k = 0; k < _layout.n_columns; ++k)
+    {
+        _p = parse_real(skip_blanks(_p, _eol), _eol, column[k]);
+        if ( !_p )
+            return false;
+    }
+
+    for (int k = 0; k < 3; ++k)
+    {
+        _m.points[3*_i+k] = static_cast<float>(column[_layout.position[k]]);
+        if ( _m.has_normals )
+            _m.normals[3*_i+k] = static_cast<float>(column[_layout.normal[k]]);
+        if ( _m.has_colors )
+        {
+            double c = column[_layout.color[k]]*_layout.color_scale;
+            _m.colors[3*_i+k] = static_cast<unsigned char>(std::max(0.0, std::min(255.0, c)));
+        }
+    }
+    return true;
+}
+
+/// "n i0 i1 ... in-1", fan triangulated into _tris; with _bare, only a
+/// comment may follow the indices
+static bool parse_polygon(const char* _p, const char* _eol, size_t _n_vertices, bool _bare,
+                          std::vector<unsigned int>& _tris)
+{
+    long n, first = 0, prev = 0, idx;
+    _p = parse_int(skip_blanks(_p, _eol), _eol, n);
+    if ( !_p || n < 3 )
+        return false;
+
+    for (long k = 0; k < n; ++k)
+    {
+        _p = parse_int(skip_blanks(_p, _eol), _eol, idx);
+        if ( !_p || idx < 0 || static_cast<size_t>(idx) >= _n_vertices )
+            return false;
+        if ( k == 0 )
+            first = idx;
+        else if ( k >= 2 )
+        {
+            _tris.push_back(static_cast<unsigned int>(first));
+            _tris.push_back(static_cast<unsigned int>(prev));
+            _tris.push_back(static_cast<unsigned int>(idx));
+        }
+        prev = idx;
+    }
+    if ( _bare )
+    {
+        _p = skip_blanks(_p, _eol);
+        return _p == _eol || *_p == '#';
+    }
+    return true;
+}
+
+/// _n_vertices vertex lines followed by _n_faces polygon lines, as in OFF
+/// and ASCII PLY; lines past them are ignored
+static bool parse_ascii_records(const char* _begin, const char* _end, size_t _n_vertices,
+                                size_t _n_faces, const VertexLayout& _layout, ParsedMesh& _m)
+{
+    std::vector<const char*> bounds;
+    split_lines(_begin, _end, bounds);
+    const int n_chunks = static_cast<int>(bounds.size()) - 1;
+
+    /// pass 1: data lines per chunk give each chunk its first record index
+    std::vector<size_t> first(n_chunks+1, 0);
+#pragma omp parallel for schedule(dynamic,1)
+    for (int c = 0; c < n_chunks; ++c)
+    {
+        size_t n = 0;
+        for (const char* p = bounds[c]; p < bounds[c+1]; )
+        {
+            const char* eol = line_end(p, bounds[c+1]);
+            if ( is_data_line(p, eol) ) ++n;
+            p = eol+1;
+        }
+        first[c+1] = n;
+    }
+    for (int c = 0; c < n_chunks; ++c)
+        first[c+1] += first[c];
+    if ( first.back() < _n_vertices+_n_faces )
+        return false;
+
+    /// pass 2: vertices go straight to their slot, triangles to per-chunk lists
+    _m.n_vertices = _n_vertices;
+    _m.points.resize(3*_n_vertices);
+    if ( _m.has_normals ) _m.normals.resize(3*_n_vertices);
+    if ( _m.has_colors )  _m.colors.resize(3*_n_vertices);
+
+    std::vector< std::vector<unsigned int> > tris(n_chunks);
+    int errors = 0;
+
+#pragma omp parallel for schedule(dynamic,1) reduction(+:errors)
+    for (int c = 0; c < n_chunks; ++c)
+    {
+        size_t record = first[c];
+        if ( record >= _n_vertices+_n_faces )
+            continue;
+        if ( record + (first[c+1]-first[c]) > _n_vertices )
+            tris[c].reserve(3*(first[c+1]-std::max(record, _n_vertices)));
+
+        for (const char* p = bounds[c]; p < bounds[c+1] && record < _n_vertices+_n_faces; )
+        {
+            const char* eol = line_end(p, bounds[c+1]);
+            if ( is_data_line(p, eol) )
+            {
+                bool ok = (record < _n_vertices)
+                        ? parse_vertex(p, eol, _layout, record, _m)
+                        : parse_polygon(p, eol, _n_vertices, _layout.bare_faces, tris[c]);
+                if ( !ok ) { ++errors; break; }
+                ++record;
+            }
+            p = eol+1;
+        }
+    }
+    if ( errors )
+        return false;
+
+    concatenate(tris, _m.triangles);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// OFF
+//-----------------------------------------------------------------------------
+/// next data line of a header, false at the end of the file
+static bool next_header_line(const char*& _p, const char* _end, const char*& _line, const char*& _eol)
+{
+    while ( _p < _end )
+    {
+        _line = _p;
+        _eol  = line_end(_p, _end);
+        _p    = _eol < _end ? _eol+1 : _end;
+        if ( is_data_line(_line, _eol) )
+            return true;
+    }
+    return false;
+}
+
+static bool parse_off(const char* _begin, const char* _end, ParsedMesh& _m)
+{
+    const char *p = _begin, *line, *eol;
+    if ( !next_header_line(p, _end, line, eol) )
+        return false;
+
+    /// plain "OFF" only, COFF/NOFF/STOFF/4OFF and binary go to OpenMesh
+    line = skip_blanks(line, eol);
+    if ( eol-line < 3 || std::strncmp(line, "OFF", 3) != 0 )
+        return false;
+    line = skip_blanks(line+3, eol);
+
+    /// the counts may follow on the same line
+    if ( line == eol || *line == '#' )
+    {
+        if ( !next_header_line(p, _end, line, eol) )
+            return false;
+    }
+
+    long nv, nf;
+    line = parse_int(skip_blanks(line, eol), eol, nv);
+    if ( !line ) return false;
+    line = parse_int(skip_blanks(line, eol), eol, nf);
+    if ( !line || nv <= 0 || nf < 0 )
+        return false;
+
+    /// face colors after the indices are left to OpenMesh
+    VertexLayout layout;
+    layout.bare_faces = true;
+    return parse_ascii_records(p, _end, nv, nf, layout, _m);
+}
+
+//-----------------------------------------------------------------------------
+// OBJ
+//-----------------------------------------------------------------------------
+enum ObjLine { ObjOther, ObjVertex, ObjFace, ObjUnsupported };
+
+static inline ObjLine obj_line_type(const char*& _p, const char* _eol)
+{
+    _p = skip_blanks(_p, _eol);
+    if ( _eol-_p < 2 )
+        return ObjOther;
+    const bool blank = (_p[1] == ' ' || _p[1] == '\t');
+    if ( _p[0] == 'v' && blank )  { _p += 2; return ObjVertex; }
+    if ( _p[0] == 'f' && blank )  { _p += 2; return ObjFace; }
+    if ( _p[0] == 'v' && _p[1] == 't' ) return ObjUnsupported;
+    return ObjOther;
+}
+
+/// "f a b c ...", each corner "v", "v/t", "v//n" or "v/t/n", negative
+/// indices are relative to the vertices read so far
+static bool parse_obj_face(const char* _p, const char* _eol, size_t _n_before,
+                           size_t _n_vertices, std::vector<unsigned int>& _tris)
+{
+    long first = 0, prev = 0, idx;
+    int  k = 0;
+    for (;; ++k)
+    {
+        _p = skip_blanks(_p, _eol);
+        if ( _p == _eol || *_p == '#' )
+            break;
+        _p = parse_int(_p, _eol, idx);
+        if ( !_p || idx == 0 )
+            return false;
+        idx = idx > 0 ? idx-1 : static_cast<long>(_n_before)+idx;
+        if ( idx < 0 || static_cast<size_t>(idx) >= _n_vertices )
+            return false;
+        while ( _p < _eol && *_p != ' ' && *_p != '\t' && *_p != '\r' )
+            ++_p;
+
+        if ( k == 0 )
+            first = idx;
+        else if ( k >= 2 )
+        {
+            _tris.push_back(static_cast<unsigned int>(first));
+            _tris.push_back(static_cast<unsigned int>(prev));
+            _tris.push_back(static_cast<unsigned int>(idx));
+        }
+        prev = idx;
+    }
+    return k >= 3;
+}
+
+static bool parse_obj(const char* _begin, const char* _end, ParsedMesh& _m)
+{
+    std::vector<const char*> bounds;
+    split_lines(_begin, _end, bounds);
+    const int n_chunks = static_cast<int>(bounds.size()) - 1;
+
+    /// pass 1: vertices per chunk, and whether anything needs OpenMesh
+    std::vector<size_t> first(n_chunks+1, 0);
+    int unsupported = 0;
+#pragma omp parallel for schedule(dynamic,1) reduction(+:unsupported)
+    for (int c = 0; c < n_chunks; ++c)
+    {
+        size_t n = 0;
+        for (const char* p = bounds[c]; p < bounds[c+1]; )
+        {
+            const char* eol = line_end(p, bounds[c+1]);
+            const char* q   = p;
+            ObjLine type = obj_line_type(q, eol);
+            if ( type == ObjVertex )
+                ++n;
+            else if ( type == ObjUnsupported )
+            {
+                ++unsupported;
+                break;
+            }
+            p = eol+1;
+        }
+        first[c+1] = n;
+    }
+    if ( unsupported )
+        return false;
+    for (int c = 0; c < n_chunks; ++c)
+        first[c+1] += first[c];
+
+    const size_t nv = first.back();
+    if ( nv == 0 )
+        return false;
+    _m.n_vertices = nv;
+    _m.points.resize(3*nv);
+
+    /// pass 2
+    VertexLayout layout;
+    std::vector< std::vector<unsigned int> > tris(n_chunks);
+    int errors = 0;
+
+#pragma omp parallel for schedule(dynamic,1) reduction(+:errors)
+    for (int c = 0; c < n_chunks; ++c)
+    {
+        size_t vertex = first[c];
+        for (const char* p = bounds[c]; p < bounds[c+1]; )
+        {
+            const char* eol = line_end(p, bounds[c+1]);
+            const char* q   = p;
+            bool ok = true;
+            switch ( obj_line_type(q, eol) )
+            {
+            case ObjVertex: ok = parse_vertex(q, eol, layout, vertex++, _m);        break;
+            case ObjFace:   ok = parse_obj_face(q, eol, vertex, nv, tris[c]);       break;
+            default:        break;
+            }
+            if ( !ok ) { ++errors; break; }
+            p = eol+1;
+        }
+    }
+    if ( errors )
+        return false;
+
+    concatenate(tris, _m.triangles);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// PLY
+//-----------------------------------------------------------------------------
+enum PlyType { PlyNone = 0, PlyInt8, PlyUInt8, PlyInt16, PlyUInt16, PlyInt32, PlyUInt32, PlyFloat32, PlyFloat64 };
+
+static PlyType ply_type(const std::string& _name)
+{
+    if ( _name == "char"   || _name == "int8" )    return PlyInt8;
+    if ( _name == "uchar"  || _name == "uint8" )   return PlyUInt8;
+    if ( _name == "short"  || _name == "int16" )   return PlyInt16;
+    if ( _name == "ushort" || _name == "uint16" )  return PlyUInt16;
+    if ( _name == "int"    || _name == "int32" )   return PlyInt32;
+    if ( _name == "uint"   || _name == "uint32" )  return PlyUInt32;
+    if ( _name == "float"  || _name == "float32" ) return PlyFloat32;
+    if ( _name == "double" || _name == "float64" ) return PlyFloat64;
+    return PlyNone;
+}
+
+static size_t ply_size(PlyType _type)
+{
+    static const size_t size[] = { 0, 1, 1, 2, 2, 4, 4, 4, 8 };
+    return size[_type];
+}
+
+/// little endian value at an unaligned address
+static inline double ply_read(const char* _p, PlyType _type)
+{
+    switch ( _type )
+    {
+    case PlyInt8:    { signed char v;    std::memcpy(&v, _p, 1); return v; }
+    case PlyUInt8:   { unsigned char v;  std::memcpy(&v, _p, 1); return v; }
+    case PlyInt16:   { short v;          std::memcpy(&v, _p, 2); return v; }
+    case PlyUInt16:  { unsigned short v; std::memcpy(&v, _p, 2); return v; }
+    case PlyInt32:   { int v;            std::memcpy(&v, _p, 4); return v; }
+    case PlyUInt32:  { unsigned int v;   std::memcpy(&v, _p, 4); return v; }
+    case PlyFloat32: { float v;          std::memcpy(&v, _p, 4); return v; }
+    case PlyFloat64: { double v;         std::memcpy(&v, _p, 8); return v; }
+    default:         return 0;
+    }
+}
+
+struct PlyProperty
+{
+    std::string name;
+    PlyType     type;
+    PlyType     count_type;  ///< list length type, PlyNone for scalars
+};
+
+struct PlyElement
+{
+    std::string              name;
+    size_t                   count;
+    std::vector<PlyProperty> properties;
+};
+
+static bool parse_ply(const char* _begin, const char* _end, ParsedMesh& _m)
+{
+    /// header
+    const char* p = _begin;
+    std::string format;
+    std::vector<PlyElement> elements;
+    bool header_done = false;
+
+    while ( p < _end && !header_done )
+    {
+        const char* eol = line_end(p, _end);
+        std::istringstream line(std::string(p, eol));
+        p = eol < _end ? eol+1 : _end;
+
+        std::string keyword;
+        line >> keyword;
+        if ( keyword == "format" )
+            line >> format;
+        else if ( keyword == "element" )
+        {
+            PlyElement e;
+            line >> e.name >> e.count;
+            elements.push_back(e);
+        }
+        else if ( keyword == "property" )
+        {
+            if ( elements.empty() )
+                return false;
+            PlyProperty prop;
+            std::string type;
+            line >> type;
+            if ( type == "list" )
+            {
+                std::string count_type, item_type;
+                line >> count_type >> item_type;
+                prop.count_type = ply_type(count_type);
+                prop.type       = ply_type(item_type);
+                if ( prop.count_type == PlyNone )
+                    return false;
+            }
+            else
+            {
+                prop.count_type = PlyNone;
+                prop.type       = ply_type(type);
+            }
+            line >> prop.name;
+            if ( prop.type == PlyNone )
+                return false;
+            elements.back().properties.push_back(prop);
+        }
+        else if ( keyword == "end_header" )
+            header_done = true;
+    }
+
+    /// "vertex" then "face", further elements are skipped
+    if ( !header_done || elements.size() < 2 ||
+         elements[0].name != "vertex" || elements[1].name != "face" ||
+         elements[0].count == 0 )
+        return false;
+
+    const PlyElement& ve = elements[0];
+    const PlyElement& fe = elements[1];
+    if ( fe.properties.empty() || fe.properties[0].count_type == PlyNone ||
+         (fe.properties[0].name != "vertex_indices" && fe.properties[0].name != "vertex_index") )
+        return false;
+    /// face colors and per-corner texture coordinates are read by OpenMesh
+    for (size_t i = 1; i < fe.properties.size(); ++i)
+    {
+        const std::string& name = fe.properties[i].name;
+        if ( name == "red" || name == "green" || name == "blue" || name == "texcoord" )
+            return false;
+    }
+
+    /// vertex columns
+    VertexLayout layout;
+    layout.position[0] = layout.position[1] = layout.position[2] = -1;
+    static const char* position_names[] = { "x",   "y",     "z" };
+    static const char* normal_names[]   = { "nx",  "ny",    "nz" };
+    static const char* color_names[]    = { "red", "green", "blue" };
+    PlyType color_type = PlyUInt8;
+
+    for (size_t i = 0; i < ve.properties.size(); ++i)
+    {
+        const PlyProperty& prop = ve.properties[i];
+        if ( prop.count_type != PlyNone )
+            return false;
+        if ( prop.name == "u" || prop.name == "v" || prop.name == "s" || prop.name == "t" ||
+             prop.name == "texture_u" || prop.name == "texture_v" )
+            return false;
+        for (int k = 0; k < 3; ++k)
+        {
+            if ( prop.name == position_names[k] ) layout.position[k] = static_cast<int>(i);
+            if ( prop.name == normal_names[k] )   layout.normal[k]   = static_cast<int>(i);
+            if ( prop.name == color_names[k] )  { layout.color[k]    = static_cast<int>(i); color_type = prop.type; }
+        }
+    }
+    if ( layout.position[0] < 0 || layout.position[1] < 0 || layout.position[2] < 0 )
+        return false;
+
+    _m.has_normals = layout.normal[0] >= 0 && layout.normal[1] >= 0 && layout.normal[2] >= 0;
+    _m.has_colors  = layout.color[0]  >= 0 && layout.color[1]  >= 0 && layout.color[2]  >= 0;
+    if ( _m.has_colors && (color_type == PlyFloat32 || color_type == PlyFloat64) )
+        layout.color_scale = 255.0f;
+
+    layout.n_columns = 0;
+    for (int k = 0; k < 3; ++k)
+    {
+        layout.n_columns = std::max(layout.n_columns, layout.position[k]+1);
+        if ( _m.has_normals ) layout.n_columns = std::max(layout.n_columns, layout.normal[k]+1);
+        if ( _m.has_colors )  layout.n_columns = std::max(layout.n_columns, layout.color[k]+1);
+    }
+    if ( layout.n_columns > 32 )
+        return false;
+
+    if ( format == "ascii" )
+        return parse_ascii_records(p, _end, ve.count, fe.count, layout, _m);
+
+    /// binary, little endian hosts only
+    const unsigned int one = 1;
+    if ( format != "binary_little_endian" || *reinterpret_cast<const unsigned char*>(&one) != 1 )
+        return false;
+
+    /// vertices: fixed size records, read in parallel
+    std::vector<size_t> offset(ve.properties.size());
+    size_t stride = 0;
+    for (size_t i = 0; i < ve.properties.size(); ++i)
+    {
+        offset[i] = stride;
+        stride   += ply_size(ve.properties[i].type);
+    }
+    const size_t nv = ve.count;
+    if ( static_cast<size_t>(_end-p) < nv*stride )
+        return false;
+
+    _m.n_vertices = nv;
+    _m.points.resize(3*nv);
+    if ( _m.has_normals ) _m.normals.resize(3*nv);
+    if ( _m.has_colors )  _m.colors.resize(3*nv);
+
+    const char* vdata = p;
+    const long  n = static_cast<long>(nv);
+#pragma omp parallel for schedule(static)
+    for (long i = 0; i < n; ++i)
+    {
+        const char* rec = vdata + i*stride;
+        for (int k = 0; k < 3; ++k)
+        {
+            _m.points[3*i+k] = static_cast<float>(
+                ply_read(rec+offset[layout.position[k]], ve.properties[layout.position[k]].type));
+            if ( _m.has_normals )
+                _m.normals[3*i+k] = static_cast<float>(
+                    ply_read(rec+offset[layout.normal[k]], ve.properties[layout.normal[k]].type));
+            if ( _m.has_colors )
+            {
+                double c = ply_read(rec+offset[layout.color[k]], color_type)*layout.color_scale;
+                _m.colors[3*i+k] = static_cast<unsigned char>(std::max(0.0, std::min(255.0, c)));
+            }
+        }
+    }
+    p += nv*stride;
+
+    /// faces: list first, then optional fixed size properties
+    const PlyType count_type = fe.properties[0].count_type;
+    const PlyType index_type = fe.properties[0].type;
+    size_t trailing = 0;
+    for (size_t i = 1; i < fe.properties.size(); ++i)
+    {
+        if ( fe.properties[i].count_type != PlyNone )
+            return false;
+        trailing += ply_size(fe.properties[i].type);
+    }
+
+    const size_t nf      = fe.count;
+    const size_t csize   = ply_size(count_type), isize = ply_size(index_type);
+    const size_t fstride = csize + 3*isize + trailing;
+    const char*  fdata   = p;
+    int errors = 0;
+
+    /// all triangles (the common case): fixed stride, parallel
+    bool all_triangles = static_cast<size_t>(_end-p) >= nf*fstride;
+    if ( all_triangles )
+    {
+        const long m = static_cast<long>(nf);
+        int others = 0;
+#pragma omp parallel for schedule(static) reduction(+:others)
+        for (long f = 0; f < m; ++f)
+            if ( ply_read(fdata + f*fstride, count_type) != 3 )
+                ++others;
+        all_triangles = (others == 0);
+    }
+
+    if ( all_triangles )
+    {
+        _m.triangles.resize(3*nf);
+        const long m = static_cast<long>(nf);
+#pragma omp parallel for schedule(static) reduction(+:errors)
+        for (long f = 0; f < m; ++f)
+        {
+            const char* rec = fdata + f*fstride + csize;
+            for (int k = 0; k < 3; ++k)
+            {
+                double idx = ply_read(rec + k*isize, index_type);
+                if ( idx < 0 || idx >= nv ) ++errors;
+                _m.triangles[3*f+k] = static_cast<unsigned int>(idx);
+            }
+        }
+    }
+    else
+    {
+        /// polygons: variable size records, walk them in order
+        for (size_t f = 0; f < nf && !errors; ++f)
+        {
+            if ( static_cast<size_t>(_end-p) < csize )
+                return false;
+            const long k = static_cast<long>(ply_read(p, count_type));
+            p += csize;
+            if ( k < 3 || static_cast<size_t>(_end-p) < k*isize + trailing )
+                return false;
+
+            const double first = ply_read(p, index_type);
+            for (long j = 2; j < k; ++j)
+            {
+                const double b = ply_read(p + (j-1)*isize, index_type);
+                const double c = ply_read(p + j*isize,     index_type);
+                if ( first < 0 || first >= nv || b < 0 || b >= nv || c < 0 || c >= nv )
+                    ++errors;
+                _m.triangles.push_back(static_cast<unsigned int>(first));
+                _m.triangles.push_back(static_cast<unsigned int>(b));
+                _m.triangles.push_back(static_cast<unsigned int>(c));
+            }
+            p += k*isize + trailing;
+        }
+    }
+    return errors == 0;
+}
+
+//-----------------------------------------------------------------------------
+// mesh construction
+//-----------------------------------------------------------------------------
+/// Copy the arrays into _mesh. Vertex attributes are written in parallel
+/// straight into the property arrays; faces go through add_face(), which has
+/// to stay sequential. Faces add_face() rejects get their own copies of the
+/// vertices, as OpenMesh's importer does; _skipped and _split count the
+/// dropped and the detached faces.
+static void fill_mesh(TCMesh& _mesh, const ParsedMesh& _m, OpenMesh::IO::Options& _opt,
+                      size_t& _skipped, size_t& _split)
+{
+    typedef TCMesh::Point  Point;
+    typedef TCMesh::Normal Normal;
+    typedef TCMesh::Color  Color;
+
+    const bool normals = _m.has_normals && _opt.check(OpenMesh::IO::Options::VertexNormal) &&
+                         _mesh.has_vertex_normals();
+    const bool colors  = _m.has_colors  && _opt.check(OpenMesh::IO::Options::VertexColor) &&
+                         _mesh.has_vertex_colors();
+
+    const size_t nv = _m.n_vertices, nf = _m.triangles.size()/3;
+    _skipped = _split = 0;
+    _mesh.clear();
+    _mesh.resize(nv, 0, 0);
+    _mesh.reserve(nv, 3*nf/2+nf/8, nf);
+
+    const long n = static_cast<long>(nv);
+#pragma omp parallel for schedule(static)
+    for (long i = 0; i < n; ++i)
+    {
+        TCMesh::VertexHandle vh(static_cast<int>(i));
+        _mesh.set_point(vh, Point(_m.points[3*i], _m.points[3*i+1], _m.points[3*i+2]));
+        if ( normals )
+            _mesh.set_normal(vh, Normal(_m.normals[3*i], _m.normals[3*i+1], _m.normals[3*i+2]));
+        if ( colors )
+            _mesh.set_color(vh, Color(_m.colors[3*i], _m.colors[3*i+1], _m.colors[3*i+2]));
+    }
+
+    for (size_t f = 0; f < nf; ++f)
+    {
+        TCMesh::VertexHandle v[3];
+        for (int k = 0; k < 3; ++k)
+            v[k] = TCMesh::VertexHandle(static_cast<int>(_m.triangles[3*f+k]));
+        if ( v[0] == v[1] || v[1] == v[2] || v[0] == v[2] )
+        {
+            ++_skipped;
+            continue;
+        }
+
+        if ( !_mesh.add_face(v[0], v[1], v[2]).is_valid() )
+        {
+            ++_split;
+            for (int k = 0; k < 3; ++k)
+            {
+                TCMesh::VertexHandle copy = _mesh.add_vertex(_mesh.point(v[k]));
+                if ( normals ) _mesh.set_normal(copy, _mesh.normal(v[k]));
+                if ( colors )  _mesh.set_color(copy, _mesh.color(v[k]));
+                v[k] = copy;
+            }
+            _mesh.add_face(v[0], v[1], v[2]);
+        }
+    }
+
+    OpenMesh::IO::Options provided;
+    if ( normals ) provided += OpenMesh::IO::Options::VertexNormal;
+    if ( colors )  provided += OpenMesh::IO::Options::VertexColor;
+    _opt = provided;
+}
+
+//-----------------------------------------------------------------------------
+bool fast_read_mesh(TCMesh& _mesh, const QString& _filename,
+                    OpenMesh::IO::Options& _opt, MeshReadStats* _stats)
+{
+    const QString suffix = QFileInfo(_filename).suffix().toLower();
+    if ( suffix != "off" && suffix != "obj" && suffix != "ply" )
+        return false;
+
+    QFile file(_filename);
+    if ( !file.open(QIODevice::ReadOnly) || file.size() == 0 )
+        return false;
+    const char* begin = reinterpret_cast<const char*>(file.map(0, file.size()));
+    if ( !begin )
+        return false;
+    const char* end = begin + file.size();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    ParsedMesh m;
+    bool ok = false;
+    if ( suffix == "off" )
+        ok = parse_off(begin, end, m);
+    else if ( suffix == "obj" )
+        ok = parse_obj(begin, end, m);
+    else if ( end-begin >= 3 && std::strncmp(begin, "ply", 3) == 0 )
+        ok = parse_ply(begin, end, m);
+    if ( !ok || m.triangles.empty() )
+        return false;
+
+    const double parse_seconds = timer.nsecsElapsed()*1e-9;
+    timer.restart();
+    size_t skipped, split;
+    fill_mesh(_mesh, m, _opt, skipped, split);
+
+    if ( _stats )
+    {
+        _stats->bytes         = file.size();
+        _stats->parse_seconds = parse_seconds;
+        _stats->build_seconds = timer.nsecsElapsed()*1e-9;
+        _stats->threads       = n_threads();
+        _stats->fast          = true;
+        _stats->skipped_faces = skipped;
+        _stats->split_faces   = split;
+    }
+    return true;
+}
+
+bool read_mesh_fast(TCMesh& _mesh, const QString& _filename,
+                    OpenMesh::IO::Options& _opt, MeshReadStats* _stats)
+{
+    if ( fast_read_mesh(_mesh, _filename, _opt, _stats) )
+        return true;
+
+    if ( _stats )
+    {
+        *_stats = MeshReadStats();
+        _stats->bytes = QFileInfo(_filename).size();
+    }
+    return OpenMesh::IO::read_mesh(_mesh, _filename.toLocal8Bit().constData(), _opt);
+}
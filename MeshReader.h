@@ -0,0 +1,46 @@
+#ifndef MESHREADER_H
+#define MESHREADER_H
+
+//== INCLUDES =================================================================
+#include <cstddef>
+
+#include <QString>
+#include <OpenMesh/Core/IO/Options.hh>
+
+#include "TCMesh.h"
+
+//== TYPES ====================================================================
+/// what a read cost, for the load log
+struct MeshReadStats
+{
+    MeshReadStats() : bytes(0), parse_seconds(0), build_seconds(0), threads(1), fast(false),
+                      skipped_faces(0), split_faces(0) {}
+
+    size_t bytes;          ///< file size
+    double parse_seconds;  ///< fast path: text/binary to arrays
+    double build_seconds;  ///< fast path: arrays to halfedge mesh
+    int    threads;
+    bool   fast;           ///< false if OpenMesh read the file
+    size_t skipped_faces;  ///< fast path: faces repeating a vertex, dropped
+    size_t split_faces;    ///< fast path: non-manifold faces given own vertices
+};
+
+//== FUNCTIONS ================================================================
+/// Parallel reader for large triangle meshes in ASCII OFF, OBJ and ASCII or
+/// little endian binary PLY. The file is memory mapped and cut into line
+/// aligned chunks that are parsed concurrently into flat arrays, which are
+/// then copied into _mesh in bulk. Polygons are fan triangulated.
+/// Returns false without touching _mesh for anything it does not handle
+/// (other formats, texture coordinates, per-vertex colors in OFF, face
+/// colors, ...).
+/// On success _opt holds the requested attributes the file provided.
+bool fast_read_mesh(TCMesh& _mesh, const QString& _filename,
+                    OpenMesh::IO::Options& _opt, MeshReadStats* _stats=0);
+
+/// fast_read_mesh(), falling back to OpenMesh::IO::read_mesh()
+bool read_mesh_fast(TCMesh& _mesh, const QString& _filename,
+                    OpenMesh::IO::Options& _opt, MeshReadStats* _stats=0);
+
+//=============================================================================
+#endif // MESHREADER_H defined
+//=============================================================================
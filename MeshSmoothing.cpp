@@ -0,0 +1,86 @@
+//== INCLUDES =================================================================
+#include "MeshSmoothing.h"
+
+//== IMPLEMENTATION ==========================================================
+typedef TCMesh::Point Point;
+
+size_t VertexAdjacency::bytes() const
+{
+    return offsets.capacity()*sizeof(unsigned int) +
+           neighbors.capacity()*sizeof(unsigned int) +
+           boundary.capacity()*sizeof(unsigned char);
+}
+
+void build_vertex_adjacency(const TCMesh& _mesh, VertexAdjacency& _adj)
+{
+    const int n = static_cast<int>(_mesh.n_vertices());
+    _adj.offsets.assign(n+1, 0);
+    _adj.boundary.resize(n);
+
+    /// row lengths, then their prefix sum
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; ++i)
+    {
+        TCMesh::VertexHandle vh(i);
+        _adj.offsets[i+1] = _mesh.valence(vh);
+        _adj.boundary[i]  = _mesh.is_boundary(vh) ? 1 : 0;
+    }
+    for (int i = 0; i < n; ++i)
+        _adj.offsets[i+1] += _adj.offsets[i];
+
+    _adj.neighbors.resize(_adj.offsets[n]);
+
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; ++i)
+    {
+        unsigned int* row = _adj.neighbors.data() + _adj.offsets[i];
+        for (TCMesh::ConstVertexVertexIter vv_it=_mesh.cvv_iter(TCMesh::VertexHandle(i)); vv_it.is_valid(); ++vv_it)
+            *row++ = vv_it->idx();
+    }
+}
+
+void laplacian_step(const VertexAdjacency& _adj, const Point* _in, Point* _out, float _factor)
+{
+    const int n = static_cast<int>(_adj.boundary.size());
+
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; ++i)
+    {
+        const unsigned int begin = _adj.offsets[i], end = _adj.offsets[i+1];
+        if ( _adj.boundary[i] || begin == end )
+        {
+            _out[i] = _in[i];
+            continue;
+        }
+
+        Point c(0,0,0);
+        for (unsigned int j = begin; j < end; ++j)
+            c += _in[_adj.neighbors[j]];
+        c /= static_cast<float>(end-begin);
+        _out[i] = _in[i] + _factor*(c - _in[i]);
+    }
+}
+
+void smooth_iteration(const VertexAdjacency& _adj, Point* _points,
+                      std::vector<Point>& _scratch, bool _taubin, float _lambda)
+{
+    const int n = static_cast<int>(_adj.boundary.size());
+    _scratch.resize(n);
+    if ( !n )
+        return;
+
+    laplacian_step(_adj, _points, &_scratch[0], _lambda);
+
+    if ( _taubin )
+    {
+        /// pass band frequency 0.1
+        const float mu = 1.0f/(0.1f - 1.0f/_lambda);
+        laplacian_step(_adj, &_scratch[0], _points, mu);
+    }
+    else
+    {
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; ++i)
+            _points[i] = _scratch[i];
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef MESHSMOOTHING_H
+#define MESHSMOOTHING_H
+
+//== INCLUDES =================================================================
+#include <vector>
+
+#include "TCMesh.h"
+
+//== CLASS DEFINITION =========================================================
+/// One-ring neighbors of every vertex in compressed rows: the neighbors of
+/// vertex i are neighbors[offsets[i]] .. neighbors[offsets[i+1]-1].
+struct VertexAdjacency
+{
+    std::vector<unsigned int>  offsets;    // n_vertices+1
+    std::vector<unsigned int>  neighbors;
+    std::vector<unsigned char> boundary;   // 1 for boundary vertices
+
+    size_t bytes() const;
+};
+
+//== FUNCTIONS ================================================================
+/// Umbrella operator smoothing over a VertexAdjacency, Jacobi style: every
+/// step reads one position array and writes the other, so all vertices move
+/// in parallel without locking. Boundary vertices stay fixed.
+
+/// fill _adj from the connectivity of _mesh, in parallel over vertices
+void build_vertex_adjacency(const TCMesh& _mesh, VertexAdjacency& _adj);
+
+/// _out[i] = _in[i] + _factor * (mean of the neighbors - _in[i])
+void laplacian_step(const VertexAdjacency& _adj, const TCMesh::Point* _in,
+                    TCMesh::Point* _out, float _factor);
+
+/// One iteration on _points in place, through _scratch. Laplacian moves by
+/// _lambda; Taubin follows with a step of mu = 1/(0.1 - 1/_lambda), which
+/// cancels the shrinking of the first one.
+void smooth_iteration(const VertexAdjacency& _adj, TCMesh::Point* _points,
+                      std::vector<TCMesh::Point>& _scratch, bool _taubin, float _lambda);
+
+//=============================================================================
+#endif // MESHSMOOTHING_H defined
+//=============================================================================
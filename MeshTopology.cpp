@@ -0,0 +1,197 @@
+//== INCLUDES =================================================================
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#include "MeshTopology.h"
+
+//== IMPLEMENTATION ==========================================================
+typedef TCMesh::Point Point;
+
+/// Concurrent union-find: roots are linked below the smaller index with a
+/// compare-and-swap, finds halve their paths. The root of every set is
+/// therefore its smallest element.
+class UnionFind
+{
+public:
+    explicit UnionFind(size_t _n) : parent_(_n)
+    {
+        const long n = static_cast<long>(_n);
+#pragma omp parallel for schedule(static)
+        for (long i = 0; i < n; ++i)
+            parent_[i].store(static_cast<unsigned int>(i), std::memory_order_relaxed);
+    }
+
+    unsigned int find(unsigned int _x)
+    {
+        unsigned int p = parent_[_x].load(std::memory_order_relaxed);
+        while ( p != _x )
+        {
+            unsigned int gp = parent_[p].load(std::memory_order_relaxed);
+            if ( gp != p )
+                parent_[_x].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+            _x = p;
+            p  = parent_[_x].load(std::memory_order_relaxed);
+        }
+        return _x;
+    }
+
+    void unite(unsigned int _a, unsigned int _b)
+    {
+        for (;;)
+        {
+            _a = find(_a);
+            _b = find(_b);
+            if ( _a == _b )
+                return;
+            if ( _a < _b )
+                std::swap(_a, _b);
+            unsigned int expected = _a;
+            if ( parent_[_a].compare_exchange_strong(expected, _b, std::memory_order_relaxed) )
+                return;
+        }
+    }
+
+private:
+    std::vector< std::atomic<unsigned int> > parent_;
+};
+
+//-----------------------------------------------------------------------------
+void analyze_topology(const TCMesh& _mesh, TopologyReport& _report,
+                      std::vector<unsigned int>* _components)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    _report = TopologyReport();
+
+    const long nv = static_cast<long>(_mesh.n_vertices());
+    const long ne = static_cast<long>(_mesh.n_edges());
+    const long nf = static_cast<long>(_mesh.n_faces());
+
+    /// components: every face joins its vertices
+    UnionFind sets(nv);
+    size_t degenerate = 0;
+
+#pragma omp parallel for schedule(static) reduction(+:degenerate)
+    for (long f = 0; f < nf; ++f)
+    {
+        TCMesh::ConstFaceVertexIter fv_it = _mesh.cfv_iter(TCMesh::FaceHandle(static_cast<int>(f)));
+        unsigned int v[3] = { 0, 0, 0 };
+        int k = 0;
+        for (; k < 3 && fv_it.is_valid(); ++k, ++fv_it)
+            v[k] = fv_it->idx();
+        if ( k < 3 )
+            continue;
+
+        sets.unite(v[0], v[1]);
+        sets.unite(v[0], v[2]);
+
+        /// zero area: sin^2 of the angle at v[0] vanishes, which also
+        /// catches zero length edges and repeated vertices
+        const Point& p0 = _mesh.point(TCMesh::VertexHandle(v[0]));
+        const Point  e1 = _mesh.point(TCMesh::VertexHandle(v[1])) - p0;
+        const Point  e2 = _mesh.point(TCMesh::VertexHandle(v[2])) - p0;
+        if ( (e1 % e2).sqrnorm() <= 1e-12f*e1.sqrnorm()*e2.sqrnorm() )
+            ++degenerate;
+    }
+
+    /// per vertex: component roots, isolated and non-manifold vertices
+    size_t components = 0, isolated = 0, nonmanifold = 0;
+    std::vector<unsigned char> root(nv, 0);
+
+#pragma omp parallel for schedule(static) reduction(+:components,isolated,nonmanifold)
+    for (long i = 0; i < nv; ++i)
+    {
+        TCMesh::VertexHandle vh(static_cast<int>(i));
+        const bool alone = _mesh.is_isolated(vh);
+        if ( alone )
+            ++isolated;
+        else if ( !_mesh.is_manifold(vh) )
+            ++nonmanifold;
+        if ( sets.find(static_cast<unsigned int>(i)) == static_cast<unsigned int>(i) )
+        {
+            root[i] = 1;
+            if ( !alone )
+                ++components;
+        }
+    }
+
+    /// boundary halfedges, collected in parallel, then walked loop by loop
+    std::vector<unsigned int> boundary;
+#pragma omp parallel
+    {
+        std::vector<unsigned int> local;
+#pragma omp for schedule(static) nowait
+        for (long e = 0; e < ne; ++e)
+            for (int s = 0; s < 2; ++s)
+            {
+                TCMesh::HalfedgeHandle hh = _mesh.halfedge_handle(TCMesh::EdgeHandle(static_cast<int>(e)), s);
+                if ( _mesh.is_boundary(hh) )
+                    local.push_back(hh.idx());
+            }
+#pragma omp critical
+        boundary.insert(boundary.end(), local.begin(), local.end());
+    }
+    std::sort(boundary.begin(), boundary.end());
+
+    size_t loops = 0;
+    std::vector<unsigned char> visited(boundary.size(), 0);
+    for (size_t i = 0; i < boundary.size(); ++i)
+    {
+        if ( visited[i] )
+            continue;
+        ++loops;
+
+        TCMesh::HalfedgeHandle hh(static_cast<int>(boundary[i]));
+        for (size_t steps = 0; steps < boundary.size(); ++steps)
+        {
+            std::vector<unsigned int>::const_iterator it =
+                std::lower_bound(boundary.begin(), boundary.end(), static_cast<unsigned int>(hh.idx()));
+            if ( it == boundary.end() || *it != static_cast<unsigned int>(hh.idx()) ||
+                 visited[it-boundary.begin()] )
+                break;
+            visited[it-boundary.begin()] = 1;
+            hh = _mesh.next_halfedge_handle(hh);
+        }
+    }
+
+    /// component index per vertex, in order of the roots
+    if ( _components )
+    {
+        std::vector<unsigned int> index(nv);
+        unsigned int count = 0;
+        for (long i = 0; i < nv; ++i)
+        {
+            index[i] = count;
+            count += root[i];
+        }
+
+        _components->resize(nv);
+#pragma omp parallel for schedule(static)
+        for (long i = 0; i < nv; ++i)
+            (*_components)[i] = index[sets.find(static_cast<unsigned int>(i))];
+    }
+
+    _report.components           = components;
+    _report.isolated_vertices    = isolated;
+    _report.boundary_loops       = loops;
+    _report.boundary_edges       = boundary.size();
+    _report.nonmanifold_vertices = nonmanifold;
+    _report.degenerate_faces     = degenerate;
+    _report.euler_characteristic = nv - ne + nf;
+    _report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::ostream& operator<<(std::ostream& _os, const TopologyReport& _report)
+{
+    _os << _report.components << " connected components, "
+        << _report.boundary_loops << " boundary loops ("
+        << _report.boundary_edges << " edges), Euler characteristic "
+        << _report.euler_characteristic << " [" << _report.seconds << " s]\n";
+    if ( _report.isolated_vertices )
+        _os << "! " << _report.isolated_vertices << " isolated vertices\n";
+    if ( _report.nonmanifold_vertices )
+        _os << "! " << _report.nonmanifold_vertices << " non-manifold vertices\n";
+    if ( _report.degenerate_faces )
+        _os << "! " << _report.degenerate_faces << " degenerate faces\n";
+    return _os;
+}
@@ -0,0 +1,44 @@
+#ifndef MESHTOPOLOGY_H
+#define MESHTOPOLOGY_H
+
+//== INCLUDES =================================================================
+#include <vector>
+#include <ostream>
+
+#include "TCMesh.h"
+
+//== TYPES ====================================================================
+/// what analyze_topology() found
+struct TopologyReport
+{
+    TopologyReport() : components(0), isolated_vertices(0), boundary_loops(0),
+                       boundary_edges(0), nonmanifold_vertices(0), degenerate_faces(0),
+                       euler_characteristic(0), seconds(0) {}
+
+    size_t components;            ///< edge connected components with faces
+    size_t isolated_vertices;     ///< vertices without faces
+    size_t boundary_loops;
+    size_t boundary_edges;
+    size_t nonmanifold_vertices;  ///< more than one fan of faces
+    size_t degenerate_faces;      ///< zero area or repeated vertices
+    long   euler_characteristic;  ///< V - E + F
+    double seconds;
+};
+
+//== FUNCTIONS ================================================================
+/// One parallel pass over a TCMesh: lock-free union-find over the face edges
+/// for the components, per-vertex and per-face checks for the rest, and a
+/// walk along the boundary halfedges for the loops. Non-manifold edges
+/// cannot be represented by the halfedge structure; readers split them
+/// while loading (see MeshReadStats::split_faces).
+/// With _components given, it receives the component index of every
+/// vertex, isolated vertices included, numbered in order of first vertex.
+void analyze_topology(const TCMesh& _mesh, TopologyReport& _report,
+                      std::vector<unsigned int>* _components=0);
+
+/// one line per finding, warnings marked with '!'
+std::ostream& operator<<(std::ostream& _os, const TopologyReport& _report);
+
+//=============================================================================
+#endif // MESHTOPOLOGY_H defined
+//=============================================================================
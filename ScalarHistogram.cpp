@@ -0,0 +1,143 @@
+//== INCLUDES =================================================================
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "ScalarHistogram.h"
+
+//== IMPLEMENTATION ==========================================================
+void ScalarHistogram::compute(const float* _values, size_t _n)
+{
+    const long n = static_cast<long>(_n);
+
+    /// range
+    float lo =  std::numeric_limits<float>::max();
+    float hi = -std::numeric_limits<float>::max();
+#pragma omp parallel for reduction(min:lo) reduction(max:hi)
+    for (long i = 0; i < n; ++i)
+    {
+        const float v = _values[i];
+        if ( std::isfinite(v) )
+        {
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+    }
+
+    if ( lo > hi )
+    {
+        bins_.assign(n_bins_, 0);
+        min_ = max_ = lo_ = hi_ = 0;
+        n_ = under_ = over_ = 0;
+        return;
+    }
+    min_ = lo;
+    max_ = hi;
+
+    /// bin, and zoom in on the central 99.8% while it covers too few bins
+    for (int pass = 0; pass < 4; ++pass)
+    {
+        bin(_values, n, lo, hi);
+
+        float p_lo = percentile(0.001f), p_hi = percentile(0.999f);
+        float width = (hi_-lo_)/n_bins_;
+        if ( width <= 0.0f || (p_hi-p_lo) >= 0.25f*n_bins_*width )
+            break;
+
+        float new_lo = lo_ + std::floor((p_lo-lo_)/width)*width;
+        float new_hi = lo_ + std::ceil ((p_hi-lo_)/width)*width;
+        if ( new_hi <= new_lo || (new_lo <= lo && new_hi >= hi) )
+            break;
+        lo = std::max(new_lo, lo);
+        hi = std::min(new_hi, hi);
+    }
+}
+
+void ScalarHistogram::bin(const float* _values, long _n, float _lo, float _hi)
+{
+    bins_.assign(n_bins_, 0);
+    lo_ = _lo;
+    hi_ = _hi;
+
+    const float scale = (_hi > _lo) ? n_bins_/(_hi-_lo) : 0.0f;
+    size_t total = 0, under = 0, over = 0;
+
+#pragma omp parallel reduction(+:total,under,over)
+    {
+        /// per-thread bins, merged at the end
+        std::vector<size_t> local(n_bins_, 0);
+
+#pragma omp for nowait
+        for (long i = 0; i < _n; ++i)
+        {
+            const float v = _values[i];
+            if ( !std::isfinite(v) )
+                continue;
+            ++total;
+            if ( v < _lo )
+                ++under;
+            else if ( v > _hi )
+                ++over;
+            else
+                ++local[std::min(static_cast<int>((v-_lo)*scale), n_bins_-1)];
+        }
+
+#pragma omp critical
+        for (int b = 0; b < n_bins_; ++b)
+            bins_[b] += local[b];
+    }
+
+    n_     = total;
+    under_ = under;
+    over_  = over;
+}
+
+float ScalarHistogram::percentile(float _p) const
+{
+    if ( n_ == 0 )
+        return 0.0f;
+    if ( _p <= 0.0f )
+        return min_;
+    if ( _p >= 1.0f )
+        return max_;
+
+    const double target = _p*n_;
+
+    /// tails are only known by their extent, interpolate linearly
+    if ( target <= under_ )
+        return min_ + static_cast<float>(target/under_)*(lo_-min_);
+
+    const float width = (hi_-lo_)/n_bins_;
+    double sum = under_;
+    for (int b = 0; b < n_bins_; ++b)
+    {
+        if ( bins_[b] && sum+bins_[b] >= target )
+        {
+            /// linear interpolation inside the bin
+            float t = static_cast<float>((target-sum)/bins_[b]);
+            return lo_ + (b+t)*width;
+        }
+        sum += bins_[b];
+    }
+
+    if ( over_ )
+        return hi_ + static_cast<float>((target-sum)/over_)*(max_-hi_);
+    return hi_;
+}
+
+void ScalarHistogram::counts(float _lo, float _hi, int _n, std::vector<size_t>& _out) const
+{
+    _out.assign(_n, 0);
+    if ( n_ == 0 || _n <= 0 || _hi <= _lo )
+        return;
+
+    const float width = (hi_-lo_)/n_bins_;
+    for (int b = 0; b < n_bins_; ++b)
+    {
+        const float center = lo_ + (b+0.5f)*width;
+        if ( center < _lo || center > _hi )
+            continue;
+        int slot = static_cast<int>((center-_lo)/(_hi-_lo)*_n);
+        _out[std::min(slot, _n-1)] += bins_[b];
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef SCALARHISTOGRAM_H
+#define SCALARHISTOGRAM_H
+
+//== INCLUDES =================================================================
+#include <vector>
+#include <cstddef>
+
+//== CLASS DEFINITION =========================================================
+/// Fixed-bin histogram of a scalar field. Built once per field in a few
+/// parallel passes; percentiles and rebinned counts are answered from the bins
+/// alone, so changing the color range never touches the mesh again.
+/// The bins cover the bulk of the data only: when outliers squeeze nearly all
+/// samples into a handful of bins, the binned range is narrowed and the tails
+/// are kept as underflow/overflow counts.
+class ScalarHistogram
+{
+public:
+    explicit ScalarHistogram(int _n_bins=1024)
+        : n_bins_(_n_bins), min_(0), max_(0), lo_(0), hi_(0),
+          n_(0), under_(0), over_(0) {}
+
+    /// bin _n values, non-finite values are ignored
+    void compute(const float* _values, size_t _n);
+
+    bool   empty()  const { return n_ == 0; }
+    float  min()    const { return min_; }
+    float  max()    const { return max_; }
+    /// range covered by the bins
+    float  lo()     const { return lo_; }
+    float  hi()     const { return hi_; }
+    size_t n_values() const { return n_; }
+    const std::vector<size_t>& bins() const { return bins_; }
+
+    /// value below which _p (in [0,1]) of all samples lie
+    float percentile(float _p) const;
+
+    /// rebin the counts falling into [_lo,_hi] into _n equal slots
+    void counts(float _lo, float _hi, int _n, std::vector<size_t>& _out) const;
+
+private:
+    /// count _values into bins over [_lo,_hi]
+    void bin(const float* _values, long _n, float _lo, float _hi);
+
+private:
+    int                 n_bins_;
+    float               min_, max_;
+    float               lo_, hi_;
+    size_t              n_, under_, over_;
+    std::vector<size_t> bins_;
+};
+
+//=============================================================================
+#endif // SCALARHISTOGRAM_H defined
+//=============================================================================
@@ -0,0 +1,150 @@
+//== INCLUDES =================================================================
+#include <QtConcurrent/QtConcurrentRun>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cstring>
+
+#include "ScalarSequence.h"
+
+//== IMPLEMENTATION ==========================================================
+namespace {
+
+/// touch one byte per page of [_data,_data+_bytes), returns the seconds
+double page_in(const uchar* _data, size_t _bytes)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const size_t page = 4096;
+    unsigned int sum = 0;
+    for (size_t i = 0; i < _bytes; i += page)
+        sum += _data[i];
+    if ( _bytes )
+        sum += _data[_bytes-1];
+    volatile unsigned int sink = sum;
+    (void)sink;
+
+    return 1e-9*timer.nsecsElapsed();
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+ScalarSequence::ScalarSequence()
+    : data_(0), n_values_(0), n_frames_(0), prefetch_frame_(0), prefetch_counted_(true)
+{
+    reset_stats();
+}
+
+ScalarSequence::~ScalarSequence()
+{
+    close();
+}
+
+bool ScalarSequence::open(const QString& _file, size_t _n_values)
+{
+    close();
+    if ( !_n_values )
+        return false;
+
+    file_.setFileName(_file);
+    if ( !file_.open(QIODevice::ReadOnly) )
+        return false;
+
+    const size_t bytes = static_cast<size_t>(file_.size());
+    const size_t frame = _n_values*sizeof(float);
+    if ( bytes == 0 || bytes % frame != 0 )
+    {
+        file_.close();
+        return false;
+    }
+
+    data_ = file_.map(0, file_.size());
+    if ( !data_ )
+    {
+        file_.close();
+        return false;
+    }
+    n_values_ = _n_values;
+    n_frames_ = bytes/frame;
+    reset_stats();
+    return true;
+}
+
+void ScalarSequence::close()
+{
+    /// the prefetch reads the mapping
+    prefetch_.waitForFinished();
+    prefetch_counted_ = true;
+
+    if ( data_ )
+        file_.unmap(const_cast<uchar*>(data_));
+    file_.close();
+    data_ = 0;
+    n_values_ = n_frames_ = 0;
+}
+
+void ScalarSequence::read(size_t _i, float* _out)
+{
+    if ( !data_ || _i >= n_frames_ )
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if ( !prefetch_counted_ && prefetch_frame_ == _i )
+        prefetch_.waitForFinished();
+    std::memcpy(_out, data_ + _i*frame_bytes(), frame_bytes());
+
+    read_bytes_   += frame_bytes();
+    read_seconds_ += 1e-9*timer.nsecsElapsed();
+
+    prefetch((_i+1) % n_frames_);
+}
+
+void ScalarSequence::prefetch(size_t _i)
+{
+    if ( !data_ || _i >= n_frames_ || prefetch_.isRunning() )
+        return;
+    collect_prefetch();
+
+    prefetch_frame_   = _i;
+    prefetch_counted_ = false;
+    prefetch_ = QtConcurrent::run(page_in, data_ + _i*frame_bytes(), frame_bytes());
+}
+
+void ScalarSequence::collect_prefetch()
+{
+    if ( prefetch_counted_ )
+        return;
+    paged_bytes_     += frame_bytes();
+    paged_seconds_   += prefetch_.result();
+    prefetch_counted_ = true;
+}
+
+void ScalarSequence::sample_histogram(ScalarHistogram& _histogram, size_t _frames) const
+{
+    if ( !data_ )
+        return;
+
+    /// every k-th value of k frames keeps the sample at one frame's size
+    const size_t k = std::max<size_t>(1, std::min(_frames, n_frames_));
+    std::vector<float> sample;
+    sample.reserve(n_values_ + k);
+    for (size_t f = 0; f < k; ++f)
+    {
+        const size_t frame = (k > 1) ? f*(n_frames_-1)/(k-1) : 0;
+        const float* values = reinterpret_cast<const float*>(data_ + frame*frame_bytes());
+        for (size_t i = f % k; i < n_values_; i += k)
+            sample.push_back(values[i]);
+    }
+    _histogram.compute(sample.empty() ? 0 : &sample[0], sample.size());
+}
+
+void ScalarSequence::reset_stats()
+{
+    paged_bytes_ = paged_seconds_ = 0.0;
+    read_bytes_  = read_seconds_  = 0.0;
+}
+
+//=============================================================================
@@ -0,0 +1,80 @@
+#ifndef SCALARSEQUENCE_H
+#define SCALARSEQUENCE_H
+
+//== INCLUDES =================================================================
+#include <vector>
+#include <cstddef>
+
+#include <QString>
+#include <QFile>
+#include <QFuture>
+
+#include "ScalarHistogram.h"
+
+//== CLASS DEFINITION =========================================================
+/// Time-varying per-vertex data (scalars, or the positions of a
+/// VertexAnimation) streamed from a file of raw little endian float32
+/// frames, n_values() floats each and back to back, with no header: the
+/// frame count follows from the file size.
+/// The file is memory mapped; the frame after the one just read is paged in
+/// on a pool thread, so a player stepping forward finds its frames resident
+/// and only copies them. Bytes and seconds of both sides are counted for a
+/// throughput report.
+class ScalarSequence
+{
+public:
+    ScalarSequence();
+    ~ScalarSequence();
+
+    /// map _file as frames of _n_values floats; false if it cannot be
+    /// mapped or its size is no multiple of the frame size
+    bool open(const QString& _file, size_t _n_values);
+    void close();
+    bool is_open() const { return data_ != 0; }
+
+    const QString& file_name() const { return file_.fileName(); }
+    size_t n_values() const    { return n_values_; }
+    size_t n_frames() const    { return n_frames_; }
+    size_t frame_bytes() const { return n_values_*sizeof(float); }
+
+    /// Copy frame _i into _out[0..n_values()), waiting for its prefetch if
+    /// that is still running, then prefetch frame _i+1 (wrapping around)
+    void read(size_t _i, float* _out);
+    /// page frame _i in on a pool thread, unless a prefetch is running
+    void prefetch(size_t _i);
+
+    /// Histogram of an evenly strided sample of up to _frames frames spread
+    /// over the sequence, about n_values() samples in all: one color range
+    /// for every frame
+    void sample_histogram(ScalarHistogram& _histogram, size_t _frames=8) const;
+
+    /// bytes paged in by prefetches and the seconds they took
+    double paged_bytes() const    { return paged_bytes_; }
+    double paged_seconds() const  { return paged_seconds_; }
+    /// bytes copied by read() and the seconds it spent, waits and page
+    /// faults of frames not prefetched included
+    double read_bytes() const     { return read_bytes_; }
+    double read_seconds() const   { return read_seconds_; }
+    void   reset_stats();
+
+private:
+    /// add a finished prefetch to the counters
+    void collect_prefetch();
+
+private:
+    QFile           file_;
+    const uchar*    data_;
+    size_t          n_values_, n_frames_;
+
+    /// prefetch in flight or done, returns its seconds
+    QFuture<double> prefetch_;
+    size_t          prefetch_frame_;
+    bool            prefetch_counted_;
+
+    double          paged_bytes_, paged_seconds_;
+    double          read_bytes_, read_seconds_;
+};
+
+//=============================================================================
+#endif // SCALARSEQUENCE_H defined
+//=============================================================================
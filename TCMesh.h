@@ -0,0 +1,26 @@
+#ifndef TCMESH_H
+#define TCMESH_H
+
+//== INCLUDES =================================================================
+#include <OpenMesh/Core/Mesh/TriMesh_ArrayKernelT.hh>
+#include <OpenMesh/Core/Mesh/Traits.hh>
+
+//== CLASS DEFINITION =========================================================
+struct TCTraits : public OpenMesh::DefaultTraits
+{
+    VertexTraits
+    {
+    private:
+        float  valence;
+
+    public:
+        void set_valence (const float _val) { valence=_val; }
+        float get_valence () { return valence; }
+    };
+};
+
+typedef OpenMesh::TriMesh_ArrayKernelT<TCTraits>  TCMesh;
+
+//=============================================================================
+#endif // TCMESH_H defined
+//=============================================================================
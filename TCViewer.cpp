@@ -1,144 +1,350 @@
+#include <QtConcurrent/QtConcurrentRun>
+#include <QElapsedTimer>
+#include <QInputDialog>
+#include <QLineEdit>
+#include <QRegExp>
+#include <QImageReader>
+#include <QDir>
+#include <limits>
+#include <cmath>
+
 #include "TCViewer.h"
+#include "MeshAnalysis.h"
+#include "FrameExporter.h"
+#include "MemoryReport.h"
+#include "MeshReader.h"
+#include "MeshTopology.h"
+
+///-----------------------------------------------------------------------------
+/// construction
+///-----------------------------------------------------------------------------
+TCViewer::TCViewer(QWidget* parent)
+    : TCViewerT<TCMesh>(parent),
+      field_version_(0),
+      clip_lo_(2.0f),
+      clip_hi_(98.0f),
+      colormap_id_(0),
+      draw_overlays_(true),
+      tex_bytes_(0),
+      view_only_(false),
+      geodesic_source_(0),
+      show_isolines_(false),
+      isoline_count_(10),
+      isoline_version_(0),
+      smooth_taubin_(true),
+      smooth_lambda_(0.5f),
+      smooth_remaining_(0),
+      smooth_done_(0),
+      smooth_seconds_(0.0),
+      texture_budget_(256*1024*1024),
+      show_occlusion_(false),
+      occlusion_radius_(0.03f),
+      occlusion_rays_(64),
+      occlusion_dirty_(false),
+      active_plane_(0),
+      animation_step_(0),
+      animation_apply_seconds_(0.0),
+      sequence_frame_(0),
+      sequence_fps_(30.0),
+      sequence_start_(0),
+      sequence_steps_(0),
+      sequence_shown_(0),
+      sequence_dropped_(0),
+      watch_file_(false),
+      reload_pending_(false)
+{
+    /// writers usually touch the file several times per save, so wait for
+    /// it to settle before reloading
+    reload_timer_.setSingleShot(true);
+    reload_timer_.setInterval(300);
+
+    connect(&file_watcher_, SIGNAL(fileChanged(QString)), this, SLOT(mesh_file_changed(QString)));
+    connect(&reload_timer_, SIGNAL(timeout()), this, SLOT(start_reload()));
+    connect(&reload_watcher_, SIGNAL(finished()), this, SLOT(finish_reload()));
+
+    /// zero interval: one smoothing iteration whenever the event loop is idle
+    smooth_timer_.setInterval(0);
+    connect(&smooth_timer_, SIGNAL(timeout()), this, SLOT(smooth_step()));
+
+    connect(&tiling_watcher_, SIGNAL(finished()), this, SLOT(finish_tiling()));
+    connect(&vtex_, SIGNAL(tiles_ready()), this, SLOT(tiles_ready()));
+
+    /// edits come in bursts (smoothing, reloads): rebake once they settle
+    occlusion_timer_.setSingleShot(true);
+    occlusion_timer_.setInterval(300);
+    connect(&occlusion_timer_, SIGNAL(timeout()), this, SLOT(restart_occlusion()));
+    connect(&occlusion_watcher_, SIGNAL(finished()), this, SLOT(occlusion_pass_done()));
+
+    /// clipping planes slide along their normal only, sweeping the sections
+    clip_constraint_.setTranslationConstraint(qglviewer::AxisPlaneConstraint::AXIS,
+                                              qglviewer::Vec(0.0, 0.0, 1.0));
+    section_timer_.setSingleShot(true);
+    section_timer_.setInterval(300);
+    connect(&section_timer_, SIGNAL(timeout()), this, SLOT(restart_section_bvh()));
+    connect(&section_watcher_, SIGNAL(finished()), this, SLOT(section_bvh_done()));
+
+    /// two ticks per frame period, so timer jitter neither repeats nor
+    /// skips frames
+    sequence_timer_.setTimerType(Qt::PreciseTimer);
+    sequence_timer_.setInterval(16);
+    connect(&sequence_timer_, SIGNAL(timeout()), this, SLOT(sequence_tick()));
+}
 
 ///-----------------------------------------------------------------------------
 /// load mesh and texture
 ///-----------------------------------------------------------------------------
+void TCViewer::request_attributes(TCMesh& _mesh)
+{
+    if ( !_mesh.has_face_normals() )       _mesh.request_face_normals();
+    if ( !_mesh.has_face_colors() )        _mesh.request_face_colors();
+    if ( !_mesh.has_vertex_normals() )     _mesh.request_vertex_normals();
+    if ( !_mesh.has_vertex_colors() )      _mesh.request_vertex_colors();
+    if ( !_mesh.has_vertex_texcoords2D() ) _mesh.request_vertex_texcoords2D();
+    if ( !_mesh.has_halfedge_texcoords2D() ) _mesh.request_halfedge_texcoords2D();
+}
+
 bool TCViewer::open_mesh(const char* _filename, IO::Options _opt)
 {
     /// load mesh
     /// calculate normals
     /// set scene center and radius
 
-    mesh_.request_face_normals();
-    mesh_.request_face_colors();
-    mesh_.request_vertex_normals();
-    mesh_.request_vertex_colors();
-    mesh_.request_vertex_texcoords2D();
+    request_attributes(mesh_);
 
     std::cout << "Loading from file '" << _filename << "'\n";
-    if ( IO::read_mesh(mesh_, _filename, _opt ))
-    {
-        /// store read option
-        opt_ = _opt;
+    MeshReadStats stats;
+    if ( !read_mesh_fast(mesh_, QString::fromLocal8Bit(_filename), _opt, &stats) )
+        return false;
 
-        /// update face and vertex normals
-        if ( ! opt_.check( IO::Options::FaceNormal ) )
-            mesh_.update_face_normals();
-        else
-            std::cout << "File provides face normals\n";
+    if ( stats.fast )
+        std::clog << "Parsed " << stats.bytes/(1024.0*1024.0) << " MB on "
+                  << stats.threads << " threads in " << stats.parse_seconds << " s ("
+                  << stats.bytes/(1024.0*1024.0)/std::max(stats.parse_seconds, 1e-9)
+                  << " MB/s), built mesh in " << stats.build_seconds << " s" << std::endl;
+    else
+        std::clog << "Read by OpenMesh (no fast path for this file)" << std::endl;
+    if ( stats.skipped_faces )
+        std::clog << "! " << stats.skipped_faces << " faces with repeated vertices dropped" << std::endl;
+    if ( stats.split_faces )
+        std::clog << "! " << stats.split_faces << " faces at non-manifold edges or vertices"
+                  << " detached onto own vertices" << std::endl;
+
+    return prepare_mesh(_opt);
+}
 
-        if ( ! opt_.check( IO::Options::VertexNormal ) )
-            mesh_.update_vertex_normals();
-        else
-            std::cout << "File provides vertex normals\n";
+bool TCViewer::prepare_mesh(IO::Options _opt)
+{
+    if ( !mesh_.n_vertices() )
+        return false;
 
+    /// store read option
+    opt_ = _opt;
+
+    /// update face and vertex normals
+    const bool face_normals   = ! opt_.check( IO::Options::FaceNormal );
+    const bool vertex_normals = ! opt_.check( IO::Options::VertexNormal );
+    if ( !face_normals )
+        std::cout << "File provides face normals\n";
+    if ( !vertex_normals )
+        std::cout << "File provides vertex normals\n";
+    if ( face_normals || vertex_normals )
+    {
+        OpenMesh::Utils::Timer t;
+        t.start();
+        update_normals(mesh_, face_normals, vertex_normals, normal_weights_);
+        t.stop();
+        std::clog << "Computed " << (face_normals ? "face " : "")
+                  << (face_normals && vertex_normals ? "and " : "")
+                  << (vertex_normals ? "vertex " : "") << "normals ["
+                  << t.as_string() << "]" << std::endl;
+    }
 
-        /// check for possible color information
-        if ( opt_.check( IO::Options::VertexColor ) )
-        {
-            std::cout << "File provides vertex colors\n";
-        }
-        else
-            mesh_.release_vertex_colors();
 
-        if ( _opt.check( IO::Options::FaceColor ) )
-        {
-            std::cout << "File provides face colors\n";
-        }
+    /// check for possible color information
+    if ( opt_.check( IO::Options::VertexColor ) )
+    {
+        std::cout << "File provides vertex colors\n";
+    }
+    else
+        mesh_.release_vertex_colors();
+
+    /// face colors and per-corner texcoords split the render vertices
+    if ( _opt.check( IO::Options::FaceColor ) )
+        std::cout << "File provides face colors\n";
+    else if ( mesh_.has_face_colors() )
+        mesh_.release_face_colors();
+
+    if ( _opt.check( IO::Options::VertexTexCoord ) )
+        std::cout << "File provides texture coordinates\n";
+    else if ( mesh_.has_vertex_texcoords2D() )
+        mesh_.release_vertex_texcoords2D();
+
+    if ( _opt.check( IO::Options::FaceTexCoord ) )
+        std::cout << "File provides per-corner texture coordinates\n";
+    else if ( mesh_.has_halfedge_texcoords2D() )
+        mesh_.release_halfedge_texcoords2D();
+
+    /// bounding box
+    bounding_box(mesh_, bb_min_, bb_max_);
+
+    /// set bounding box at the center of the scene
+    setSceneBoundingBox(OMVec3f_to_QGLVec(bb_min_), OMVec3f_to_QGLVec(bb_max_));
+    glFogf(GL_FOG_START,1.5*sceneRadius());
+    glFogf(GL_FOG_END,  3.0*sceneRadius());
+    camera()->showEntireScene();
+
+    /// for normal display
+    normal_scale_ = (bb_max_-bb_min_).min()*0.05f;
+
+    /// info
+    std::clog << mesh_.n_vertices() << " vertices, "
+              << mesh_.n_edges()    << " edge, "
+              << mesh_.n_faces()    << " faces\n";
+    TopologyReport topology;
+    analyze_topology(mesh_, topology);
+    std::clog << topology;
+
+    /// base point for displaying face normals, only kept while they are shown
+    OpenMesh::Utils::Timer t;
+    if ( show_fnormals_ )
+    {
+        t.start();
+        if ( !mesh_.get_property_handle( fp_normal_base_, "normal_base" ) )
+            mesh_.add_property( fp_normal_base_, "normal_base" );
+        face_centroids(mesh_, fp_normal_base_);
+        t.stop();
+        std::clog << "Computed base point for displaying face normals ["
+                  << t.as_string() << "]" << std::endl;
+    }
+    else if ( mesh_.get_property_handle( fp_normal_base_, "normal_base" ) )
+        mesh_.remove_property( fp_normal_base_ );
+
+    /// scalar fields of the previous mesh, new ones are computed on demand
+    scalar_fields_.clear();
+    geodesics_.clear();
+    geodesic_source_ = 0;
+    isoline_version_ = 0;
+    occlusion_timer_.stop();
+    occlusion_watcher_.waitForFinished();
+    occlusion_.clear();
+
+    /// a scalar sequence stays if its frames still fit the vertices, an
+    /// animation carries the old triangles
+    if ( scalar_sequence_.is_open() )
+    {
+        if ( scalar_sequence_.n_values() == mesh_.n_vertices() )
+            show_sequence_frame(sequence_frame_);
         else
-            mesh_.release_face_colors();
-
-        if ( _opt.check( IO::Options::VertexTexCoord ) )
-            std::cout << "File provides texture coordinates\n";
-
-        /// bounding box
-        typename Mesh::ConstVertexIter vIt(mesh_.vertices_begin());
-        typename Mesh::ConstVertexIter vEnd(mesh_.vertices_end());
-
-        typedef typename Mesh::Point Point;
-        using OpenMesh::Vec3f;
-
-        Vec3f bbMin, bbMax;
-
-        bbMin = bbMax = OpenMesh::vector_cast<Vec3f>(mesh_.point(*vIt));
-
-        for (size_t count=0; vIt!=vEnd; ++vIt, ++count)
         {
-            bbMin.minimize( OpenMesh::vector_cast<Vec3f>(mesh_.point(*vIt)));
-            bbMax.maximize( OpenMesh::vector_cast<Vec3f>(mesh_.point(*vIt)));
+            std::clog << "Scalar sequence: " << scalar_sequence_.n_values() << " values per frame, but "
+                      << mesh_.n_vertices() << " vertices, closed" << std::endl;
+            close_scalar_sequence();
         }
+    }
+    if ( animation_.is_open() )
+    {
+        std::clog << "Vertex animation: new mesh, closed" << std::endl;
+        close_animation();
+    }
 
-        /// set bounding box at the center of the scene
-        setSceneBoundingBox(OMVec3f_to_QGLVec(bbMin), OMVec3f_to_QGLVec(bbMax));
-        glFogf(GL_FOG_START,1.5*sceneRadius());
-        glFogf(GL_FOG_END,  3.0*sceneRadius());
-        camera()->showEntireScene();
+    /// smoothing of the previous mesh
+    smooth_timer_.stop();
+    smooth_remaining_ = 0;
+    smooth_adjacency_ = VertexAdjacency();
+    std::vector<TCMesh::Point>().swap(smooth_scratch_);
 
-        /// for normal display
-        normal_scale_ = (bbMax-bbMin).min()*0.05f;
+    /// GPU buffers
+    t.start();
+    upload_mesh();
+    active_scalar_.clear();
+    t.stop();
+    std::clog << "Uploaded vertex and index buffers, " << (encoded_ ? "quantized" : vertex_layout_name(layout_))
+              << " layout [" << t.as_string() << "]" << std::endl;
+
+    /// the bake keeps its own copies, so it outlives a view-only release
+    if ( show_occlusion_ )
+        start_occlusion();
+
+    /// sections of the previous mesh; the BVH is built from copies as well
+    section_timer_.stop();
+    section_watcher_.waitForFinished();
+    section_bvh_.clear();
+    for (size_t i = 0; i < clip_planes_.size(); ++i)
+    {
+        clip_planes_[i].section.clear();
+        clip_planes_[i].plane[0] = std::numeric_limits<float>::quiet_NaN();
+    }
+    if ( !clip_planes_.empty() )
+        start_section_bvh();
 
-        /// info
-        std::clog << mesh_.n_vertices() << " vertices, "
-                  << mesh_.n_edges()    << " edge, "
-                  << mesh_.n_faces()    << " faces\n";
+    /// view-only: everything the modes need is on the GPU or in the scalar
+    /// fields, the OpenMesh copy can go
+    if ( view_only_ )
+    {
+        scalar_field("Valence");
+        scalar_field("GaussianCurvature");
+        scalar_field("MeanCurvature");
+        scalar_field("Components");
+        if ( !reference_bvh_.empty() )
+            scalar_field("Distance");
+        release_mesh(true);
+        std::clog << "View-only: released CPU mesh, kept "
+                  << triangles_.size()/3 << " triangles" << std::endl;
+    }
 
-        /// base point for displaying face normals
-        OpenMesh::Utils::Timer t;
-        t.start();
-        mesh_.add_property( fp_normal_base_ );
-        TCMesh::FaceIter f_it = mesh_.faces_begin();
-        TCMesh::FaceVertexIter fv_it;
-        for (;f_it != mesh_.faces_end(); ++f_it)
-        {
-            typename Mesh::Point v(0,0,0);
-            for(fv_it=mesh_.fv_iter(*f_it); fv_it.is_valid(); ++fv_it)
-                v += OpenMesh::vector_cast<typename Mesh::Normal>(mesh_.point(*fv_it));
-            v *= 1.0f/3.0f;
-            mesh_.property( fp_normal_base_, *f_it ) = v;
-        }
-        t.stop();
-        std::clog << "Computed base point for displaying face normals ["
-                  << t.as_string() << "]" << std::endl;
+    print_memory_report(std::clog);
+    request_redraw();
 
-        /// compute vertex valence and convert them to "valence_color"'s
-        std::cout << "Computing vertex valences..." << std::endl;
-        int valence;
-        std::vector<float>  valences;
-        for (vIt=mesh_.vertices_begin(); vIt!=vEnd; ++vIt) {
-            valence = 0;
-            for (TCMesh::VertexVertexIter vvIt=mesh_.vv_iter(*vIt); vvIt.is_valid(); ++vvIt) {
-                valence++;
-            }
-            mesh_.data(*vIt).set_valence(valence);
-            valences.push_back(valence);
-        }
+    /// loading done
+    return true;
+}
 
-        float range_min = *std::max_element(valences.begin(),valences.end());
-        float range_max = *std::min_element(valences.begin(),valences.end());
 
-        Vec3f valence_color;
-        for (vIt=mesh_.vertices_begin(); vIt!=vEnd; ++vIt) {
-            valence_color = interp_color(mesh_.data(*vIt).get_valence(), range_min, range_max);
-            mesh_.data(*vIt).set_valence_color(valence_color);
-        }
-        std::cout << "Valence computation done." << std::endl;
+//-----------------------------------------------------------------------------
+bool TCViewer::open_reference(const char* _filename)
+{
+    OpenMesh::Utils::Timer t;
+    t.start();
 
-        /// compute Gaussian and mean curvatures and convert them to corresponding colors
+    TCMesh reference;
+    IO::Options opt;
+    if ( !read_mesh_fast(reference, QString::fromLocal8Bit(_filename), opt) || !reference.n_faces() )
+        return false;
 
+    std::vector<unsigned int> triangles;
+    triangle_indices(reference, triangles);
+    const float* points = &reference.points()[0][0];
+    reference_points_.assign(points, points + 3*reference.n_vertices());
+    reference_bvh_.build(&reference_points_[0], reference.n_vertices(), &triangles[0], reference.n_faces());
 
-        /// loading done
-        return true;
-    }
-    return false;
+    t.stop();
+    std::clog << "Reference '" << _filename << "': " << reference.n_faces() << " faces, BVH of "
+              << reference_bvh_.bytes()/(1024.0*1024.0) << " MB [" << t.as_string() << "]" << std::endl;
+
+    /// distances to the previous reference are stale
+    scalar_fields_.erase("Distance");
+    if ( active_scalar_ == "Distance" )
+        active_scalar_.clear();
+    request_redraw();
+    return true;
 }
 
-
 //-----------------------------------------------------------------------------
 bool TCViewer::open_texture( const char *_filename )
 {
     QImage texsrc;
     QString fname = _filename;
 
+    /// too large for one texture or for the budget: stream it in tiles
+    makeCurrent();
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    const QSize size = QImageReader(fname).size();
+    if ( size.isValid() &&
+         ( std::max(size.width(), size.height()) > max_size ||
+           4.0*size.width()*size.height() > texture_budget_ ) )
+        return open_virtual_texture(fname);
+
     if (texsrc.load( fname ))
     {
         return set_texture( texsrc );
@@ -146,12 +352,94 @@ bool TCViewer::open_texture( const char *_filename )
     return false;
 }
 
+namespace {
+
+bool build_pyramid(const QString& _image, const QString& _pack)
+{
+    return TilePyramid::build(_image, _pack, 128, &std::clog);
+}
+
+}
+
+bool TCViewer::open_virtual_texture(const QString& _image)
+{
+    if ( !opt_.vertex_has_texcoord() )
+        return false;
+    if ( !tiling_pack_.isEmpty() )
+    {
+        std::cerr << "Still tiling '" << tiling_pack_.toLocal8Bit().constData() << "'" << std::endl;
+        return false;
+    }
+
+    const QFileInfo image(_image);
+    if ( !image.exists() )
+        return false;
+    QString pack = image.absoluteFilePath() + ".tiles";
+    if ( !QFileInfo(image.absolutePath()).isWritable() )
+        pack = QDir::temp().absoluteFilePath(image.fileName() + ".tiles");
+
+    const QFileInfo cached(pack);
+    if ( cached.exists() && cached.lastModified() >= image.lastModified() &&
+         use_virtual_texture(pack) )
+        return true;
+
+    /// the mesh stays untextured while the pyramid is built
+    std::clog << "Tiling '" << _image.toLocal8Bit().constData() << "' into '"
+              << pack.toLocal8Bit().constData() << "'" << std::endl;
+    tiling_pack_ = pack;
+    tiling_watcher_.setFuture(QtConcurrent::run(build_pyramid, image.absoluteFilePath(), pack));
+    return true;
+}
+
+bool TCViewer::use_virtual_texture(const QString& _pack)
+{
+    makeCurrent();
+    if ( !vtex_.open(_pack, texture_budget_) )
+    {
+        std::cerr << "Cannot open tile pyramid '" << _pack.toLocal8Bit().constData() << "'" << std::endl;
+        return false;
+    }
+    if ( tex_id_ > 0 )
+    {
+        glDeleteTextures(1, &tex_id_);
+        tex_id_ = 0;
+        tex_bytes_ = 0;
+    }
+    if ( encoded_ )
+        std::clog << "Virtual texture: not drawn with quantized vertices" << std::endl;
+
+    std::clog << "Virtual texture " << vtex_.width() << "x" << vtex_.height() << ", "
+              << texture_budget_/(1024*1024) << " MB budget" << std::endl;
+    request_redraw();
+    return true;
+}
+
+void TCViewer::finish_tiling()
+{
+    /// exports wait for the pyramid and finish it themselves
+    if ( tiling_pack_.isEmpty() )
+        return;
+
+    const QString pack = tiling_pack_;
+    tiling_pack_.clear();
+    if ( !tiling_watcher_.result() )
+        std::cerr << "Cannot tile texture into '" << pack.toLocal8Bit().constData() << "'" << std::endl;
+    else
+        use_virtual_texture(pack);
+}
+
+void TCViewer::tiles_ready()
+{
+    request_redraw();
+}
+
 
 //-----------------------------------------------------------------------------
 bool TCViewer::set_texture( QImage& _texsrc )
 {
     if ( !opt_.vertex_has_texcoord() )
         return false;
+    vtex_.clear();
 
     {
         /// adjust texture size: 2^k * 2^l
@@ -198,6 +486,7 @@ bool TCViewer::set_texture( QImage& _texsrc )
                  GL_UNSIGNED_BYTE,    // type
                  texture.bits() );    // pointer to pixels
 
+    tex_bytes_ = 4*texture.width()*texture.height();
     std::cout << "Texture loaded\n";
     return true;
 }
@@ -216,8 +505,20 @@ void TCViewer::open_mesh_gui(QString fname)
         msg += "'";
         QMessageBox::critical( NULL, windowTitle(), msg);
     }
+    else
+    {
+        if ( watch_file_ && fname != mesh_file_ )
+        {
+            if ( !file_watcher_.files().isEmpty() )
+                file_watcher_.removePaths(file_watcher_.files());
+            file_watcher_.addPath(fname);
+        }
+        mesh_file_ = fname;
+    }
     t.stop();
-    std::cout << "Loaded mesh in ~" << t.as_string() << std::endl;
+    std::cout << "Loaded mesh in ~" << t.as_string() << " ("
+              << QFileInfo(fname).size()/(1024.0*1024.0)/std::max(t.seconds(), 1e-9)
+              << " MB/s)" << std::endl;
 }
 
 void TCViewer::open_texture_gui(QString fname)
@@ -234,6 +535,15 @@ void TCViewer::open_texture_gui(QString fname)
     }
 }
 
+void TCViewer::query_open_reference_file()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open reference mesh"), tr(""),
+                                                    tr("Mesh Files (*.off *.ply *.obj *.stl);;"
+                                                       "All Files (*)"));
+    if ( !fileName.isEmpty() && !open_reference(fileName.toLocal8Bit()) )
+        QMessageBox::critical(NULL, windowTitle(), "Cannot read reference mesh from file:\n '" + fileName + "'");
+}
+
 void TCViewer::query_open_mesh_file() {
     QString fileName = QFileDialog::getOpenFileName(this,
                                                     tr("Open mesh file"),
@@ -247,6 +557,182 @@ void TCViewer::query_open_mesh_file() {
         open_mesh_gui(fileName);
 }
 
+///-----------------------------------------------------------------------------
+/// file watching
+///-----------------------------------------------------------------------------
+static bool read_mesh_file(TCMesh* _mesh, OpenMesh::IO::Options* _opt, QString _fname)
+{
+    /// runs on a worker thread, touches nothing but _mesh and _opt
+    TCViewer::request_attributes(*_mesh);
+    return read_mesh_fast(*_mesh, _fname, *_opt);
+}
+
+bool TCViewer::same_topology(const TCMesh& _a, const TCMesh& _b)
+{
+    if ( _a.n_vertices() != _b.n_vertices() || _a.n_faces() != _b.n_faces() )
+        return false;
+
+    TCMesh::ConstFaceIter fa(_a.faces_begin()), fb(_b.faces_begin()), fEnd(_a.faces_end());
+    for (; fa!=fEnd; ++fa, ++fb)
+    {
+        TCMesh::ConstFaceVertexIter va(_a.cfv_iter(*fa)), vb(_b.cfv_iter(*fb));
+        for (; va.is_valid() && vb.is_valid(); ++va, ++vb)
+            if ( va->idx() != vb->idx() )
+                return false;
+        if ( va.is_valid() || vb.is_valid() )
+            return false;
+    }
+    return true;
+}
+
+void TCViewer::set_view_only(bool _on)
+{
+    view_only_ = _on;
+    std::cout << "View-only loading: " << (view_only_ ? "enabled" : "disabled")
+              << " (applies to the next mesh)" << std::endl;
+}
+
+void TCViewer::set_quantized_vertices(bool _on)
+{
+    if ( !buffers_.n_elements(MeshBuffers::Position) )
+    {
+        set_quantized(_on);
+        return;
+    }
+
+    const size_t bytes_before = vertex_bytes();
+    const double time_before  = time_frames(10);
+    set_quantized(_on);
+    const double time_after   = time_frames(10);
+
+    std::cout << "Vertex layout: " << (encoded_ ? "quantized" : vertex_layout_name(layout_)) << ", "
+              << bytes_before << " -> " << vertex_bytes() << " bytes/vertex, "
+              << 1e3*time_before << " -> " << 1e3*time_after << " ms/frame" << std::endl;
+}
+
+void TCViewer::set_watch_file(bool _on)
+{
+    watch_file_ = _on;
+
+    if ( !file_watcher_.files().isEmpty() )
+        file_watcher_.removePaths(file_watcher_.files());
+    if ( watch_file_ && !mesh_file_.isEmpty() )
+        file_watcher_.addPath(mesh_file_);
+
+    std::cout << "Watch mesh file: " << (watch_file_ ? "enabled" : "disabled") << std::endl;
+}
+
+void TCViewer::mesh_file_changed(const QString& /*_path*/)
+{
+    reload_timer_.start();
+}
+
+void TCViewer::start_reload()
+{
+    if ( !watch_file_ || mesh_file_.isEmpty() )
+        return;
+
+    if ( reload_watcher_.isRunning() )
+    {
+        reload_pending_ = true;
+        return;
+    }
+
+    /// files replaced by rename/recreate drop out of the watcher; if the new
+    /// file is not there yet, try again later
+    if ( !QFileInfo(mesh_file_).exists() )
+    {
+        reload_timer_.start();
+        return;
+    }
+    if ( !file_watcher_.files().contains(mesh_file_) )
+        file_watcher_.addPath(mesh_file_);
+
+    reload_file_ = mesh_file_;
+    reload_opt_  = _options;
+    reload_watcher_.setFuture(QtConcurrent::run(read_mesh_file, &reload_mesh_, &reload_opt_, reload_file_));
+}
+
+void TCViewer::finish_reload()
+{
+    if ( reload_file_ != mesh_file_ )
+    {
+        /// another mesh was opened meanwhile
+    }
+    else if ( !reload_watcher_.result() )
+    {
+        std::cerr << "Cannot reload mesh from file '"
+                  << reload_file_.toLocal8Bit().constData() << "'" << std::endl;
+    }
+    else if ( !split_.empty() )
+    {
+        /// the split follows the per-corner attributes, which may have changed
+        std::clog << "Per-corner attributes, reopening '"
+                  << reload_file_.toLocal8Bit().constData() << "'" << std::endl;
+        open_mesh_gui(reload_file_);
+    }
+    else if ( same_topology(mesh_, reload_mesh_) )
+    {
+        OpenMesh::Utils::Timer t;
+        t.start();
+
+        bool file_normals = reload_opt_.check( IO::Options::VertexNormal ) &&
+                            mesh_.has_vertex_normals();
+        bool file_face_normals = reload_opt_.check( IO::Options::FaceNormal ) &&
+                                 mesh_.has_face_normals();
+        bool file_colors  = reload_opt_.check( IO::Options::VertexColor ) &&
+                            mesh_.has_vertex_colors();
+        bool file_uvs     = reload_opt_.check( IO::Options::VertexTexCoord ) &&
+                            mesh_.has_vertex_texcoords2D();
+
+        TCMesh::VertexIter vIt(mesh_.vertices_begin()), vEnd(mesh_.vertices_end());
+        for (; vIt!=vEnd; ++vIt)
+        {
+            mesh_.set_point(*vIt, reload_mesh_.point(*vIt));
+            if ( file_normals )
+                mesh_.set_normal(*vIt, reload_mesh_.normal(*vIt));
+            if ( file_colors )
+                mesh_.set_color(*vIt, reload_mesh_.color(*vIt));
+            if ( file_uvs )
+                mesh_.set_texcoord2D(*vIt, reload_mesh_.texcoord2D(*vIt));
+        }
+        if ( file_face_normals )
+        {
+            TCMesh::FaceIter fIt(mesh_.faces_begin()), fEnd(mesh_.faces_end());
+            for (; fIt!=fEnd; ++fIt)
+                mesh_.set_normal(*fIt, reload_mesh_.normal(*fIt));
+        }
+
+        /// recompute whichever normals the file did not supply
+        update_normals(mesh_, !file_face_normals, !file_normals, normal_weights_);
+        refresh_geometry(false);
+        if ( file_colors )
+            buffers_.mark_dirty(MeshBuffers::Color, 0, mesh_.n_vertices());
+        if ( file_uvs )
+            buffers_.mark_dirty(MeshBuffers::TexCoord, 0, mesh_.n_vertices());
+
+        t.stop();
+        std::clog << "Refreshed positions and attributes from '"
+                  << reload_file_.toLocal8Bit().constData() << "' ["
+                  << t.as_string() << "]" << std::endl;
+        request_redraw();
+    }
+    else
+    {
+        std::clog << "Topology changed, reopening '"
+                  << reload_file_.toLocal8Bit().constData() << "'" << std::endl;
+        open_mesh_gui(reload_file_);
+    }
+
+    reload_mesh_.clear();
+
+    if ( reload_pending_ )
+    {
+        reload_pending_ = false;
+        reload_timer_.start();
+    }
+}
+
 void TCViewer::query_open_texture_file() {
     QString fileName = QFileDialog::getOpenFileName(this,
                                                     tr("Open texture file"),
@@ -262,59 +748,1008 @@ void TCViewer::query_open_texture_file() {
 }
 
 ///-----------------------------------------------------------------------------
-/// reload draw(), init()
+/// memory accounting
 ///-----------------------------------------------------------------------------
-void TCViewer::draw()
+void TCViewer::print_memory_report(std::ostream& _os)
 {
-    if ( ! mesh_.n_vertices() )
-        return;
+    MemoryReport report;
+    report.add_mesh(mesh_, mesh_.n_vertices(), mesh_.n_halfedges(), mesh_.n_faces());
 
-    glDisable(GL_COLOR_MATERIAL);
+    std::map<std::string, ScalarField>::const_iterator it;
+    for (it = scalar_fields_.begin(); it != scalar_fields_.end(); ++it)
+    {
+        report.add("derived", it->first, it->second.values.size()*sizeof(float));
+        report.add("derived", it->first + " histogram",
+                   it->second.histogram.bins().size()*sizeof(size_t));
+    }
+    if ( !reference_bvh_.empty() )
+    {
+        report.add("derived", "reference vertices", reference_points_.size()*sizeof(float));
+        report.add("derived", "reference BVH", reference_bvh_.bytes());
+    }
+    if ( reload_mesh_.n_vertices() )
+        report.add("derived", "reload scratch mesh",
+                   reload_mesh_.n_vertices()*sizeof(TCMesh::Point) +
+                   reload_mesh_.n_halfedges()*4*sizeof(TCMesh::VertexHandle));
+
+    if ( occlusion_.bytes() )
+        report.add("derived", "ambient occlusion", occlusion_.bytes());
+    if ( !section_bvh_.empty() )
+        report.add("derived", "cross-section BVH", section_bvh_.bytes());
+    if ( animation_.is_open() )
+        report.add("derived", "vertex animation frames", animation_.bytes());
+    if ( !split_.empty() )
+        report.add("derived", "vertex split", split_.bytes() +
+                   split_colors_.capacity()*sizeof(TCMesh::Color) +
+                   split_texcoords_.capacity()*sizeof(TCMesh::TexCoord2D));
+
+    const char* names[MeshBuffers::NAttributes] =
+        { "positions", "normals", "colors", "texcoords", "scalars", "occlusion",
+          "interleaved vertices", "indices", "isolines" };
+    for (int i = 0; i < MeshBuffers::NAttributes; ++i)
+        if ( buffers_.bytes(MeshBuffers::Attribute(i)) )
+            report.add("GPU", names[i], buffers_.bytes(MeshBuffers::Attribute(i)));
+    if ( !triangles_.empty() )
+        report.add("derived", "compact topology", triangles_.size()*sizeof(unsigned int));
+    if ( tex_id_ )
+        report.add("GPU", "texture", tex_bytes_);
+    if ( vtex_.is_open() )
+    {
+        report.add("GPU", "texture tile cache", vtex_.gpu_bytes());
+        report.add("derived", "texture tile table", vtex_.cpu_bytes());
+    }
 
-    typename Mesh::ConstFaceIter fIt(mesh_.faces_begin()), fEnd(mesh_.faces_end());
-    typename Mesh::ConstFaceVertexIter fvIt;
+    _os << "Memory report:\n";
+    report.print(_os);
+    if ( vertex_bytes() )
+        _os << "Vertex layout: " << (encoded_ ? "quantized" : vertex_layout_name(layout_)) << ", "
+            << vertex_bytes() << " bytes/vertex\n";
+}
 
-    if (draw_mode_ == "Smooth") {
-        glEnable(GL_LIGHTING);
-        glShadeModel(GL_SMOOTH);
-        glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+double TCViewer::time_frames(int _n)
+{
+    makeCurrent();
+    updateGL();
+    glFinish();
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < _n; ++i)
+    {
+        updateGL();
+        glFinish();
+    }
+    return timer.nsecsElapsed()*1e-9/_n;
+}
+
+///-----------------------------------------------------------------------------
+/// offscreen export
+///-----------------------------------------------------------------------------
+bool TCViewer::export_animation(const QString& _dir, int _frames, int _width, int _height,
+                                int _keyframes, int _jobs)
+{
+    if ( _frames <= 0 || _width <= 0 || _height <= 0 )
+        return false;
+
+    qglviewer::KeyFrameInterpolator* kfi = 0;
+    if ( _keyframes >= 0 )
+    {
+        kfi = camera()->keyFrameInterpolator(_keyframes);
+        if ( !kfi || kfi->numberOfKeyFrames() < 2 )
+        {
+            std::cerr << "Camera path " << _keyframes << " has no key frames" << std::endl;
+            return false;
+        }
+    }
+
+    makeCurrent();
+    if ( !tiling_pack_.isEmpty() )
+    {
+        tiling_watcher_.waitForFinished();
+        finish_tiling();
+    }
+    /// frames show the finished bake
+    while ( occlusion_.running() )
+    {
+        occlusion_watcher_.waitForFinished();
+        occlusion_pass_done();
+    }
+    /// and the sections
+    if ( section_watcher_.isRunning() )
+    {
+        section_watcher_.waitForFinished();
+        section_bvh_done();
+    }
+    FrameExporter exporter(_width, _height, _dir + "/frame_%1.png", _jobs);
+    if ( !exporter.begin() )
+        return false;
 
-        glEnableClientState(GL_VERTEX_ARRAY);
-        glVertexPointer(3, GL_FLOAT, 0, mesh_.points());
+    /// camera state to restore afterwards
+    const qglviewer::Vec        pos0 = camera()->position();
+    const qglviewer::Quaternion q0   = camera()->orientation();
+    const qglviewer::Vec        up   = camera()->upVector();
+    const qglviewer::Vec        c    = sceneCenter();
+    camera()->setScreenWidthAndHeight(_width, _height);
+    draw_overlays_ = false;
 
-        glEnableClientState(GL_NORMAL_ARRAY);
-        glNormalPointer(GL_FLOAT, 0, mesh_.vertex_normals());
+    QElapsedTimer timer;
+    timer.start();
 
-        if ( tex_id_ && mesh_.has_vertex_texcoords2D() )
+    exporter.bind();
+    for (int i = 0; i < _frames; ++i)
+    {
+        if ( kfi )
+        {
+            float s = _frames > 1 ? float(i)/(_frames-1) : 0.0f;
+            kfi->interpolateAtTime(kfi->firstTime() + s*(kfi->lastTime()-kfi->firstTime()));
+        }
+        else
         {
-            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-            glTexCoordPointer(2, GL_FLOAT, 0, mesh_.texcoords2D());
-            glEnable(GL_TEXTURE_2D);
-            glBindTexture(GL_TEXTURE_2D, tex_id_);
-            glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, tex_mode_);
+            qglviewer::Quaternion r(up, 2.0*M_PI*i/_frames);
+            camera()->setPosition(c + r.rotate(pos0-c));
+            camera()->setOrientation(r*q0);
         }
 
-        glBegin(GL_TRIANGLES);
-        for (; fIt!=fEnd; ++fIt)
+        preDraw();
+        draw();
+        /// streamed tiles: redraw until the ones in view are resident
+        for (int pass = 0; vtex_.is_open() && vtex_.loading() && pass < 16; ++pass)
         {
-            fvIt = mesh_.cfv_iter(*fIt);
-            glArrayElement(fvIt->idx());
-            ++fvIt;
-            glArrayElement(fvIt->idx());
-            ++fvIt;
-            glArrayElement(fvIt->idx());
+            vtex_.wait_for_tiles();
+            preDraw();
+            draw();
         }
-        glEnd();
+        exporter.capture(i);
+    }
+    exporter.release();
+    exporter.finish();
+
+    const double secs = timer.elapsed()/1000.0;
+    std::clog << "Exported " << _frames << " frames to '"
+              << _dir.toLocal8Bit().constData() << "' in " << secs << " s ("
+              << (secs > 0.0 ? _frames/secs : 0.0) << " fps)" << std::endl;
+
+    draw_overlays_ = true;
+    camera()->setPosition(pos0);
+    camera()->setOrientation(q0);
+    camera()->setScreenWidthAndHeight(width(), height());
+    glViewport(0, 0, width(), height());
+    updateGL();
+    return true;
+}
+
+void TCViewer::query_export_animation()
+{
+    QString dir = QFileDialog::getExistingDirectory(this, tr("Export turntable frames to"));
+    if ( dir.isEmpty() )
+        return;
 
-        glDisableClientState(GL_VERTEX_ARRAY);
-        glDisableClientState(GL_NORMAL_ARRAY);
-        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    bool ok;
+    int frames = QInputDialog::getInt(this, tr("Export Turntable"), tr("Frames:"), 120, 1, 100000, 1, &ok);
+    if ( ok )
+        export_animation(dir, frames, 1920, 1080);
+}
 
-        if ( tex_id_ && mesh_.has_vertex_texcoords2D() )
-        {
-            glDisable(GL_TEXTURE_2D);
+void TCViewer::query_smooth()
+{
+    QStringList methods;
+    methods << tr("Taubin") << tr("Laplacian");
+
+    bool ok;
+    QString method = QInputDialog::getItem(this, tr("Smooth Mesh"), tr("Method:"), methods, 0, false, &ok);
+    if ( !ok )
+        return;
+    int iterations = QInputDialog::getInt(this, tr("Smooth Mesh"), tr("Iterations:"), 10, 1, 10000, 1, &ok);
+    if ( !ok )
+        return;
+    double lambda = QInputDialog::getDouble(this, tr("Smooth Mesh"), tr("Step (lambda):"), 0.5, 0.01, 1.0, 2, &ok);
+    if ( ok )
+        smooth(method == methods[0], iterations, static_cast<float>(lambda));
+}
+
+void TCViewer::set_isolines(bool _on)
+{
+    show_isolines_ = _on;
+    if ( _on && !mesh_.n_vertices() && !triangles_.empty() )
+        std::cerr << "Isolines: not available for view-only meshes" << std::endl;
+    request_redraw();
+}
+
+void TCViewer::set_isoline_levels(int _count)
+{
+    isoline_count_ = std::max(1, std::min(_count, 1000));
+    isoline_values_.clear();
+    std::cout << "Isolines: " << isoline_count_ << " levels" << std::endl;
+    request_redraw();
+}
+
+void TCViewer::set_isoline_levels(const std::vector<float>& _values)
+{
+    isoline_values_ = _values;
+    std::sort(isoline_values_.begin(), isoline_values_.end());
+    isoline_values_.erase(std::unique(isoline_values_.begin(), isoline_values_.end()),
+                          isoline_values_.end());
+    std::cout << "Isolines: " << isoline_values_.size() << " given levels" << std::endl;
+    request_redraw();
+}
+
+void TCViewer::query_isoline_levels()
+{
+    QString current = QString::number(isoline_count_);
+    if ( !isoline_values_.empty() )
+    {
+        QStringList values;
+        for (size_t i = 0; i < isoline_values_.size(); ++i)
+            values << QString::number(isoline_values_[i]);
+        current = values.join(", ");
+    }
+
+    bool ok;
+    QString text = QInputDialog::getText(this, tr("Isoline Levels"),
+                                         tr("Number of levels, or the level values separated by commas:"),
+                                         QLineEdit::Normal, current, &ok);
+    if ( !ok )
+        return;
+
+    /// a single integer is a count, anything else a list of values
+    QStringList items = text.split(QRegExp("[,;\\s]+"), QString::SkipEmptyParts);
+    int count = items.size() == 1 ? items[0].toInt(&ok) : 0;
+    if ( items.size() == 1 && ok )
+    {
+        set_isoline_levels(count);
+        return;
+    }
+
+    std::vector<float> values;
+    for (int i = 0; i < items.size(); ++i)
+    {
+        const float value = items[i].toFloat(&ok);
+        if ( !ok )
+        {
+            std::cerr << "Isolines: '" << items[i].toStdString() << "' is not a number" << std::endl;
+            return;
+        }
+        values.push_back(value);
+    }
+    if ( !values.empty() )
+        set_isoline_levels(values);
+}
+
+namespace {
+
+/// rays per vertex of the first bake pass, shown as soon as possible, and
+/// of each refining pass
+const int occlusion_first_pass = 4;
+const int occlusion_pass       = 8;
+
+bool refine_occlusion(AmbientOcclusion* _occlusion, int _rays)
+{
+    return _occlusion->refine(_rays);
+}
+
+}
+
+void TCViewer::set_ambient_occlusion(bool _on)
+{
+    show_occlusion_ = _on;
+    std::cout << "Ambient occlusion: " << (_on ? "enabled" : "disabled") << std::endl;
+    if ( _on && occlusion_.accessibility().empty() )
+        start_occlusion();
+    request_redraw();
+}
+
+void TCViewer::set_occlusion_radius(float _fraction)
+{
+    occlusion_radius_ = std::max(1e-4f, std::min(_fraction, 1.0f));
+    std::cout << "Ambient occlusion: radius " << occlusion_radius_ << " of the diagonal" << std::endl;
+    if ( show_occlusion_ )
+        start_occlusion();
+}
+
+void TCViewer::query_occlusion_radius()
+{
+    bool ok;
+    double radius = QInputDialog::getDouble(this, tr("Ambient Occlusion"),
+                                            tr("Ray length (fraction of the bounding box diagonal):"),
+                                            occlusion_radius_, 0.001, 1.0, 3, &ok);
+    if ( ok )
+        set_occlusion_radius(static_cast<float>(radius));
+}
+
+void TCViewer::start_occlusion()
+{
+    occlusion_timer_.stop();
+    occlusion_watcher_.waitForFinished();
+
+    if ( !mesh_.n_faces() || !mesh_.has_vertex_normals() )
+    {
+        if ( !triangles_.empty() )
+            std::cerr << "Ambient occlusion: not available for view-only meshes" << std::endl;
+        return;
+    }
+
+    occlusion_clock_.start();
+    std::vector<unsigned int> triangles;
+    triangle_indices(mesh_, triangles);
+    occlusion_.begin(&mesh_.points()[0][0], &mesh_.vertex_normals()[0][0],
+                     mesh_.n_vertices(), &triangles[0], mesh_.n_faces(),
+                     occlusion_radius_*(bb_max_-bb_min_).norm());
+    std::clog << "Ambient occlusion: BVH over " << mesh_.n_faces() << " faces ["
+              << 1e-3*occlusion_clock_.elapsed() << " s]" << std::endl;
+
+    occlusion_watcher_.setFuture(QtConcurrent::run(refine_occlusion, &occlusion_, occlusion_first_pass));
+}
+
+void TCViewer::restart_occlusion()
+{
+    /// a pass over the old geometry is still running, let it finish
+    if ( occlusion_watcher_.isRunning() )
+        occlusion_timer_.start();
+    else if ( show_occlusion_ )
+        start_occlusion();
+}
+
+void TCViewer::occlusion_pass_done()
+{
+    if ( !occlusion_.running() )
+        return;
+
+    occlusion_dirty_ = true;
+    request_redraw();
+
+    const int rays = occlusion_.rays();
+    if ( rays < occlusion_rays_ )
+    {
+        if ( rays == occlusion_first_pass )
+            std::clog << "Ambient occlusion: first pass after " << 1e-3*occlusion_clock_.elapsed()
+                      << " s" << std::endl;
+        occlusion_watcher_.setFuture(QtConcurrent::run(refine_occlusion, &occlusion_,
+                                                       std::min(occlusion_pass, occlusion_rays_-rays)));
+        return;
+    }
+
+    /// the BVH and the vertex copies are only needed for further rays
+    const double seconds = 1e-3*occlusion_clock_.elapsed();
+    const size_t nv = occlusion_.accessibility().size();
+    occlusion_.finish();
+    std::clog << "Ambient occlusion: " << nv << " vertices x " << rays << " rays in " << seconds
+              << " s (" << 1e-6*nv*rays/std::max(seconds, 1e-9) << " M rays/s)" << std::endl;
+}
+
+bool TCViewer::update_occlusion()
+{
+    const std::vector<float>& values = occlusion_.accessibility();
+    if ( values.empty() || values.size() != n_mesh_vertices() )
+        return false;
+    if ( !occlusion_dirty_ && buffers_.has(MeshBuffers::Occlusion) )
+        return true;
+
+    /// the fixed pipeline cannot scale the material by a vertex attribute,
+    /// so the bytes carry the occluded diffuse color
+    GLfloat diffuse[4];
+    glGetMaterialfv(GL_FRONT, GL_DIFFUSE, diffuse);
+    std::vector<unsigned char> colors(3*values.size());
+    const long n = static_cast<long>(values.size());
+#pragma omp parallel for schedule(static)
+    for (long v = 0; v < n; ++v)
+        for (int k = 0; k < 3; ++k)
+            colors[3*v+k] = static_cast<unsigned char>(255.0f*values[v]*diffuse[k] + 0.5f);
+
+    buffers_.upload(MeshBuffers::Occlusion, &colors[0], 3, values.size());
+    occlusion_dirty_ = false;
+    return true;
+}
+
+namespace {
+
+bool build_section_bvh(TriangleBVH* _bvh, const std::vector<float>* _points,
+                       const std::vector<unsigned int>* _triangles)
+{
+    _bvh->build(&(*_points)[0], _points->size()/3, &(*_triangles)[0], _triangles->size()/3);
+    return true;
+}
+
+/// outline color per clipping plane
+const float section_colors[TCViewer::max_clip_planes][3] =
+    { { 1.0f, 0.3f, 0.1f }, { 0.1f, 0.6f, 1.0f }, { 0.2f, 0.8f, 0.2f }, { 0.9f, 0.8f, 0.1f } };
+
+/// world coordinates of the plane through the frame's origin, normal
+/// along its z axis
+void frame_plane(const qglviewer::ManipulatedFrame* _frame, float _plane[4])
+{
+    const qglviewer::Vec n = _frame->inverseTransformOf(qglviewer::Vec(0.0, 0.0, 1.0));
+    const qglviewer::Vec p = _frame->position();
+    _plane[0] = n.x;
+    _plane[1] = n.y;
+    _plane[2] = n.z;
+    _plane[3] = -(n*p);
+}
+
+}
+
+void TCViewer::add_clip_plane()
+{
+    if ( clip_planes_.size() >= max_clip_planes )
+    {
+        std::cerr << "Clipping planes: at most " << max_clip_planes << std::endl;
+        return;
+    }
+
+    ClipPlane clip;
+    clip.frame = new qglviewer::ManipulatedFrame();
+    clip.frame->setParent(this);
+    clip.frame->setConstraint(&clip_constraint_);
+    clip.frame->setPosition(sceneCenter());
+    clip.frame->setOrientation(qglviewer::Quaternion(qglviewer::Vec(0.0, 0.0, 1.0), -camera()->viewDirection()));
+    clip.plane[0] = std::numeric_limits<float>::quiet_NaN();
+    clip_planes_.push_back(clip);
+
+    active_plane_ = clip_planes_.size()-1;
+    setManipulatedFrame(clip.frame);
+    std::cout << "Clipping plane " << clip_planes_.size() << " of " << clip_planes_.size()
+              << ", ctrl+drag moves it" << std::endl;
+
+    if ( section_bvh_.empty() && !section_watcher_.isRunning() )
+        start_section_bvh();
+    request_redraw();
+}
+
+void TCViewer::clear_clip_planes()
+{
+    setManipulatedFrame(0);
+    for (size_t i = 0; i < clip_planes_.size(); ++i)
+        delete clip_planes_[i].frame;
+    clip_planes_.clear();
+    active_plane_ = 0;
+
+    section_timer_.stop();
+    section_watcher_.waitForFinished();
+    section_bvh_.clear();
+    std::cout << "Clipping planes: removed" << std::endl;
+    request_redraw();
+}
+
+void TCViewer::start_section_bvh()
+{
+    section_timer_.stop();
+    section_watcher_.waitForFinished();
+
+    if ( !mesh_.n_faces() )
+    {
+        if ( !triangles_.empty() )
+            std::cerr << "Cross-sections: not available for view-only meshes, clipping only" << std::endl;
+        return;
+    }
+
+    section_clock_.start();
+    const float* points = &mesh_.points()[0][0];
+    section_points_.assign(points, points + 3*mesh_.n_vertices());
+    triangle_indices(mesh_, section_triangles_);
+    section_watcher_.setFuture(QtConcurrent::run(build_section_bvh, &section_bvh_,
+                                                 &section_points_, &section_triangles_));
+}
+
+void TCViewer::restart_section_bvh()
+{
+    /// a build over the old geometry is still running, let it finish
+    if ( section_watcher_.isRunning() )
+        section_timer_.start();
+    else if ( !clip_planes_.empty() )
+        start_section_bvh();
+}
+
+void TCViewer::section_bvh_done()
+{
+    std::vector<float>().swap(section_points_);
+    std::vector<unsigned int>().swap(section_triangles_);
+    if ( clip_planes_.empty() )
+    {
+        section_bvh_.clear();
+        return;
+    }
+
+    std::clog << "Cross-sections: BVH over " << section_bvh_.n_faces() << " faces, "
+              << section_bvh_.bytes()/(1024.0*1024.0) << " MB [" << 1e-3*section_clock_.elapsed()
+              << " s]" << std::endl;
+    for (size_t i = 0; i < clip_planes_.size(); ++i)
+        clip_planes_[i].plane[0] = std::numeric_limits<float>::quiet_NaN();
+    request_redraw();
+}
+
+void TCViewer::enable_clip_planes()
+{
+    for (size_t i = 0; i < clip_planes_.size(); ++i)
+    {
+        float plane[4];
+        frame_plane(clip_planes_[i].frame, plane);
+        /// GL keeps what the equation maps to >= 0, the half behind the normal
+        const GLdouble equation[4] = { -plane[0], -plane[1], -plane[2], -plane[3] };
+        glClipPlane(GL_CLIP_PLANE0+i, equation);
+        glEnable(GL_CLIP_PLANE0+i);
+    }
+}
+
+void TCViewer::disable_clip_planes()
+{
+    for (size_t i = 0; i < clip_planes_.size(); ++i)
+        glDisable(GL_CLIP_PLANE0+i);
+}
+
+void TCViewer::draw_sections()
+{
+    /// the BVH is rebuilt after edits, sections keep the old geometry until then
+    const bool slicing = !section_bvh_.empty() && !section_watcher_.isRunning();
+
+    glDisable(GL_LIGHTING);
+    glLineWidth(2.5f);
+    glDepthRange(0.0, 0.9999);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    for (size_t i = 0; i < clip_planes_.size(); ++i)
+    {
+        ClipPlane& clip = clip_planes_[i];
+        float plane[4];
+        frame_plane(clip.frame, plane);
+        if ( slicing && !std::equal(plane, plane+4, clip.plane) )
+        {
+            section_bvh_.slice(plane, clip.section);
+            std::copy(plane, plane+4, clip.plane);
+        }
+        if ( clip.section.empty() )
+            continue;
+
+        /// the outline lies on its own plane, the other planes still cut it
+        glDisable(GL_CLIP_PLANE0+i);
+        glColor3fv(section_colors[i]);
+        glVertexPointer(3, GL_FLOAT, 0, &clip.section[0]);
+        glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(clip.section.size()/3));
+        glEnable(GL_CLIP_PLANE0+i);
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDepthRange(0.0, 1.0);
+
+    /// the plane being moved, as a translucent square across the scene
+    if ( draw_overlays_ && active_plane_ < clip_planes_.size() )
+    {
+        const float r = sceneRadius();
+        glPushMatrix();
+        glMultMatrixd(clip_planes_[active_plane_].frame->matrix());
+        glDisable(GL_CLIP_PLANE0+active_plane_);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_FALSE);
+
+        const float* c = section_colors[active_plane_];
+        glColor4f(c[0], c[1], c[2], 0.15f);
+        glBegin(GL_QUADS);
+        glVertex3f(-r, -r, 0.0f); glVertex3f(r, -r, 0.0f); glVertex3f(r, r, 0.0f); glVertex3f(-r, r, 0.0f);
+        glEnd();
+        glColor4f(c[0], c[1], c[2], 0.6f);
+        glBegin(GL_LINE_LOOP);
+        glVertex3f(-r, -r, 0.0f); glVertex3f(r, -r, 0.0f); glVertex3f(r, r, 0.0f); glVertex3f(-r, r, 0.0f);
+        glEnd();
+
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+        glPopMatrix();
+    }
+
+    glLineWidth(1.0f);
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+void TCViewer::smooth(bool _taubin, int _iterations, float _lambda)
+{
+    if ( !mesh_.n_vertices() )
+    {
+        if ( !triangles_.empty() )
+            std::cerr << "Smoothing: not available for view-only meshes" << std::endl;
+        return;
+    }
+
+    /// connectivity is fixed for the lifetime of the mesh
+    if ( smooth_adjacency_.boundary.size() != mesh_.n_vertices() )
+    {
+        OpenMesh::Utils::Timer t;
+        t.start();
+        build_vertex_adjacency(mesh_, smooth_adjacency_);
+        t.stop();
+        std::clog << "Built vertex adjacency, " << smooth_adjacency_.bytes()/(1024.0*1024.0)
+                  << " MB [" << t.as_string() << "]" << std::endl;
+    }
+
+    smooth_taubin_    = _taubin;
+    smooth_lambda_    = _lambda;
+    smooth_remaining_ = std::max(_iterations, 0);
+    smooth_done_      = 0;
+    smooth_seconds_   = 0.0;
+    if ( smooth_remaining_ )
+        smooth_timer_.start();
+}
+
+void TCViewer::smooth_step()
+{
+    if ( smooth_remaining_ <= 0 || smooth_adjacency_.boundary.size() != mesh_.n_vertices() )
+    {
+        smooth_timer_.stop();
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    smooth_iteration(smooth_adjacency_, &mesh_.point(TCMesh::VertexHandle(0)), smooth_scratch_,
+                     smooth_taubin_, smooth_lambda_);
+    const double seconds = 1e-9*timer.nsecsElapsed();
+
+    refresh_geometry(true);
+    request_redraw();
+
+    smooth_seconds_ += seconds;
+    ++smooth_done_;
+    if ( --smooth_remaining_ == 0 )
+    {
+        smooth_timer_.stop();
+        std::clog << (smooth_taubin_ ? "Taubin" : "Laplacian") << " smoothing, "
+                  << smooth_done_ << " iterations in " << smooth_seconds_ << " s ("
+                  << 1e-6*mesh_.n_vertices()*smooth_done_/std::max(smooth_seconds_, 1e-9)
+                  << " M vertices/s per iteration)" << std::endl;
+    }
+}
+
+///-----------------------------------------------------------------------------
+/// scalar sequences and vertex animations
+///-----------------------------------------------------------------------------
+namespace {
+
+void prepare_animation_frame(VertexAnimation* _animation, size_t _frame)
+{
+    _animation->prepare(_frame);
+}
+
+}
+
+bool TCViewer::open_scalar_sequence(const QString& _file)
+{
+    const size_t nv = n_mesh_vertices();
+    if ( !nv )
+    {
+        std::cerr << "Scalar sequence: open a mesh first" << std::endl;
+        return false;
+    }
+
+    close_scalar_sequence();
+
+    OpenMesh::Utils::Timer t;
+    t.start();
+    if ( !scalar_sequence_.open(_file, nv) )
+        return false;
+    scalar_sequence_.sample_histogram(sequence_histogram_);
+    t.stop();
+    std::clog << "Scalar sequence '" << _file.toLocal8Bit().constData() << "': "
+              << scalar_sequence_.n_frames() << " frames of " << nv << " values, "
+              << scalar_sequence_.n_frames()*scalar_sequence_.frame_bytes()/(1024.0*1024.0)
+              << " MB mapped, color range sampled [" << t.as_string() << "]" << std::endl;
+
+    show_sequence_frame(sequence_frame_);
+    set_draw_mode("Sequence");
+    emit scalar_sequence_opened();
+    emit sequence_length_changed(static_cast<int>(sequence_length()));
+    return true;
+}
+
+bool TCViewer::open_animation(const QString& _file)
+{
+    if ( !mesh_.n_vertices() )
+    {
+        std::cerr << "Vertex animation: " << (triangles_.empty() ? "open a mesh first"
+                                                                 : "not available for view-only meshes")
+                  << std::endl;
+        return false;
+    }
+
+    close_animation();
+
+    OpenMesh::Utils::Timer t;
+    t.start();
+    std::vector<unsigned int> triangles;
+    triangle_indices(mesh_, triangles);
+    if ( triangles.empty() ||
+         !animation_.open(_file, &triangles[0], triangles.size()/3, mesh_.n_vertices(), normal_weights_) )
+        return false;
+    t.stop();
+    std::clog << "Vertex animation '" << _file.toLocal8Bit().constData() << "': "
+              << animation_.n_frames() << " frames of " << animation_.n_vertices() << " positions, "
+              << animation_.n_frames()*animation_.frames().frame_bytes()/(1024.0*1024.0)
+              << " MB mapped [" << t.as_string() << "]" << std::endl;
+
+    seek_sequence(sequence_frame_);
+    emit sequence_length_changed(static_cast<int>(sequence_length()));
+    return true;
+}
+
+void TCViewer::query_open_scalar_sequence()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open scalar sequence"), tr(""),
+                                                    tr("Raw float32 frames (*.raw *.bin *.f32);;"
+                                                       "All Files (*)"));
+    if ( !fileName.isEmpty() && !open_scalar_sequence(fileName) )
+        QMessageBox::critical(NULL, windowTitle(), "Cannot map scalar sequence, the file size has to be a multiple of "
+                              + QString::number(sizeof(float)*n_mesh_vertices())
+                              + " bytes:\n '" + fileName + "'");
+}
+
+void TCViewer::query_open_animation()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open vertex animation"), tr(""),
+                                                    tr("Raw float32 xyz frames (*.raw *.bin *.f32);;"
+                                                       "All Files (*)"));
+    if ( !fileName.isEmpty() && !open_animation(fileName) )
+        QMessageBox::critical(NULL, windowTitle(), "Cannot map vertex animation, the file size has to be a multiple of "
+                              + QString::number(3*sizeof(float)*mesh_.n_vertices())
+                              + " bytes:\n '" + fileName + "'");
+}
+
+void TCViewer::close_scalar_sequence()
+{
+    if ( !scalar_sequence_.is_open() )
+        return;
+
+    set_sequence_playing(false);
+    scalar_sequence_.close();
+    scalar_fields_.erase("Sequence");
+    if ( active_scalar_ == "Sequence" )
+        active_scalar_.clear();
+    emit sequence_length_changed(static_cast<int>(sequence_length()));
+}
+
+void TCViewer::close_animation()
+{
+    if ( !animation_.is_open() )
+        return;
+
+    set_sequence_playing(false);
+    animation_watcher_.waitForFinished();
+    animation_.close();
+    emit sequence_length_changed(static_cast<int>(sequence_length()));
+}
+
+size_t TCViewer::sequence_length() const
+{
+    return std::max(scalar_sequence_.n_frames(), animation_.n_frames());
+}
+
+void TCViewer::set_sequence_fps(double _fps)
+{
+    sequence_fps_ = std::max(_fps, 0.1);
+    sequence_timer_.setInterval(std::max(1, static_cast<int>(500.0/sequence_fps_)));
+
+    /// playback goes on from the current frame at the new rate
+    if ( sequence_timer_.isActive() )
+        seek_sequence(sequence_frame_);
+}
+
+void TCViewer::show_sequence_frame(size_t _frame)
+{
+    sequence_frame_ = _frame;
+
+    if ( scalar_sequence_.is_open() )
+    {
+        ScalarField& field = scalar_fields_["Sequence"];
+        field.values.resize(scalar_sequence_.n_values());
+        scalar_sequence_.read(_frame % scalar_sequence_.n_frames(), &field.values[0]);
+        field.histogram = sequence_histogram_;
+        field.version   = ++field_version_;
+
+        /// only the scalar channel changes, in one write
+        if ( active_scalar_ == "Sequence" )
+            buffers_.mark_dirty(MeshBuffers::Scalar, 0, field.values.size());
+    }
+
+    emit sequence_frame_changed(static_cast<int>(_frame));
+    request_redraw();
+}
+
+void TCViewer::apply_animation_frame()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    animation_.swap();
+    const size_t nv = animation_.n_vertices();
+    std::copy(animation_.points(), animation_.points() + 3*nv, &mesh_.point(TCMesh::VertexHandle(0))[0]);
+    if ( mesh_.has_vertex_normals() )
+        std::copy(animation_.vertex_normals(), animation_.vertex_normals() + 3*nv,
+                  &mesh_.property(mesh_.vertex_normals_pph(), TCMesh::VertexHandle(0))[0]);
+    if ( mesh_.has_face_normals() )
+        std::copy(animation_.face_normals(), animation_.face_normals() + 3*animation_.n_faces(),
+                  &mesh_.property(mesh_.face_normals_pph(), TCMesh::FaceHandle(0))[0]);
+
+    /// normals are done, the rest follows as for any edit of all vertices
+    refresh_geometry(false);
+    animation_apply_seconds_ += 1e-9*timer.nsecsElapsed();
+}
+
+void TCViewer::seek_sequence(size_t _frame)
+{
+    const size_t n = sequence_length();
+    if ( !n )
+        return;
+    _frame %= n;
+
+    if ( animation_.is_open() )
+    {
+        animation_watcher_.waitForFinished();
+        animation_.prepare(_frame % animation_.n_frames());
+        apply_animation_frame();
+    }
+    show_sequence_frame(_frame);
+
+    /// playback goes on from here, the worker starts on the next frame
+    if ( sequence_timer_.isActive() )
+    {
+        sequence_start_ = _frame;
+        sequence_steps_ = 0;
+        sequence_clock_.restart();
+        if ( animation_.is_open() )
+        {
+            animation_step_ = 1;
+            animation_watcher_.setFuture(QtConcurrent::run(prepare_animation_frame, &animation_,
+                                                           (_frame+1) % animation_.n_frames()));
+        }
+    }
+}
+
+void TCViewer::set_sequence_playing(bool _on)
+{
+    if ( _on == sequence_timer_.isActive() )
+        return;
+
+    if ( !_on )
+    {
+        sequence_timer_.stop();
+        animation_watcher_.waitForFinished();
+        report_sequence_playback();
+        return;
+    }
+    if ( !sequence_length() )
+    {
+        std::cerr << "Sequence: open a scalar sequence or vertex animation first" << std::endl;
+        return;
+    }
+
+    scalar_sequence_.reset_stats();
+    animation_.reset_stats();
+    animation_apply_seconds_ = 0.0;
+    sequence_shown_   = 0;
+    sequence_dropped_ = 0;
+    sequence_wall_.start();
+    sequence_clock_.start();
+    sequence_timer_.start();
+    seek_sequence(sequence_frame_);
+}
+
+void TCViewer::set_sequence_frame(int _frame)
+{
+    if ( _frame < 0 || static_cast<size_t>(_frame) >= sequence_length() ||
+         static_cast<size_t>(_frame) == sequence_frame_ )
+        return;
+
+    seek_sequence(static_cast<size_t>(_frame));
+}
+
+void TCViewer::sequence_tick()
+{
+    /// the frame is where the clock is: playback never slows down, frames
+    /// that are not ready in time are skipped
+    const long steps = static_cast<long>(1e-9*sequence_clock_.nsecsElapsed()*sequence_fps_);
+    if ( steps <= sequence_steps_ )
+        return;
+
+    long shown = steps;
+    if ( animation_.is_open() )
+    {
+        /// positions come from the worker: its frame is shown once its
+        /// slot has come, even if late, and the worker moves on to the slot
+        /// after the current one
+        if ( animation_watcher_.isRunning() || animation_step_ > steps )
+            return;
+        shown = animation_step_;
+        apply_animation_frame();
+
+        animation_step_ = steps+1;
+        animation_watcher_.setFuture(QtConcurrent::run(prepare_animation_frame, &animation_,
+                                                       (sequence_start_+steps+1) % animation_.n_frames()));
+    }
+
+    sequence_dropped_ += shown - sequence_steps_ - 1;
+    sequence_steps_    = shown;
+    ++sequence_shown_;
+    show_sequence_frame((sequence_start_ + shown) % sequence_length());
+}
+
+void TCViewer::report_sequence_playback()
+{
+    const double seconds = 1e-9*sequence_wall_.nsecsElapsed();
+    if ( !sequence_shown_ || seconds <= 0.0 )
+        return;
+
+    const double mb = 1.0/(1024.0*1024.0);
+    std::clog << "Sequence: " << sequence_shown_ << " frames in " << seconds << " s ("
+              << sequence_shown_/seconds << " of " << sequence_fps_ << " fps, "
+              << sequence_dropped_ << " dropped)" << std::endl;
+    if ( scalar_sequence_.is_open() )
+        std::clog << "  scalars streamed " << mb*scalar_sequence_.read_bytes()/seconds
+                  << " MB/s, prefetch paged in "
+                  << mb*scalar_sequence_.paged_bytes()/std::max(scalar_sequence_.paged_seconds(), 1e-9)
+                  << " MB/s, copies took " << 1000.0*scalar_sequence_.read_seconds()/sequence_shown_
+                  << " ms per frame" << std::endl;
+    if ( animation_.is_open() && animation_.n_prepared() )
+    {
+        const ScalarSequence& frames = animation_.frames();
+        std::clog << "  positions streamed " << mb*frames.read_bytes()/seconds
+                  << " MB/s, prefetch paged in "
+                  << mb*frames.paged_bytes()/std::max(frames.paged_seconds(), 1e-9)
+                  << " MB/s, read and normals took " << 1000.0*animation_.prepare_seconds()/animation_.n_prepared()
+                  << " ms per frame on the worker, applying "
+                  << 1000.0*animation_apply_seconds_/sequence_shown_ << " ms on the GUI thread" << std::endl;
+    }
+}
+
+///-----------------------------------------------------------------------------
+/// reload draw(), init()
+///-----------------------------------------------------------------------------
+void TCViewer::draw()
+{
+    if ( ! buffers_.n_elements(MeshBuffers::Position) )
+        return;
+
+    flush_buffers();
+    glDisable(GL_COLOR_MATERIAL);
+    enable_clip_planes();
+
+    typename Mesh::ConstFaceIter fIt(mesh_.faces_begin()), fEnd(mesh_.faces_end());
+    typename Mesh::ConstFaceVertexIter fvIt;
+
+    if (draw_mode_ == "Smooth") {
+        glEnable(GL_LIGHTING);
+        glShadeModel(GL_SMOOTH);
+        glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+
+        /// baked occlusion takes the place of the diffuse material, else
+        /// vertex colors or the face colors of split vertices do
+        const bool occlusion = show_occlusion_ && update_occlusion();
+        const bool colors    = !occlusion && use_color_ && buffers_.has(MeshBuffers::Color);
+        if ( occlusion || colors )
+        {
+            glColorMaterial(GL_FRONT_AND_BACK, GL_DIFFUSE);
+            glEnable(GL_COLOR_MATERIAL);
+        }
+
+        enable_vertices();
+        if ( occlusion )
+            enable_array(MeshBuffers::Occlusion);
+        else if ( colors )
+            enable_array(MeshBuffers::Color);
+
+        if ( vtex_.is_open() && !encoded_ && enable_array(MeshBuffers::TexCoord) )
+        {
+            draw_virtual_texture();
+        }
+        else
+        {
+            if ( tex_id_ && enable_array(MeshBuffers::TexCoord) )
+            {
+                glEnable(GL_TEXTURE_2D);
+                glBindTexture(GL_TEXTURE_2D, tex_id_);
+                glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, tex_mode_);
+            }
+
+            draw_triangles();
         }
 
+        disable_arrays();
+        glDisable(GL_TEXTURE_2D);
+        glDisable(GL_COLOR_MATERIAL);
+
         setDefaultMaterial();
     } /// "Smooth"
 
@@ -323,19 +1758,49 @@ void TCViewer::draw()
         glShadeModel(GL_FLAT);
         glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
 
-        glBegin(GL_TRIANGLES);
-        for (; fIt!=fEnd; ++fIt)
+        /// face colors, else the provoking (last) vertex's color as in the
+        /// buffers; split vertices carry the face colors there
+        const bool colors = use_color_ && buffers_.has(MeshBuffers::Color);
+        if ( colors )
         {
-            glNormal3fv( &mesh_.normal(*fIt)[0] );
+            glColorMaterial(GL_FRONT_AND_BACK, GL_DIFFUSE);
+            glEnable(GL_COLOR_MATERIAL);
+        }
 
-            fvIt = mesh_.cfv_iter(*fIt);
-            glVertex3fv( &mesh_.point(*fvIt)[0] );
-            ++fvIt;
-            glVertex3fv( &mesh_.point(*fvIt)[0] );
-            ++fvIt;
-            glVertex3fv( &mesh_.point(*fvIt)[0] );
+        if ( mesh_.n_faces() && !interacting() )
+        {
+            const bool face_colors   = colors && mesh_.has_face_colors();
+            const bool vertex_colors = colors && !face_colors && mesh_.has_vertex_colors();
+            glBegin(GL_TRIANGLES);
+            for (; fIt!=fEnd; ++fIt)
+            {
+                glNormal3fv( &mesh_.normal(*fIt)[0] );
+                if ( face_colors )
+                    glColor3ubv( &mesh_.color(*fIt)[0] );
+
+                fvIt = mesh_.cfv_iter(*fIt);
+                glVertex3fv( &mesh_.point(*fvIt)[0] );
+                ++fvIt;
+                glVertex3fv( &mesh_.point(*fvIt)[0] );
+                ++fvIt;
+                if ( vertex_colors )
+                    glColor3ubv( &mesh_.color(*fvIt)[0] );
+                glVertex3fv( &mesh_.point(*fvIt)[0] );
+            }
+            glEnd();
         }
-        glEnd();
+        else
+        {
+            /// view-only (no face normals left) or while the camera moves:
+            /// shade with the provoking vertex's normal from the buffers
+            enable_array(MeshBuffers::Position);
+            enable_array(MeshBuffers::Normal);
+            if ( colors )
+                enable_array(MeshBuffers::Color);
+            draw_triangles();
+            disable_arrays();
+        }
+        glDisable(GL_COLOR_MATERIAL);
 
         setDefaultMaterial();
     } /// "Flat"
@@ -346,17 +1811,9 @@ void TCViewer::draw()
 
         glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
 
-        glBegin(GL_TRIANGLES);
-        for (; fIt!=fEnd; ++fIt)
-        {
-            fvIt = mesh_.cfv_iter(*fIt);
-            glVertex3fv( &mesh_.point(*fvIt)[0] );
-            ++fvIt;
-            glVertex3fv( &mesh_.point(*fvIt)[0] );
-            ++fvIt;
-            glVertex3fv( &mesh_.point(*fvIt)[0] );
-        }
-        glEnd();
+        enable_array(MeshBuffers::Position);
+        draw_triangles();
+        disable_arrays();
 
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
@@ -366,18 +1823,12 @@ void TCViewer::draw()
     else if (draw_mode_ == "Points") {
         glDisable(GL_LIGHTING);
 
-        glEnableClientState(GL_VERTEX_ARRAY);
-        glVertexPointer(3, GL_FLOAT, 0, mesh_.points());
-
-        if (mesh_.has_vertex_colors() && use_color_)
-        {
-            glEnableClientState(GL_COLOR_ARRAY);
-            glColorPointer(3, GL_UNSIGNED_BYTE, 0, mesh_.vertex_colors());
-        }
+        enable_array(MeshBuffers::Position);
+        if (use_color_)
+            enable_array(MeshBuffers::Color);
 
-        glDrawArrays( GL_POINTS, 0, static_cast<GLsizei>(mesh_.n_vertices()) );
-        glDisableClientState(GL_VERTEX_ARRAY);
-        glDisableClientState(GL_COLOR_ARRAY);
+        glDrawArrays( GL_POINTS, 0, static_cast<GLsizei>(buffers_.n_elements(MeshBuffers::Position)) );
+        disable_arrays();
 
         setDefaultMaterial();
     } /// "Points"
@@ -386,197 +1837,63 @@ void TCViewer::draw()
         glDisable(GL_LIGHTING);
         glEnable(GL_DEPTH_TEST);
 
+        enable_array(MeshBuffers::Position);
+
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
         glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
-
-        glBegin(GL_TRIANGLES);
-        for (; fIt!=fEnd; ++fIt)
-        {
-            fvIt = mesh_.cfv_iter(*fIt);
-            glVertex3fv( &mesh_.point(*fvIt)[0] );
-            ++fvIt;
-            glVertex3fv( &mesh_.point(*fvIt)[0] );
-            ++fvIt;
-            glVertex3fv( &mesh_.point(*fvIt)[0] );
-        }
-        glEnd();
+        draw_triangles();
 
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
         glEnable(GL_POLYGON_OFFSET_FILL);
         glPolygonOffset(1.0, 1.0);
         glColor4f(0.2f, 0.2f, 0.2f, 1.0f);
-
-        glBegin(GL_TRIANGLES);
-        for (fIt=mesh_.faces_begin(); fIt!=fEnd; ++fIt)
-        {
-            fvIt = mesh_.cfv_iter(*fIt);
-            glVertex3fv( &mesh_.point(*fvIt)[0] );
-            ++fvIt;
-            glVertex3fv( &mesh_.point(*fvIt)[0] );
-            ++fvIt;
-            glVertex3fv( &mesh_.point(*fvIt)[0] );
-        }
-        glEnd();
+        draw_triangles();
 
         glDisable(GL_POLYGON_OFFSET_FILL);
+        disable_arrays();
 
         setDefaultMaterial();
     } /// "Hidden-Line"
-    else if (draw_mode_ == "Valence") {
-        mesh_.request_vertex_colors();
-        TCMesh::VertexIter vIt, vEnd(mesh_.vertices_end());
-        for (vIt=mesh_.vertices_begin(); vIt!=vEnd; ++vIt) {
-            mesh_.set_color(*vIt, TCMesh::Color(mesh_.data(*vIt).get_valence_color()));
-        }
-
-        glDisable(GL_LIGHTING);
-        glShadeModel(GL_SMOOTH);
-
-        glEnableClientState(GL_VERTEX_ARRAY);
-        glVertexPointer(3, GL_FLOAT, 0, mesh_.points());
-
-        glEnableClientState(GL_NORMAL_ARRAY);
-        glNormalPointer(GL_FLOAT, 0, mesh_.vertex_normals());
-
-        if ( mesh_.has_vertex_colors() )
-        {
-            glEnableClientState( GL_COLOR_ARRAY );
-            glColorPointer(3, GL_UNSIGNED_BYTE, 0, mesh_.vertex_colors());
-        }
-
-        glBegin(GL_TRIANGLES);
-        for (; fIt!=fEnd; ++fIt)
-        {
-            fvIt = mesh_.cfv_iter(*fIt);
-            glArrayElement(fvIt->idx());
-            ++fvIt;
-            glArrayElement(fvIt->idx());
-            ++fvIt;
-            glArrayElement(fvIt->idx());
-        }
-        glEnd();
-
-        glDisableClientState(GL_VERTEX_ARRAY);
-        glDisableClientState(GL_NORMAL_ARRAY);
-        glDisableClientState(GL_COLOR_ARRAY);
-    } /// "Valence"
-    else if (draw_mode_ == "GaussianCurvature") {
-        mesh_.request_vertex_colors();
-        TCMesh::VertexIter vIt, vEnd(mesh_.vertices_end());
-        for (vIt=mesh_.vertices_begin(); vIt!=vEnd; ++vIt) {
-            mesh_.set_color(*vIt, TCMesh::Color(mesh_.data(*vIt).get_valence_color()));
-        }
-
-        glDisable(GL_LIGHTING);
-        glShadeModel(GL_SMOOTH);
-
-        glEnableClientState(GL_VERTEX_ARRAY);
-        glVertexPointer(3, GL_FLOAT, 0, mesh_.points());
-
-        glEnableClientState(GL_NORMAL_ARRAY);
-        glNormalPointer(GL_FLOAT, 0, mesh_.vertex_normals());
-
-        if ( mesh_.has_vertex_colors() )
-        {
-            glEnableClientState( GL_COLOR_ARRAY );
-            glColorPointer(3, GL_UNSIGNED_BYTE, 0, mesh_.vertex_colors());
-        }
-
-        glBegin(GL_TRIANGLES);
-        for (; fIt!=fEnd; ++fIt)
-        {
-            fvIt = mesh_.cfv_iter(*fIt);
-            glArrayElement(fvIt->idx());
-            ++fvIt;
-            glArrayElement(fvIt->idx());
-            ++fvIt;
-            glArrayElement(fvIt->idx());
-        }
-        glEnd();
-
-        glDisableClientState(GL_VERTEX_ARRAY);
-        glDisableClientState(GL_NORMAL_ARRAY);
-        glDisableClientState(GL_COLOR_ARRAY);
-    } /// "GaussianCurvature"
-    else if (draw_mode_ == "MeanCurvature") {
-        mesh_.request_vertex_colors();
-        TCMesh::VertexIter vIt, vEnd(mesh_.vertices_end());
-        for (vIt=mesh_.vertices_begin(); vIt!=vEnd; ++vIt) {
-            mesh_.set_color(*vIt, TCMesh::Color(mesh_.data(*vIt).get_valence_color()));
-        }
-
-        glDisable(GL_LIGHTING);
-        glShadeModel(GL_SMOOTH);
-
-        glEnableClientState(GL_VERTEX_ARRAY);
-        glVertexPointer(3, GL_FLOAT, 0, mesh_.points());
-
-        glEnableClientState(GL_NORMAL_ARRAY);
-        glNormalPointer(GL_FLOAT, 0, mesh_.vertex_normals());
-
-        if ( mesh_.has_vertex_colors() )
-        {
-            glEnableClientState( GL_COLOR_ARRAY );
-            glColorPointer(3, GL_UNSIGNED_BYTE, 0, mesh_.vertex_colors());
-        }
-
-        glBegin(GL_TRIANGLES);
-        for (; fIt!=fEnd; ++fIt)
-        {
-            fvIt = mesh_.cfv_iter(*fIt);
-            glArrayElement(fvIt->idx());
-            ++fvIt;
-            glArrayElement(fvIt->idx());
-            ++fvIt;
-            glArrayElement(fvIt->idx());
-        }
-        glEnd();
-
-        glDisableClientState(GL_VERTEX_ARRAY);
-        glDisableClientState(GL_NORMAL_ARRAY);
-        glDisableClientState(GL_COLOR_ARRAY);
-    } /// "MeanCurvature"
+    else if ( is_scalar_mode(draw_mode_) ) {
+        draw_scalar_field(draw_mode_);
+    } /// scalar fields
     else {
         glEnable(GL_LIGHTING);
         glShadeModel(GL_SMOOTH);
         glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
 
-        glEnableClientState(GL_VERTEX_ARRAY);
-        glVertexPointer(3, GL_FLOAT, 0, mesh_.points());
-
-        glEnableClientState(GL_NORMAL_ARRAY);
-        glNormalPointer(GL_FLOAT, 0, mesh_.vertex_normals());
-
-        if ( tex_id_ && mesh_.has_vertex_texcoords2D() )
+        /// baked occlusion takes the place of the diffuse material
+        const bool occlusion = show_occlusion_ && update_occlusion();
+        if ( occlusion )
         {
-            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-            glTexCoordPointer(2, GL_FLOAT, 0, mesh_.texcoords2D());
-            glEnable(GL_TEXTURE_2D);
-            glBindTexture(GL_TEXTURE_2D, tex_id_);
-            glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, tex_mode_);
+            glColorMaterial(GL_FRONT_AND_BACK, GL_DIFFUSE);
+            glEnable(GL_COLOR_MATERIAL);
         }
 
-        glBegin(GL_TRIANGLES);
-        for (; fIt!=fEnd; ++fIt)
+        enable_vertices();
+        if ( occlusion )
+            enable_array(MeshBuffers::Occlusion);
+
+        if ( vtex_.is_open() && !encoded_ && enable_array(MeshBuffers::TexCoord) )
         {
-            fvIt = mesh_.cfv_iter(*fIt);
-            glArrayElement(fvIt->idx());
-            ++fvIt;
-            glArrayElement(fvIt->idx());
-            ++fvIt;
-            glArrayElement(fvIt->idx());
+            draw_virtual_texture();
         }
-        glEnd();
-
-        glDisableClientState(GL_VERTEX_ARRAY);
-        glDisableClientState(GL_NORMAL_ARRAY);
-        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-
-        if ( tex_id_ && mesh_.has_vertex_texcoords2D() )
+        else
         {
-            glDisable(GL_TEXTURE_2D);
+            if ( tex_id_ && enable_array(MeshBuffers::TexCoord) )
+            {
+                glEnable(GL_TEXTURE_2D);
+                glBindTexture(GL_TEXTURE_2D, tex_id_);
+                glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, tex_mode_);
+            }
+
+            draw_triangles();
         }
 
+        disable_arrays();
+        glDisable(GL_TEXTURE_2D);
+        glDisable(GL_COLOR_MATERIAL);
+
         setDefaultMaterial();
         //        glPushMatrix();
 
@@ -639,11 +1956,21 @@ void TCViewer::draw()
 
         //        glPopMatrix();
     } /// default smooth shading
+
+    /// isolines follow the main view's field, linked views draw the same
+    if ( draw_overlays_ && is_scalar_mode(draw_mode_) )
+        isoline_field_ = draw_mode_;
+    if ( show_isolines_ )
+        draw_isolines();
+
+    if ( !clip_planes_.empty() )
+    {
+        draw_sections();
+        disable_clip_planes();
+    }
 }
 
 void TCViewer::init() {
-    glDisable(GL_COLOR_MATERIAL);
-
     /////////////////////////////////////////////////////
     ///       Keyboard shortcut customization         ///
     ///      Changes standard action key bindings     ///
@@ -655,10 +1982,42 @@ void TCViewer::init() {
     /// add new keyboard event description
     setKeyDescription(Qt::SHIFT+Qt::Key_C, "Toggles GL_CULL_FACE");
     setKeyDescription(Qt::CTRL+Qt::Key_F, "Toggles GL_FOG");
+    setKeyDescription(Qt::Key_M, "Prints a memory report");
+    setKeyDescription(Qt::Key_BracketLeft, "Lowers the lower color range percentile");
+    setKeyDescription(Qt::Key_BracketRight, "Raises the lower color range percentile");
+    setKeyDescription(Qt::Key_BraceLeft, "Lowers the upper color range percentile");
+    setKeyDescription(Qt::Key_BraceRight, "Raises the upper color range percentile");
+    setKeyDescription(Qt::Key_K, "Switches the clipping plane moved by ctrl+mouse");
 
     /// add new mouse binding event description
     setMouseBindingDescription(Qt::ControlModifier, Qt::MiddleButton, "Choose Render Mode", true);
 
+    /// colormap for scalar fields, indexed by the normalized value
+    std::vector<GLubyte> colormap(3*256);
+    for (int i = 0; i < 256; ++i)
+    {
+        Vec3f c = interp_color(i/255.0f, 0.0f, 1.0f);
+        colormap[3*i+0] = static_cast<GLubyte>(c[0]);
+        colormap[3*i+1] = static_cast<GLubyte>(c[1]);
+        colormap[3*i+2] = static_cast<GLubyte>(c[2]);
+    }
+    glGenTextures(1, &colormap_id_);
+    glBindTexture(GL_TEXTURE_1D, colormap_id_);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB, 256, 0, GL_RGB, GL_UNSIGNED_BYTE, &colormap[0]);
+
+    setup_gl_state();
+
+    restoreStateFromFile();
+}
+
+void TCViewer::setup_gl_state()
+{
+    glDisable(GL_COLOR_MATERIAL);
+
     /// Fog
     GLfloat fogColor[4] = { 0.3, 0.3, 0.4, 1.0 };
     glFogi(GL_FOG_MODE,    GL_LINEAR);
@@ -671,10 +2030,530 @@ void TCViewer::init() {
     /// material and light
     setDefaultMaterial();
     setDefaultLight();
+}
 
-    restoreStateFromFile();
+void TCViewer::paintGL()
+{
+    TCViewerT<TCMesh>::paintGL();
+    emit frame_drawn();
+}
+
+void TCViewer::draw_as(const std::string& _mode)
+{
+    const std::string mode = draw_mode_;
+    const bool overlays = draw_overlays_;
+    draw_mode_     = _mode;
+    draw_overlays_ = false;
+
+    draw();
+
+    draw_mode_     = mode;
+    draw_overlays_ = overlays;
+}
+
+
+void TCViewer::keyPressEvent(QKeyEvent *e)
+{
+    if ((e->key() == Qt::Key_M) && (e->modifiers() == Qt::NoButton))
+        print_memory_report(std::cout);
+    else if (e->key() == Qt::Key_BracketLeft)
+        set_clip_percentiles(clip_lo_-1.0f, clip_hi_);
+    else if (e->key() == Qt::Key_BracketRight)
+        set_clip_percentiles(clip_lo_+1.0f, clip_hi_);
+    else if (e->key() == Qt::Key_BraceLeft)
+        set_clip_percentiles(clip_lo_, clip_hi_-1.0f);
+    else if (e->key() == Qt::Key_BraceRight)
+        set_clip_percentiles(clip_lo_, clip_hi_+1.0f);
+    else if ((e->key() == Qt::Key_Comma) && sequence_length())
+        set_sequence_frame(static_cast<int>((sequence_frame_+sequence_length()-1) % sequence_length()));
+    else if ((e->key() == Qt::Key_Period) && sequence_length())
+        set_sequence_frame(static_cast<int>((sequence_frame_+1) % sequence_length()));
+    else if ((e->key() == Qt::Key_K) && (e->modifiers() == Qt::NoButton) && !clip_planes_.empty())
+    {
+        active_plane_ = (active_plane_+1) % clip_planes_.size();
+        setManipulatedFrame(clip_planes_[active_plane_].frame);
+        std::cout << "Clipping plane " << active_plane_+1 << " of " << clip_planes_.size() << std::endl;
+        request_redraw();
+    }
+    else
+        TCViewerT<TCMesh>::keyPressEvent(e);
+}
+
+///-----------------------------------------------------------------------------
+/// scalar fields
+///-----------------------------------------------------------------------------
+TCViewer::ScalarField& TCViewer::scalar_field(const std::string& _name)
+{
+    ScalarField& field = scalar_fields_[_name];
+    if ( !field.values.empty() || !mesh_.n_vertices() )
+        return field;
+
+    /// fields are computed on first use only
+    OpenMesh::Utils::Timer t;
+    t.start();
+
+    if ( _name == "Valence" )
+    {
+        compute_valence(mesh_, field.values);
+        TCMesh::VertexIter vIt(mesh_.vertices_begin()), vEnd(mesh_.vertices_end());
+        for (; vIt!=vEnd; ++vIt)
+            mesh_.data(*vIt).set_valence(field.values[vIt->idx()]);
+    }
+    else if ( _name == "GaussianCurvature" )
+        compute_gaussian_curvature(mesh_, field.values);
+    else if ( _name == "MeanCurvature" )
+        compute_mean_curvature(mesh_, field.values);
+    else if ( _name == "Components" )
+    {
+        /// golden ratio steps spread consecutive components over the colormap
+        std::vector<unsigned int> labels;
+        TopologyReport topology;
+        analyze_topology(mesh_, topology, &labels);
+        field.values.resize(labels.size());
+        for (size_t i = 0; i < labels.size(); ++i)
+        {
+            const double x = 0.6180339887*labels[i];
+            field.values[i] = static_cast<float>(x - std::floor(x));
+        }
+        std::clog << topology.components << " components" << std::endl;
+    }
+    else if ( _name == "Distance" )
+    {
+        if ( reference_bvh_.empty() )
+        {
+            std::cerr << "Distance: open a reference mesh first" << std::endl;
+            return field;
+        }
+        const size_t nv = mesh_.n_vertices();
+        const float* points = &mesh_.points()[0][0];
+        field.values.resize(nv);
+
+        QElapsedTimer timer;
+        timer.start();
+        const float forward = reference_bvh_.distances(points, nv, &field.values[0]);
+        const double seconds = 1e-9*timer.nsecsElapsed();
+        std::clog << "Distance to reference: " << nv << " queries in " << seconds << " s ("
+                  << 1e-6*nv/std::max(seconds, 1e-9) << " M queries/s)" << std::endl;
+
+        /// the other direction needs a BVH over this mesh, vertex sampled
+        /// like the forward one
+        float backward = 0.0f;
+        if ( mesh_.n_faces() )
+        {
+            std::vector<unsigned int> triangles;
+            triangle_indices(mesh_, triangles);
+            TriangleBVH bvh;
+            bvh.build(points, nv, &triangles[0], mesh_.n_faces());
+            std::vector<float> values(reference_points_.size()/3);
+            backward = bvh.distances(&reference_points_[0], values.size(), &values[0]);
+        }
+        std::clog << "Hausdorff distance: mesh to reference " << forward
+                  << ", reference to mesh " << backward
+                  << ", symmetric " << std::max(forward, backward) << std::endl;
+    }
+    else if ( _name == "Sequence" )
+    {
+        std::cerr << "Sequence: open a scalar sequence first" << std::endl;
+        return field;
+    }
+    else if ( _name == "Geodesic" )
+    {
+        /// the factorization is the expensive part and is kept until the
+        /// geometry changes, every further source is two back-substitutions
+        if ( !geodesics_.factored() )
+        {
+            std::vector<unsigned int> triangles;
+            triangle_indices(mesh_, triangles);
+            if ( triangles.empty() ||
+                 !geodesics_.factor(&mesh_.points()[0][0], mesh_.n_vertices(),
+                                    &triangles[0], triangles.size()/3) )
+            {
+                std::cerr << "Geodesic: factorization failed" << std::endl;
+                return field;
+            }
+            std::clog << "Factored heat method operators [" << geodesics_.factor_seconds()
+                      << " s]" << std::endl;
+        }
+        if ( geodesic_source_ >= mesh_.n_vertices() )
+            geodesic_source_ = 0;
+        geodesics_.distances(geodesic_source_, field.values);
+        std::clog << "Geodesic distance from vertex " << geodesic_source_ << " ["
+                  << 1000.0*geodesics_.solve_seconds() << " ms]" << std::endl;
+    }
+
+    if ( !field.values.empty() )
+    {
+        field.histogram.compute(&field.values[0], field.values.size());
+        field.version = ++field_version_;
+    }
+
+    t.stop();
+    std::clog << "Computed " << _name << " and its histogram ["
+              << t.as_string() << "]" << std::endl;
+    return field;
+}
+
+void TCViewer::update_derived(const std::vector<unsigned int>& _vertices,
+                              const std::vector<unsigned int>& _faces)
+{
+    /// operators, isolines and occlusion depend on the geometry
+    geodesics_.clear();
+    isoline_version_ = 0;
+    if ( show_occlusion_ )
+        occlusion_timer_.start();
+    if ( !clip_planes_.empty() )
+        section_timer_.start();
+
+    std::map<std::string, ScalarField>::iterator it;
+    for (it = scalar_fields_.begin(); it != scalar_fields_.end(); ++it)
+        if ( !it->second.values.empty() )
+            break;
+    if ( it == scalar_fields_.end() )
+        return;
+
+    /// curvature of a vertex depends on its incident faces only; empty
+    /// lists stand for the whole mesh, which is re-evaluated without one
+    std::vector<unsigned int> vertices;
+    const bool all = _vertices.empty() && _faces.empty();
+    if ( !all )
+    {
+        vertices.reserve(3*_faces.size());
+        for (size_t i = 0; i < _faces.size(); ++i)
+            for (TCMesh::FaceVertexIter fv_it=mesh_.fv_iter(TCMesh::FaceHandle(_faces[i])); fv_it.is_valid(); ++fv_it)
+                vertices.push_back(fv_it->idx());
+        std::sort(vertices.begin(), vertices.end());
+        vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+    }
+
+    for (it = scalar_fields_.begin(); it != scalar_fields_.end(); ++it)
+    {
+        ScalarField& field = it->second;
+        if ( field.values.empty() )
+            continue;
+
+        if ( it->first == "Geodesic" )
+        {
+            /// distances are global, recompute on the next draw
+            field.values.clear();
+            if ( active_scalar_ == it->first )
+                active_scalar_.clear();
+            continue;
+        }
+        else if ( it->first == "Distance" )
+        {
+            const long n = static_cast<long>(all ? mesh_.n_vertices() : vertices.size());
+#pragma omp parallel for schedule(dynamic, 1024)
+            for (long i = 0; i < n; ++i)
+            {
+                const unsigned int v = all ? static_cast<unsigned int>(i) : vertices[i];
+                field.values[v] =
+                    std::sqrt(reference_bvh_.closest_point(mesh_.point(TCMesh::VertexHandle(v)).data()));
+            }
+        }
+        else if ( it->first == "GaussianCurvature" )
+            compute_gaussian_curvature(mesh_, field.values, all ? 0 : &vertices);
+        else if ( it->first == "MeanCurvature" )
+            compute_mean_curvature(mesh_, field.values, all ? 0 : &vertices);
+        else
+            continue;
+
+        field.histogram.compute(&field.values[0], field.values.size());
+        field.version = ++field_version_;
+        if ( active_scalar_ == it->first )
+        {
+            if ( all )
+                buffers_.mark_dirty(MeshBuffers::Scalar, 0, mesh_.n_vertices());
+            else
+                buffers_.mark_dirty(MeshBuffers::Scalar, vertices);
+        }
+    }
+}
+
+int TCViewer::closest_vertex(const Vec3f& _p) const
+{
+    const long n = static_cast<long>(mesh_.n_vertices());
+    int   best = -1;
+    float best_d2 = std::numeric_limits<float>::max();
+
+#pragma omp parallel
+    {
+        int   local = -1;
+        float local_d2 = std::numeric_limits<float>::max();
+#pragma omp for schedule(static) nowait
+        for (long i = 0; i < n; ++i)
+        {
+            const float d2 = (mesh_.point(TCMesh::VertexHandle(static_cast<int>(i))) - _p).sqrnorm();
+            if ( d2 < local_d2 )
+            {
+                local_d2 = d2;
+                local = static_cast<int>(i);
+            }
+        }
+#pragma omp critical
+        if ( local >= 0 && (local_d2 < best_d2 || (local_d2 == best_d2 && local < best)) )
+        {
+            best_d2 = local_d2;
+            best = local;
+        }
+    }
+    return best;
+}
+
+void TCViewer::postSelection(const QPoint& _point)
+{
+    if ( !mesh_.n_vertices() )
+    {
+        if ( !triangles_.empty() )
+            std::cerr << "Geodesic: not available for view-only meshes" << std::endl;
+        return;
+    }
+
+    bool found = false;
+    qglviewer::Vec p = camera()->pointUnderPixel(_point, found);
+    if ( !found )
+        return;
+
+    int v = closest_vertex(Vec3f(p.x, p.y, p.z));
+    if ( v < 0 )
+        return;
+
+    geodesic_source_ = static_cast<unsigned int>(v);
+    scalar_fields_["Geodesic"].values.clear();
+    if ( active_scalar_ == "Geodesic" )
+        active_scalar_.clear();
+    std::cout << "Geodesic source: vertex " << geodesic_source_ << std::endl;
+    request_redraw();
+}
+
+void TCViewer::set_clip_percentiles(float _lo, float _hi)
+{
+    clip_lo_ = std::max(0.0f, std::min(_lo, 99.0f));
+    clip_hi_ = std::min(100.0f, std::max(_hi, clip_lo_+1.0f));
+
+    std::cout << "Color range: " << clip_lo_ << "% - " << clip_hi_ << "%" << std::endl;
+    request_redraw();
+}
+
+void TCViewer::draw_scalar_field(const std::string& _name)
+{
+    ScalarField& field = scalar_field(_name);
+    if ( field.values.empty() )
+        return;
+
+    /// only the active field lives on the GPU
+    if ( active_scalar_ != _name )
+    {
+        buffers_.upload(MeshBuffers::Scalar, &field.values[0], sizeof(float), field.values.size());
+        active_scalar_ = _name;
+    }
+    else
+        buffers_.flush(MeshBuffers::Scalar, &field.values[0]);
+
+    float lo, hi;
+    color_range(_name, field, lo, hi);
+
+    glDisable(GL_LIGHTING);
+    glShadeModel(GL_SMOOTH);
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+
+    glEnable(GL_TEXTURE_1D);
+    glBindTexture(GL_TEXTURE_1D, colormap_id_);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+
+    /// map [lo,hi] onto the colormap, values outside are clamped
+    glMatrixMode(GL_TEXTURE);
+    glPushMatrix();
+    glLoadIdentity();
+    glScalef(1.0f/(hi-lo), 1.0f, 1.0f);
+    glTranslatef(-lo, 0.0f, 0.0f);
+    glMatrixMode(GL_MODELVIEW);
+
+    enable_array(MeshBuffers::Position);
+    enable_array(MeshBuffers::Scalar);
+    draw_triangles();
+    disable_arrays();
+
+    glMatrixMode(GL_TEXTURE);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glDisable(GL_TEXTURE_1D);
+
+    if ( draw_overlays_ && !interacting() && _name != "Components" )
+        draw_legend(field, lo, hi);
 }
 
+void TCViewer::color_range(const std::string& _name, const ScalarField& _field,
+                           float& _lo, float& _hi) const
+{
+    _lo = _field.histogram.percentile(0.01f*clip_lo_);
+    _hi = _field.histogram.percentile(0.01f*clip_hi_);
+    /// component colors are labels, not magnitudes
+    if ( _name == "Components" )
+    {
+        _lo = 0.0f;
+        _hi = 1.0f;
+    }
+    if ( _hi-_lo <= 1e-12f*std::max(std::fabs(_lo), 1.0f) )
+    {
+        _lo -= 0.5f;
+        _hi += 0.5f;
+    }
+}
+
+bool TCViewer::is_scalar_mode(const std::string& _mode)
+{
+    return _mode == "Valence" ||
+           _mode == "GaussianCurvature" ||
+           _mode == "MeanCurvature" ||
+           _mode == "Geodesic" ||
+           _mode == "Components" ||
+           _mode == "Distance" ||
+           _mode == "Sequence";
+}
+
+void TCViewer::draw_virtual_texture()
+{
+    /// tiles decoded since the last frame first, then this frame's requests;
+    /// framebuffer objects are not shared with linked views
+    vtex_.update();
+    if ( QGLContext::currentContext() == context() && vtex_.begin_feedback() )
+    {
+        draw_triangles();
+        vtex_.end_feedback();
+    }
+
+    if ( vtex_.bind(tex_mode_ == GL_MODULATE) )
+    {
+        draw_triangles();
+        vtex_.release();
+    }
+    else
+        draw_triangles();
+}
+
+void TCViewer::draw_isolines()
+{
+    if ( isoline_field_.empty() )
+        isoline_field_ = "MeanCurvature";
+
+    /// view-only meshes keep the lines they had, there are no positions
+    /// left to extract new ones from
+    if ( mesh_.n_vertices() )
+    {
+        ScalarField& field = scalar_field(isoline_field_);
+        if ( field.values.empty() )
+            return;
+
+        std::vector<float> levels(isoline_values_);
+        if ( levels.empty() )
+        {
+            float lo, hi;
+            color_range(isoline_field_, field, lo, hi);
+            even_levels(lo, hi, isoline_count_, levels);
+        }
+
+        if ( !isoline_version_ || field.version != isoline_version_ ||
+             isoline_source_ != isoline_field_ || levels != isoline_levels_ )
+        {
+            QElapsedTimer timer;
+            timer.start();
+
+            std::vector<unsigned int> triangles;
+            triangle_indices(mesh_, triangles);
+            std::vector<float> segments;
+            extract_isolines(&mesh_.points()[0][0], &field.values[0],
+                             triangles.empty() ? 0 : &triangles[0], triangles.size()/3,
+                             levels, segments);
+            buffers_.upload(MeshBuffers::Isoline, segments.empty() ? 0 : &segments[0],
+                            3*sizeof(float), segments.size()/3);
+
+            /// quiet while smoothing, every iteration extracts again
+            if ( !smooth_timer_.isActive() )
+                std::clog << "Extracted " << segments.size()/6 << " isoline segments of "
+                          << isoline_field_ << " at " << levels.size() << " levels ["
+                          << 1e-6*timer.nsecsElapsed() << " ms]" << std::endl;
+
+            isoline_source_  = isoline_field_;
+            isoline_version_ = field.version;
+            isoline_levels_.swap(levels);
+        }
+    }
+
+    const GLsizei n = static_cast<GLsizei>(buffers_.n_elements(MeshBuffers::Isoline));
+    if ( !n || !buffers_.bind(MeshBuffers::Isoline) )
+        return;
+
+    glDisable(GL_LIGHTING);
+    glColor4f(0.0f, 0.0f, 0.0f, 1.0f);
+    glLineWidth(1.5f);
+    /// the lines lie on the surface, pull them a little towards the eye
+    glDepthRange(0.0, 0.9999);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, 0);
+    glDrawArrays(GL_LINES, 0, n);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    buffers_.release(MeshBuffers::Isoline);
+
+    glDepthRange(0.0, 1.0);
+    glLineWidth(1.0f);
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+void TCViewer::draw_legend(const ScalarField& _field, float _lo, float _hi)
+{
+    const int w = 16, h = std::min(256, height()-80);
+    const int x0 = width()-w-20, y0 = 40;
+    if ( h <= 0 )
+        return;
+
+    /// histogram of the clipped range, one row per 2 pixels
+    std::vector<size_t> rows;
+    _field.histogram.counts(_lo, _hi, h/2, rows);
+    size_t peak = rows.empty() ? 0 : *std::max_element(rows.begin(), rows.end());
+
+    /// screen coordinates, out of reach of the clipping planes
+    glPushAttrib(GL_TRANSFORM_BIT);
+    for (int i = 0; i < max_clip_planes; ++i)
+        glDisable(GL_CLIP_PLANE0+i);
+
+    glDisable(GL_LIGHTING);
+    glDisable(GL_DEPTH_TEST);
+    startScreenCoordinatesSystem();
+
+    glEnable(GL_TEXTURE_1D);
+    glBindTexture(GL_TEXTURE_1D, colormap_id_);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    glBegin(GL_QUADS);
+    glTexCoord1f(1.0f); glVertex2i(x0,   y0);
+    glTexCoord1f(1.0f); glVertex2i(x0+w, y0);
+    glTexCoord1f(0.0f); glVertex2i(x0+w, y0+h);
+    glTexCoord1f(0.0f); glVertex2i(x0,   y0+h);
+    glEnd();
+    glDisable(GL_TEXTURE_1D);
+
+    if ( peak )
+    {
+        glColor3f(0.8f, 0.8f, 0.8f);
+        glBegin(GL_LINES);
+        for (size_t r = 0; r < rows.size(); ++r)
+        {
+            float y = y0+h - (r+0.5f)*h/rows.size();
+            float l = 40.0f*rows[r]/peak;
+            glVertex2f(x0-2.0f,   y);
+            glVertex2f(x0-2.0f-l, y);
+        }
+        glEnd();
+    }
+
+    stopScreenCoordinatesSystem();
+    glEnable(GL_DEPTH_TEST);
+
+    glColor3f(1.0f, 1.0f, 1.0f);
+    drawText(x0-60, y0-8,    QString("%1 (%2%)").arg(_hi, 0, 'g', 4).arg(clip_hi_));
+    drawText(x0-60, y0+h+16, QString("%1 (%2%)").arg(_lo, 0, 'g', 4).arg(clip_lo_));
+    glPopAttrib();
+}
 
 ///-----------------------------------------------------------------------------
 /// Utilities
@@ -682,51 +2561,81 @@ void TCViewer::init() {
 void TCViewer::Smooth()
 {
     set_draw_mode("Smooth");
-    updateGL();
+    request_redraw(false);
 }
 
 void TCViewer::Flat()
 {
     set_draw_mode("Flat");
-    updateGL();
+    request_redraw(false);
 }
 
 void TCViewer::Wireframe()
 {
     set_draw_mode("Wireframe");
-    updateGL();
+    request_redraw(false);
 }
 
 void TCViewer::Points()
 {
     set_draw_mode("Points");
-    updateGL();
+    request_redraw(false);
 }
 
 void TCViewer::HiddenLine()
 {
     set_draw_mode("Hidden-Line");
-    updateGL();
+    request_redraw(false);
 }
 
 void TCViewer::Valence()
 {
     set_draw_mode("Valence");
-    updateGL();
+    request_redraw(false);
 }
 
 void TCViewer::GaussianCurvature()
 {
     std::cout << "Gaussian Curvature!" << std::endl;
     set_draw_mode("GaussianCurvature");
-    updateGL();
+    request_redraw(false);
 }
 
 void TCViewer::MeanCurvature()
 {
     std::cout << "Mean Curvature!" << std::endl;
     set_draw_mode("MeanCurvature");
-    updateGL();
+    request_redraw(false);
+}
+
+void TCViewer::Components()
+{
+    std::cout << "Connected Components!" << std::endl;
+    set_draw_mode("Components");
+    request_redraw(false);
+}
+
+void TCViewer::Distance()
+{
+    std::cout << "Distance to Reference!" << std::endl;
+    set_draw_mode("Distance");
+    request_redraw(false);
+}
+
+void TCViewer::Sequence()
+{
+    std::cout << "Scalar Sequence!" << std::endl;
+    set_draw_mode("Sequence");
+    request_redraw(false);
+}
+
+void TCViewer::Geodesic()
+{
+    std::cout << "Geodesic Distance!" << std::endl;
+    if ( !mesh_.n_vertices() && !triangles_.empty() )
+        std::cerr << "Geodesic: not available for view-only meshes" << std::endl;
+    set_draw_mode("Geodesic");
+    request_redraw(false);
 }
 
 void TCViewer::about()
@@ -3,39 +3,35 @@
 #include <QString>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <map>
+#include <QGLViewer/manipulatedFrame.h>
+#include <QGLViewer/constraint.h>
 #include <OpenMesh/Core/IO/MeshIO.hh>
 #include <OpenMesh/Tools/Utils/getopt.h>
 #include <OpenMesh/Tools/Utils/Timer.hh>
 #include <OpenMesh/Core/Mesh/TriMesh_ArrayKernelT.hh>
 #include <OpenMesh/Core/Mesh/Traits.hh>
 
+#include "TCMesh.h"
 #include "TCViewerT.h"
+#include "ScalarHistogram.h"
+#include "HeatGeodesics.h"
+#include "MeshSmoothing.h"
+#include "TriangleBVH.h"
+#include "IsoLines.h"
+#include "VirtualTexture.h"
+#include "AmbientOcclusion.h"
+#include "ScalarSequence.h"
+#include "VertexAnimation.h"
 #include "MainWindow.h"
 
-//== CLASS DEFINITION =========================================================
 using namespace OpenMesh;  
 using namespace OpenMesh::Attributes;
 
-struct TCTraits : public OpenMesh::DefaultTraits
-{
-    VertexTraits
-    {
-        typedef OpenMesh::Vec3f Color;
-    private:
-        float  valence;
-        Color valence_color;
-
-    public:
-        void set_valence (const float _val) { valence=_val; }
-        float get_valence () { return valence; }
-
-        void set_valence_color (Color _val_color) { valence_color=_val_color; }
-        Color get_valence_color () { return valence_color; }
-    };
-};
-
-typedef OpenMesh::TriMesh_ArrayKernelT<TCTraits>  TCMesh;
-
 //== CLASS DEFINITION =========================================================
 class TCViewer : public TCViewerT<TCMesh>
 {
@@ -43,9 +39,7 @@ class TCViewer : public TCViewerT<TCMesh>
 
 public:
     /// default constructor
-    TCViewer(QWidget* parent=0) : TCViewerT<TCMesh>(parent)
-    {
-    }
+    TCViewer(QWidget* parent=0);
     OpenMesh::IO::Options& options() { return _options; }
     const OpenMesh::IO::Options& options() const { return _options; }
     void setOptions(const OpenMesh::IO::Options& opts) {  VertexAttributes( OpenMesh::Attributes::Normal |
@@ -53,11 +47,29 @@ public:
 
     /// open mesh
     virtual bool open_mesh(const char* _filename, OpenMesh::IO::Options _opt);
+    /// normals, scene bounds, derived fields and GPU buffers of a freshly
+    /// filled mesh(), _opt tells which attributes came with the data
+    bool prepare_mesh(OpenMesh::IO::Options _opt);
+    /// attributes every loaded mesh gets
+    static void request_attributes(TCMesh& _mesh);
+
+    /// Load a mesh to compare against: only its vertices and a BVH over its
+    /// triangles are kept. The Distance mode colors every vertex by its
+    /// distance to it.
+    bool open_reference(const char* _filename);
 
     /// load texture
     virtual bool open_texture( const char *_filename );
     bool set_texture( QImage& _texsrc );
 
+    /// Texture from a tile pyramid instead, for images past
+    /// GL_MAX_TEXTURE_SIZE or the texture budget; open_texture() takes this
+    /// path by itself. The pyramid is cached next to the image (or in the
+    /// temp directory) and built in the background when missing or stale.
+    bool open_virtual_texture(const QString& _image);
+    /// bytes of tiles kept on the GPU, 256 MB by default
+    void set_texture_budget(size_t _bytes) { texture_budget_ = _bytes; }
+
     void open_mesh_gui(QString fname);
     void open_texture_gui(QString fname);
 
@@ -65,21 +77,299 @@ public:
     Vec3f interp_color(float _val);
     Vec3f interp_color(float _val, float range_min, float range_max);
 
+    /// Render _frames frames at _width x _height offscreen and write them as
+    /// PNGs into _dir. The camera either orbits the scene center once
+    /// (_keyframes < 0) or follows the given QGLViewer keyframe path.
+    bool export_animation(const QString& _dir, int _frames, int _width, int _height,
+                          int _keyframes=-1, int _jobs=0);
+
+    /// bytes per mesh property, derived array and GPU buffer, and process RSS
+    void print_memory_report(std::ostream& _os);
+
+    /// Draw the mesh in _mode into the current GL context, which has to
+    /// share this viewer's objects (see LinkedView). Overlays are skipped.
+    void draw_as(const std::string& _mode);
+    /// fog, material and lights of a fresh context
+    void setup_gl_state();
+
+    /// clip the scalar colormap to the given percentiles of each field
+    void set_clip_percentiles(float _lo, float _hi);
+
+    /// Smooth the mesh by _iterations Laplacian or Taubin iterations of step
+    /// _lambda, one iteration per event loop pass so normals, buffers and
+    /// the view follow every iteration
+    void smooth(bool _taubin, int _iterations, float _lambda=0.5f);
+
+    /// Isolines at _count levels evenly spaced within the colored range of
+    /// the field, or at the given values. They follow the last scalar mode
+    /// shown and overlay every mode while enabled.
+    void set_isoline_levels(int _count);
+    void set_isoline_levels(const std::vector<float>& _values);
+
+    /// Rays of the ambient occlusion bake end after _fraction of the
+    /// bounding box diagonal; a running or shown bake starts over.
+    void set_occlusion_radius(float _fraction);
+
+    /// Map a file of per-vertex float32 frames (see ScalarSequence) and
+    /// show the current frame in the Sequence mode, colored over a range
+    /// sampled from the whole sequence
+    bool open_scalar_sequence(const QString& _file);
+    /// Map a file of xyz float32 positions per vertex and frame (see
+    /// VertexAnimation) that deform the current mesh. It plays in step
+    /// with a scalar sequence; needs the CPU mesh.
+    bool open_animation(const QString& _file);
+    /// playback speed, 30 frames per second by default
+    void set_sequence_fps(double _fps);
+
+    /// at most this many clipping planes
+    enum { max_clip_planes = 4 };
+
     qglviewer::Vec OMVec3f_to_QGLVec(OpenMesh::Vec3f OMVec3f)
     { return qglviewer::Vec(OMVec3f.values_[0], OMVec3f.values_[1], OMVec3f.values_[2]); }
 
+    /// compare face-vertex connectivity of two meshes
+    static bool same_topology(const TCMesh& _a, const TCMesh& _b);
+
+signals:
+    /// emitted after each frame of this widget, linked views repaint along
+    void frame_drawn();
+
+    void scalar_sequence_opened();
+    /// frames of the longest open sequence, 0: none left
+    void sequence_length_changed(int _n_frames);
+    void sequence_frame_changed(int _frame);
+
 public slots:
     void query_open_mesh_file();
     void query_open_texture_file();
+    void query_open_reference_file();
+
+    /// keep only GPU buffers (and a triangle list) of meshes loaded from now on
+    void set_view_only(bool _on);
+
+    /// reload the current mesh file whenever it is rewritten on disk
+    void set_watch_file(bool _on);
+
+    /// switch the GPU vertex layout and report bytes per vertex and the
+    /// frame time before and after
+    void set_quantized_vertices(bool _on);
+
+    void query_export_animation();
+    void query_smooth();
+
+    void set_isolines(bool _on);
+    void query_isoline_levels();
+
+    /// bake ambient occlusion of every mesh loaded or edited from now on
+    /// and darken Smooth shading by it
+    void set_ambient_occlusion(bool _on);
+    void query_occlusion_radius();
+
+    /// A clipping plane through the scene center facing the camera, which
+    /// removes the half in front of it and becomes the plane moved by
+    /// ctrl+mouse; its cross-section is outlined. K switches planes.
+    void add_clip_plane();
+    void clear_clip_planes();
+
+    void query_open_scalar_sequence();
+    void query_open_animation();
+    /// Play the open sequences from the current frame, looping. Frames
+    /// follow the clock, one that is not ready in time is skipped; stopping
+    /// reports the frame rate, dropped frames and I/O throughput achieved.
+    void set_sequence_playing(bool _on);
+    /// jump to _frame, playback continues from there
+    void set_sequence_frame(int _frame);
 
 protected:
     virtual void draw();
     virtual void init();
+    virtual void paintGL();
+    virtual void keyPressEvent(QKeyEvent *e);
+    /// shift+click: the vertex closest to the picked point becomes the
+    /// geodesic source
+    virtual void postSelection(const QPoint& _point);
+
+    virtual void update_derived(const std::vector<unsigned int>& _vertices,
+                                const std::vector<unsigned int>& _faces);
+
+private:
+    /// per-vertex scalar field shown through the colormap
+    struct ScalarField
+    {
+        ScalarField() : version(0) {}
+
+        std::vector<float> values;
+        ScalarHistogram    histogram;
+        unsigned int       version;   ///< changes whenever the values do
+    };
+
+    static bool is_scalar_mode(const std::string& _mode);
+
+    /// field of the given draw mode, computed on first access
+    ScalarField& scalar_field(const std::string& _name);
+    void draw_scalar_field(const std::string& _name);
+    void draw_legend(const ScalarField& _field, float _lo, float _hi);
+    /// values mapped onto the ends of the colormap
+    void color_range(const std::string& _name, const ScalarField& _field, float& _lo, float& _hi) const;
+    /// extract the isolines if field, levels or geometry changed, then draw them
+    void draw_isolines();
+    /// Smooth shading through vtex_ with position, normal and texcoord
+    /// arrays enabled; the view's own context also renders the feedback pass
+    void draw_virtual_texture();
+    bool use_virtual_texture(const QString& _pack);
+
+    /// build the BVH and start the first bake pass, from the CPU mesh
+    void start_occlusion();
+    /// upload the baked values if they changed; false if there are none
+    bool update_occlusion();
+
+    /// build the BVH of the cross-sections on a pool thread, from the CPU mesh
+    void start_section_bvh();
+    /// GL clip planes in world coordinates, the current modelview
+    void enable_clip_planes();
+    void disable_clip_planes();
+    /// cut the planes that moved or whose BVH is new, then outline them
+    void draw_sections();
+
+    /// frames of the longest open sequence
+    size_t sequence_length() const;
+    /// copy the scalars of frame _frame into the Sequence field and mark
+    /// its buffer for upload; positions are applied separately
+    void show_sequence_frame(size_t _frame);
+    /// the worker's frame becomes the mesh's geometry
+    void apply_animation_frame();
+    /// show _frame at once, prepared on this thread; playback continues
+    /// from there
+    void seek_sequence(size_t _frame);
+    void close_scalar_sequence();
+    void close_animation();
+    void report_sequence_playback();
+
+    /// index of the vertex closest to _p, -1 for an empty mesh
+    int closest_vertex(const Vec3f& _p) const;
+
+    /// average seconds per synchronously drawn frame
+    double time_frames(int _n);
 
 private:
     OpenMesh::IO::Options _options;
 
+    /// scalar fields keyed by draw mode, colored between clip percentiles
+    std::map<std::string, ScalarField> scalar_fields_;
+    std::string            active_scalar_;
+    unsigned int           field_version_;   ///< last ScalarField::version handed out
+    float                  clip_lo_, clip_hi_;
+    GLuint                 colormap_id_;
+    bool                   draw_overlays_;
+    size_t                 tex_bytes_;
+    bool                   view_only_;
+
+    /// heat method operators, factored on the first geodesic query
+    HeatGeodesics          geodesics_;
+    unsigned int           geodesic_source_;
+
+    /// reference mesh of the Distance mode
+    TriangleBVH            reference_bvh_;
+    std::vector<float>     reference_points_;
+
+    /// isolines of isoline_field_, uploaded as MeshBuffers::Isoline
+    bool                   show_isolines_;
+    std::string            isoline_field_;
+    int                    isoline_count_;
+    std::vector<float>     isoline_values_;   ///< explicit levels, or empty
+    std::string            isoline_source_;   ///< field, version and levels
+    unsigned int           isoline_version_;  ///< of the uploaded lines,
+    std::vector<float>     isoline_levels_;   ///< version 0 forces extraction
+
+    /// running smoothing, advanced by smooth_timer_
+    VertexAdjacency        smooth_adjacency_;
+    std::vector<TCMesh::Point> smooth_scratch_;
+    QTimer                 smooth_timer_;
+    bool                   smooth_taubin_;
+    float                  smooth_lambda_;
+    int                    smooth_remaining_, smooth_done_;
+    double                 smooth_seconds_;
+
+    /// texture streamed from a tile pyramid, and the pyramid being built
+    VirtualTexture         vtex_;
+    size_t                 texture_budget_;
+    QFutureWatcher<bool>   tiling_watcher_;
+    QString                tiling_pack_;
+
+    /// Ambient occlusion, baked in passes on a pool thread; each finished
+    /// pass is uploaded as MeshBuffers::Occlusion
+    AmbientOcclusion       occlusion_;
+    bool                   show_occlusion_;
+    float                  occlusion_radius_;   ///< fraction of the bounding box diagonal
+    int                    occlusion_rays_;     ///< per vertex when the bake is done
+    bool                   occlusion_dirty_;    ///< values newer than the buffer
+    QFutureWatcher<bool>   occlusion_watcher_;
+    QTimer                 occlusion_timer_;    ///< restarts the bake once edits settle
+    QElapsedTimer          occlusion_clock_;
+
+    /// Clipping planes on manipulated frames, each removing the half its z
+    /// axis points to, and their cross-sections cut from section_bvh_
+    struct ClipPlane
+    {
+        qglviewer::ManipulatedFrame* frame;
+        float                        plane[4];   ///< world coordinates, of section
+        std::vector<float>           section;    ///< segment end points
+    };
+    std::vector<ClipPlane> clip_planes_;
+    size_t                 active_plane_;
+    qglviewer::LocalConstraint clip_constraint_; ///< translation along the normal
+    TriangleBVH            section_bvh_;
+    std::vector<float>     section_points_;     ///< input of a build in flight
+    std::vector<unsigned int> section_triangles_;
+    QFutureWatcher<bool>   section_watcher_;
+    QTimer                 section_timer_;      ///< rebuilds the BVH once edits settle
+    QElapsedTimer          section_clock_;
+
+    /// Scalar sequence shown in the Sequence mode
+    ScalarSequence         scalar_sequence_;
+    ScalarHistogram        sequence_histogram_;   ///< of all frames, fixes the color range
+
+    /// Vertex animation, the next frame prepared by animation_watcher_
+    VertexAnimation        animation_;
+    QFutureWatcher<void>   animation_watcher_;
+    long                   animation_step_;       ///< frame period it prepares for
+    double                 animation_apply_seconds_;
+
+    /// Timeline of both; while playing, sequence_timer_ shows the frame
+    /// sequence_clock_ is at
+    size_t                 sequence_frame_;
+    QTimer                 sequence_timer_;
+    QElapsedTimer          sequence_clock_;
+    QElapsedTimer          sequence_wall_;        ///< since play, for the report
+    double                 sequence_fps_;
+    size_t                 sequence_start_;       ///< frame at the clock's start
+    long                   sequence_steps_;       ///< frame periods since then
+    size_t                 sequence_shown_, sequence_dropped_;
+
+    /// file watching and background reload
+    QString                mesh_file_;
+    QString                reload_file_;
+    bool                   watch_file_;
+    QFileSystemWatcher     file_watcher_;
+    QTimer                 reload_timer_;
+    QFutureWatcher<bool>   reload_watcher_;
+    TCMesh                 reload_mesh_;
+    OpenMesh::IO::Options  reload_opt_;
+    bool                   reload_pending_;
+
 private slots:
+    void mesh_file_changed(const QString& _path);
+    void start_reload();
+    void finish_reload();
+    void smooth_step();
+    void finish_tiling();
+    void tiles_ready();
+    void occlusion_pass_done();
+    void restart_occlusion();
+    void restart_section_bvh();
+    void section_bvh_done();
+    void sequence_tick();
+
     void Smooth();
     void Flat();
     void Wireframe();
@@ -88,6 +378,10 @@ private slots:
     void Valence();
     void GaussianCurvature();
     void MeanCurvature();
+    void Geodesic();
+    void Components();
+    void Distance();
+    void Sequence();
 
     void about();
     void aboutQt();
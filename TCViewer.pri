@@ -0,0 +1,72 @@
+# viewer sources and dependencies shared by the application and the benchmark
+
+INCLUDEPATH *= $$PWD
+
+HEADERS  += $$PWD/TCViewerT.h $$PWD/TCViewer.h \
+    $$PWD/MainWindow.h \
+    $$PWD/MeshBuffers.h \
+    $$PWD/TCMesh.h \
+    $$PWD/ScalarHistogram.h \
+    $$PWD/ScalarSequence.h \
+    $$PWD/VertexAnimation.h \
+    $$PWD/MeshAnalysis.h \
+    $$PWD/FrameExporter.h \
+    $$PWD/MeshKernelsT.h \
+    $$PWD/MemoryReport.h \
+    $$PWD/MeshReader.h \
+    $$PWD/VertexQuantization.h \
+    $$PWD/VertexLayouts.h \
+    $$PWD/VertexSplit.h \
+    $$PWD/HeatGeodesics.h \
+    $$PWD/MeshSmoothing.h \
+    $$PWD/MeshTopology.h \
+    $$PWD/LinkedView.h \
+    $$PWD/TriangleBVH.h \
+    $$PWD/IsoLines.h \
+    $$PWD/TilePyramid.h \
+    $$PWD/VirtualTexture.h \
+    $$PWD/AmbientOcclusion.h \
+    $$PWD/BatchAnalysis.h
+SOURCES  += $$PWD/TCViewerT.cpp \
+    $$PWD/TCViewer.cpp \
+    $$PWD/MainWindow.cpp \
+    $$PWD/MeshBuffers.cpp \
+    $$PWD/ScalarHistogram.cpp \
+    $$PWD/ScalarSequence.cpp \
+    $$PWD/VertexAnimation.cpp \
+    $$PWD/MeshAnalysis.cpp \
+    $$PWD/FrameExporter.cpp \
+    $$PWD/MemoryReport.cpp \
+    $$PWD/MeshReader.cpp \
+    $$PWD/VertexQuantization.cpp \
+    $$PWD/VertexLayouts.cpp \
+    $$PWD/VertexSplit.cpp \
+    $$PWD/HeatGeodesics.cpp \
+    $$PWD/MeshSmoothing.cpp \
+    $$PWD/MeshTopology.cpp \
+    $$PWD/LinkedView.cpp \
+    $$PWD/TriangleBVH.cpp \
+    $$PWD/IsoLines.cpp \
+    $$PWD/TilePyramid.cpp \
+    $$PWD/VirtualTexture.cpp \
+    $$PWD/AmbientOcclusion.cpp \
+    $$PWD/BatchAnalysis.cpp
+
+QT *= xml opengl widgets gui concurrent
+
+# CONFIG += qt opengl warn_on thread rtti console embed_manifest_exe
+CONFIG += qt opengl warn_on thread rtti console c++11
+
+# parallel mesh kernels
+QMAKE_CXXFLAGS += -fopenmp
+QMAKE_LFLAGS   += -fopenmp
+
+# sparse Cholesky of the geodesic solver; CONFIG += cholmod for SuiteSparse
+INCLUDEPATH *= /usr/include/eigen3
+cholmod {
+    DEFINES += TCVIEWER_CHOLMOD
+    LIBS    += -lcholmod
+}
+
+INCLUDEPATH *= /usr/include /usr/local/include
+LIBS *= -L/usr/lib/QGLViewer -lQGLViewer /usr/local/lib/OpenMesh/libOpenMeshCored.so /usr/local/lib/OpenMesh/libOpenMeshToolsd.so
@@ -3,6 +3,7 @@
 //== INCLUDES =================================================================
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 // --------------------
 #include <QMenu>
 #include <QMouseEvent>
@@ -11,13 +12,24 @@
 #include <QImage>
 #include <QFileInfo>
 #include <QKeyEvent>
+#include <QTimerEvent>
+#include <QGuiApplication>
+#include <QScreen>
 // --------------------
 #include <OpenMesh/Core/Utils/vector_cast.hh>
 #include <OpenMesh/Tools/Utils/Timer.hh>
 
 #include "TCViewerT.h"
+#include "VertexQuantization.h"
 #include <math.h>
 
+#ifndef GL_HALF_FLOAT
+#define GL_HALF_FLOAT 0x140B
+#endif
+
+/// attribute locations of quantized_vertex_shader
+enum { QPosition = 0, QNormal = 1, QColor = 2, QTexCoord = 3 };
+
 using namespace qglviewer;
 using namespace std;
 using namespace OpenMesh;
@@ -106,6 +118,7 @@ void TCViewerT<M>::keyPressEvent(QKeyEvent *e)
 
         std::cout << "Scene Radius: " << sceneRadius() << std::endl;
         std::cout << "Scene Center: " << sceneCenter() << std::endl;
+        std::cout << "Redraws skipped (nothing changed): " << skipped_frames_ << std::endl;
     }
 
     else if ((e->key() == Qt::Key_C) && (modifiers == Qt::ShiftModifier)) {
@@ -119,7 +132,7 @@ void TCViewerT<M>::keyPressEvent(QKeyEvent *e)
             glEnable( GL_CULL_FACE );
             std::cout << "Back face culling: enabled" << std::endl;
         }
-        updateGL();
+        request_redraw();
     }
     else if ((e->key() == Qt::Key_F) && (modifiers == Qt::ControlModifier)) {
         if ( glIsEnabled( GL_FOG ) )
@@ -132,7 +145,7 @@ void TCViewerT<M>::keyPressEvent(QKeyEvent *e)
             glEnable( GL_FOG );
             std::cout << "Fog: enabled" << std::endl;
         }
-        updateGL();
+        request_redraw();
     }
     else {
     }
@@ -162,3 +175,779 @@ void TCViewerT<M>::postDraw()
     QGLViewer::postDraw();
     setDefaultMaterial();
 }
+
+//-----------------------------------------------------------------------------
+template <typename M>
+void TCViewerT<M>::request_redraw(bool _changed)
+{
+    if ( _changed )
+        ++scene_version_;
+    redraw_pending_ = true;
+    if ( redraw_timer_.isActive() )
+        return;
+
+    /// next refresh slot after the last frame
+    qreal hz = QGuiApplication::primaryScreen() ? QGuiApplication::primaryScreen()->refreshRate() : 60.0;
+    const qint64 interval_ns = static_cast<qint64>(1e9/std::max<qreal>(hz, 1.0));
+    const qint64 wait_ns     = last_frame_ns_ + interval_ns - frame_clock_.nsecsElapsed();
+    redraw_timer_.start(static_cast<int>(std::max<qint64>(0, wait_ns/1000000)), this);
+}
+
+template <typename M>
+void TCViewerT<M>::frame_state(FrameState& _state)
+{
+    camera()->getModelViewMatrix(_state.modelview);
+    camera()->getProjectionMatrix(_state.projection);
+    _state.width       = width();
+    _state.height      = height();
+    _state.mode        = draw_mode_;
+    _state.version     = scene_version_;
+    _state.interacting = interacting_;
+}
+
+template <typename M>
+bool TCViewerT<M>::same_camera(const FrameState& _a, const FrameState& _b)
+{
+    return std::equal(_a.modelview,  _a.modelview+16,  _b.modelview) &&
+           std::equal(_a.projection, _a.projection+16, _b.projection) &&
+           _a.width == _b.width && _a.height == _b.height;
+}
+
+template <typename M>
+void TCViewerT<M>::paintGL()
+{
+    /// camera changes between frames mean the user is navigating
+    FrameState state;
+    frame_state(state);
+    if ( last_frame_.version != ~0u && !same_camera(state, last_frame_) )
+    {
+        interacting_ = true;
+        idle_timer_.start(250, this);
+    }
+    state.interacting = interacting_;
+
+    QGLViewer::paintGL();
+
+    last_frame_    = state;
+    last_frame_ns_ = frame_clock_.nsecsElapsed();
+}
+
+template <typename M>
+void TCViewerT<M>::timerEvent(QTimerEvent* _e)
+{
+    if ( _e->timerId() == redraw_timer_.timerId() )
+    {
+        redraw_timer_.stop();
+        if ( !redraw_pending_ )
+            return;
+        redraw_pending_ = false;
+
+        FrameState state;
+        frame_state(state);
+        if ( same_camera(state, last_frame_) && state.mode == last_frame_.mode &&
+             state.version == last_frame_.version && state.interacting == last_frame_.interacting )
+            ++skipped_frames_;
+        else
+            updateGL();
+    }
+    else if ( _e->timerId() == idle_timer_.timerId() )
+    {
+        /// settled: one full quality frame
+        idle_timer_.stop();
+        interacting_ = false;
+        request_redraw(false);
+    }
+    else
+        QGLViewer::timerEvent(_e);
+}
+
+//-----------------------------------------------------------------------------
+template <typename M>
+void TCViewerT<M>::upload_mesh()
+{
+    makeCurrent();
+    buffers_.clear();
+
+    const size_t nv = mesh_.n_vertices();
+    triangles_.clear();
+    build_vertex_split();
+
+    if ( quantized_ && !init_decoder() )
+    {
+        std::cerr << "Quantized vertices need GLSL 1.20, using floats" << std::endl;
+        quantized_ = false;
+    }
+
+    /// the decoder reads every attribute at the mesh vertex index
+    encoded_ = quantized_ && split_.empty();
+    if ( quantized_ && !encoded_ )
+        std::cerr << "Quantized vertices cannot hold split per-corner attributes, using floats" << std::endl;
+    layout_  = SeparateArrays;
+    if ( encoded_ )
+    {
+        /// sized here, filled by flush_encoded() from the mesh arrays
+        set_quantization_box();
+        buffers_.upload(MeshBuffers::Position, 0, 4*sizeof(unsigned short), nv);
+        buffers_.mark_dirty(MeshBuffers::Position, 0, nv);
+        if ( mesh_.has_vertex_normals() )
+        {
+            buffers_.upload(MeshBuffers::Normal, 0, 2*sizeof(short), nv);
+            buffers_.mark_dirty(MeshBuffers::Normal, 0, nv);
+        }
+        if ( mesh_.has_vertex_texcoords2D() )
+        {
+            buffers_.upload(MeshBuffers::TexCoord, 0, 2*sizeof(unsigned short), nv);
+            buffers_.mark_dirty(MeshBuffers::TexCoord, 0, nv);
+        }
+        flush_encoded(MeshBuffers::Position);
+        flush_encoded(MeshBuffers::Normal);
+        flush_encoded(MeshBuffers::TexCoord);
+    }
+    else
+    {
+        const bool colors    = mesh_.has_vertex_colors() || !split_colors_.empty();
+        const bool texcoords = mesh_.has_vertex_texcoords2D() || !split_texcoords_.empty();
+        layout_ = interleaved_ ? choose_vertex_layout(mesh_.has_vertex_normals(), colors, texcoords)
+                               : SeparateArrays;
+        switch (layout_)
+        {
+        case LayoutP:   upload_interleaved<LayoutP>();   break;
+        case LayoutPN:  upload_interleaved<LayoutPN>();  break;
+        case LayoutPNC: upload_interleaved<LayoutPNC>(); break;
+        case LayoutPNT: upload_interleaved<LayoutPNT>(); break;
+        default:
+            buffers_.upload(MeshBuffers::Position, mesh_.points(), sizeof(typename Mesh::Point), nv);
+
+            if ( mesh_.has_vertex_normals() )
+                buffers_.upload(MeshBuffers::Normal, mesh_.vertex_normals(), sizeof(typename Mesh::Normal), nv);
+
+            if ( !split_texcoords_.empty() )
+                buffers_.upload(MeshBuffers::TexCoord, &split_texcoords_[0], sizeof(typename Mesh::TexCoord2D),
+                                split_texcoords_.size());
+            else if ( mesh_.has_vertex_texcoords2D() )
+                buffers_.upload(MeshBuffers::TexCoord, mesh_.texcoords2D(), sizeof(typename Mesh::TexCoord2D), nv);
+            break;
+        }
+    }
+
+    if ( !buffers_.has(MeshBuffers::Color) )
+    {
+        if ( !split_colors_.empty() )
+            buffers_.upload(MeshBuffers::Color, &split_colors_[0], sizeof(typename Mesh::Color), split_colors_.size());
+        else if ( mesh_.has_vertex_colors() )
+            buffers_.upload(MeshBuffers::Color, mesh_.vertex_colors(), sizeof(typename Mesh::Color), nv);
+    }
+
+    /// triangle index list, into the render vertices if split
+    std::vector<unsigned int> indices;
+    if ( split_.empty() )
+        triangle_indices(mesh_, indices);
+    const std::vector<unsigned int>& triangles = split_.empty() ? indices : split_.indices();
+
+    if ( !triangles.empty() )
+        buffers_.upload(MeshBuffers::Index, &triangles[0], sizeof(unsigned int), triangles.size());
+}
+
+template <typename M>
+size_t TCViewerT<M>::n_mesh_vertices() const
+{
+    return split_.empty() ? buffers_.n_elements(MeshBuffers::Position) : split_.n_vertices();
+}
+
+template <typename M>
+void TCViewerT<M>::build_vertex_split()
+{
+    split_.clear();
+    std::vector<typename Mesh::Color>().swap(split_colors_);
+    std::vector<typename Mesh::TexCoord2D>().swap(split_texcoords_);
+    buffers_.set_vertex_split(0);
+
+    const bool face_colors  = mesh_.has_face_colors();
+    const bool halfedge_uvs = mesh_.has_halfedge_texcoords2D();
+    const size_t nf = mesh_.n_faces();
+    if ( (!face_colors && !halfedge_uvs) || !nf )
+        return;
+
+    OpenMesh::Utils::Timer t;
+    t.start();
+
+    /// attributes of the corners 3f+k; face halfedges run as the face
+    /// vertices of triangle_indices(), each pointing to its vertex
+    const bool colors    = face_colors  || mesh_.has_vertex_colors();
+    const bool texcoords = halfedge_uvs || mesh_.has_vertex_texcoords2D();
+    std::vector<typename Mesh::Color>      corner_colors(colors ? 3*nf : 0);
+    std::vector<typename Mesh::TexCoord2D> corner_texcoords(texcoords ? 3*nf : 0);
+
+    const int n = static_cast<int>(nf);
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; ++i)
+    {
+        const typename Mesh::FaceHandle fh(i);
+        typename Mesh::ConstFaceHalfedgeIter fh_it = mesh_.cfh_iter(fh);
+        for (size_t c = 3*static_cast<size_t>(i); c < 3*static_cast<size_t>(i)+3 && fh_it.is_valid(); ++c, ++fh_it)
+        {
+            const typename Mesh::VertexHandle vh = mesh_.to_vertex_handle(*fh_it);
+            if ( colors )
+                corner_colors[c] = face_colors ? mesh_.color(fh) : mesh_.color(vh);
+            if ( texcoords )
+                corner_texcoords[c] = halfedge_uvs ? mesh_.texcoord2D(*fh_it) : mesh_.texcoord2D(vh);
+        }
+    }
+
+    std::vector<unsigned int> indices;
+    triangle_indices(mesh_, indices);
+    split_.build(&indices[0], nf, mesh_.n_vertices(),
+                 colors ? &corner_colors[0][0] : 0, texcoords ? &corner_texcoords[0][0] : 0);
+
+    const size_t nr = split_.n_render_vertices();
+    if ( colors )
+    {
+        split_colors_.resize(nr);
+        split_.gather_corners(&corner_colors[0], sizeof(typename Mesh::Color), &split_colors_[0]);
+    }
+    if ( texcoords )
+    {
+        split_texcoords_.resize(nr);
+        split_.gather_corners(&corner_texcoords[0], sizeof(typename Mesh::TexCoord2D), &split_texcoords_[0]);
+    }
+    buffers_.set_vertex_split(&split_);
+
+    t.stop();
+    std::clog << "Split " << split_.n_vertices() << " vertices into " << nr << " render vertices for "
+              << (face_colors ? "face colors" : "") << (face_colors && halfedge_uvs ? " and " : "")
+              << (halfedge_uvs ? "halfedge texcoords" : "") << " (ratio " << split_.ratio()
+              << ", " << 3*nf << " corners) [" << t.as_string() << "]" << std::endl;
+}
+
+template <typename M>
+void TCViewerT<M>::refresh_geometry(bool _recompute_normals)
+{
+    const size_t nv = mesh_.n_vertices();
+
+    if ( _recompute_normals )
+        update_normals(mesh_, true, true, normal_weights_);
+
+    if ( fp_normal_base_.is_valid() )
+        face_centroids(mesh_, fp_normal_base_);
+
+    bounding_box(mesh_, bb_min_, bb_max_);
+
+    buffers_.mark_dirty(MeshBuffers::Position, 0, nv);
+    if ( mesh_.has_vertex_normals() )
+        buffers_.mark_dirty(MeshBuffers::Normal, 0, nv);
+
+    update_derived(std::vector<unsigned int>(), std::vector<unsigned int>());
+}
+
+template <typename M>
+void TCViewerT<M>::release_mesh(bool _keep_topology)
+{
+    triangles_.clear();
+    if ( _keep_topology )
+        triangle_indices(mesh_, triangles_);
+    std::vector<unsigned int>(triangles_).swap(triangles_);
+
+    /// the split stays, the buffers gather scalar fields through it
+    std::vector<typename Mesh::Color>().swap(split_colors_);
+    std::vector<typename Mesh::TexCoord2D>().swap(split_texcoords_);
+
+    /// clear() swaps all arrays and property vectors empty
+    mesh_.clear();
+}
+
+template <typename M>
+void TCViewerT<M>::flush_buffers()
+{
+    /// split colors and texcoords change with the next upload only
+    if ( !split_.empty() )
+    {
+        buffers_.clear_dirty(MeshBuffers::Color);
+        buffers_.clear_dirty(MeshBuffers::TexCoord);
+    }
+
+    if ( encoded_ )
+    {
+        flush_encoded(MeshBuffers::Position);
+        flush_encoded(MeshBuffers::Normal);
+        flush_encoded(MeshBuffers::TexCoord);
+    }
+    else
+    {
+        switch (layout_)
+        {
+        case LayoutP:   flush_interleaved<LayoutP>();   break;
+        case LayoutPN:  flush_interleaved<LayoutPN>();  break;
+        case LayoutPNC: flush_interleaved<LayoutPNC>(); break;
+        case LayoutPNT: flush_interleaved<LayoutPNT>(); break;
+        default:
+            buffers_.flush(MeshBuffers::Position, mesh_.points());
+            if ( mesh_.has_vertex_normals() )
+                buffers_.flush(MeshBuffers::Normal, mesh_.vertex_normals());
+            if ( mesh_.has_vertex_texcoords2D() && split_.empty() )
+                buffers_.flush(MeshBuffers::TexCoord, mesh_.texcoords2D());
+            break;
+        }
+    }
+    if ( mesh_.has_vertex_colors() && split_.empty() )
+        buffers_.flush(MeshBuffers::Color, mesh_.vertex_colors());
+}
+
+//-----------------------------------------------------------------------------
+template <typename M>
+void TCViewerT<M>::set_quantized(bool _on)
+{
+    if ( _on == quantized_ )
+        return;
+    quantized_ = _on;
+
+    /// a released (view-only) mesh cannot be encoded again
+    if ( !buffers_.n_elements(MeshBuffers::Position) )
+        return;
+    if ( !mesh_.n_vertices() )
+    {
+        std::cerr << "Vertex layout changes apply to the next mesh in view-only mode" << std::endl;
+        return;
+    }
+
+    upload_mesh();
+    request_redraw();
+}
+
+template <typename M>
+size_t TCViewerT<M>::vertex_bytes() const
+{
+    const size_t nv = buffers_.n_elements(MeshBuffers::Position);
+    if ( !nv )
+        return 0;
+    return ( buffers_.bytes(MeshBuffers::Position) + buffers_.bytes(MeshBuffers::Normal) +
+             buffers_.bytes(MeshBuffers::Color)    + buffers_.bytes(MeshBuffers::TexCoord) +
+             buffers_.bytes(MeshBuffers::Vertices) ) / nv;
+}
+
+template <typename M>
+void TCViewerT<M>::set_interleaved(bool _on)
+{
+    if ( _on == interleaved_ )
+        return;
+    interleaved_ = _on;
+
+    if ( !buffers_.n_elements(MeshBuffers::Position) )
+        return;
+    if ( !mesh_.n_vertices() )
+    {
+        std::cerr << "Vertex layout changes apply to the next mesh in view-only mode" << std::endl;
+        return;
+    }
+
+    upload_mesh();
+    request_redraw();
+}
+
+//-----------------------------------------------------------------------------
+template <typename M>
+VertexArrays TCViewerT<M>::vertex_arrays() const
+{
+    VertexArrays arrays;
+    if ( !mesh_.n_vertices() )
+        return arrays;
+    arrays.points = &mesh_.points()[0][0];
+    if ( mesh_.has_vertex_normals() )
+        arrays.normals = &mesh_.vertex_normals()[0][0];
+    if ( !split_.empty() )
+    {
+        arrays.source = &split_.source()[0];
+        if ( !split_colors_.empty() )
+            arrays.colors = &split_colors_[0][0];
+        if ( !split_texcoords_.empty() )
+            arrays.texcoords = &split_texcoords_[0][0];
+        return arrays;
+    }
+    if ( mesh_.has_vertex_colors() )
+        arrays.colors = &mesh_.vertex_colors()[0][0];
+    if ( mesh_.has_vertex_texcoords2D() )
+        arrays.texcoords = &mesh_.texcoords2D()[0][0];
+    return arrays;
+}
+
+template <typename M>
+template <int Layout>
+void TCViewerT<M>::upload_interleaved()
+{
+    typedef InterleavedVertex<Layout> Vertex;
+
+    const size_t nv = split_.empty() ? mesh_.n_vertices() : split_.n_render_vertices();
+    std::vector<Vertex> vertices(nv);
+    if ( nv )
+        pack_vertices<Layout>(vertex_arrays(), 0, nv, &vertices[0]);
+    buffers_.upload(MeshBuffers::Vertices, nv ? &vertices[0] : 0, sizeof(Vertex), nv);
+
+    /// the single attributes stay addressable, e.g. positions alone for
+    /// wireframes and scalar fields
+    buffers_.alias(MeshBuffers::Position, MeshBuffers::Vertices, 0);
+    if ( Vertex::has_normal )
+        buffers_.alias(MeshBuffers::Normal, MeshBuffers::Vertices, Vertex::normal_offset);
+    if ( Vertex::has_color )
+        buffers_.alias(MeshBuffers::Color, MeshBuffers::Vertices, Vertex::color_offset);
+    if ( Vertex::has_texcoord )
+        buffers_.alias(MeshBuffers::TexCoord, MeshBuffers::Vertices, Vertex::texcoord_offset);
+}
+
+template <typename M>
+template <int Layout>
+void TCViewerT<M>::flush_interleaved()
+{
+    typedef InterleavedVertex<Layout> Vertex;
+
+    /// edits mark the attributes they touch; every vertex of any of them
+    /// is repacked whole
+    const MeshBuffers::Attribute attributes[4] =
+        { MeshBuffers::Position, MeshBuffers::Normal, MeshBuffers::Color, MeshBuffers::TexCoord };
+    DirtyRanges dirty;
+    for (int a = 0; a < 4; ++a)
+    {
+        const std::vector<DirtyRanges::Range>& ranges = buffers_.dirty_ranges(attributes[a]);
+        for (size_t i = 0; i < ranges.size(); ++i)
+            dirty.add(ranges[i].first, ranges[i].second);
+        buffers_.clear_dirty(attributes[a]);
+    }
+    if ( dirty.empty() )
+        return;
+
+    /// render vertices, none to pack from once the mesh is released
+    const size_t nr = split_.empty() ? mesh_.n_vertices() : split_.n_render_vertices();
+    const size_t nv = mesh_.n_vertices() ? std::min(buffers_.n_elements(MeshBuffers::Vertices), nr) : 0;
+    if ( 2*dirty.n_elements() > nv )
+    {
+        /// mostly dirty: one contiguous write is cheaper than many small ones
+        dirty.clear();
+        dirty.add(0, nv);
+    }
+
+    const VertexArrays arrays = vertex_arrays();
+    const std::vector<DirtyRanges::Range>& ranges = dirty.ranges();
+    std::vector<Vertex> staging;
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        const size_t first = ranges[i].first;
+        if ( first >= nv )
+            break;
+        const size_t n = std::min(ranges[i].second, nv) - first;
+        staging.resize(n);
+        pack_vertices<Layout>(arrays, first, n, &staging[0]);
+        buffers_.write(MeshBuffers::Vertices, first, n, &staging[0]);
+    }
+}
+
+template <typename M>
+bool TCViewerT<M>::init_decoder()
+{
+    if ( decoder_ )
+        return decoder_->isLinked();
+
+    decoder_ = new QGLShaderProgram(context(), this);
+    if ( !QGLShaderProgram::hasOpenGLShaderPrograms(context()) ||
+         !decoder_->addShaderFromSourceCode(QGLShader::Vertex, quantized_vertex_shader) )
+        return false;
+
+    decoder_->bindAttributeLocation("q_position", QPosition);
+    decoder_->bindAttributeLocation("q_normal",   QNormal);
+    decoder_->bindAttributeLocation("q_color",    QColor);
+    decoder_->bindAttributeLocation("q_texcoord", QTexCoord);
+    if ( !decoder_->link() )
+    {
+        std::cerr << decoder_->log().toLocal8Bit().constData() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+template <typename M>
+void TCViewerT<M>::set_quantization_box()
+{
+    typename Mesh::Point margin = (bb_max_-bb_min_)*(1.0f/64.0f);
+    qbox_min_  = bb_min_ - margin;
+    qbox_size_ = (bb_max_+margin) - qbox_min_;
+    for (int k = 0; k < 3; ++k)
+        if ( qbox_size_[k] <= 0.0f )
+            qbox_size_[k] = 1.0f;
+}
+
+template <typename M>
+void TCViewerT<M>::flush_encoded(MeshBuffers::Attribute _attr)
+{
+    if ( buffers_.dirty_ranges(_attr).empty() )
+        return;
+
+    /// edits that leave the quantization box move the box, and every vertex
+    if ( _attr == MeshBuffers::Position )
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            if ( bb_min_[k] < qbox_min_[k] || bb_max_[k] > qbox_min_[k]+qbox_size_[k] )
+            {
+                set_quantization_box();
+                buffers_.mark_dirty(_attr, 0, buffers_.n_elements(_attr));
+                break;
+            }
+        }
+    }
+
+    const float qmin[3]  = { qbox_min_[0],  qbox_min_[1],  qbox_min_[2] };
+    const float qsize[3] = { qbox_size_[0], qbox_size_[1], qbox_size_[2] };
+
+    const std::vector<DirtyRanges::Range>& ranges = buffers_.dirty_ranges(_attr);
+    std::vector<unsigned short> staging;
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        const size_t first = ranges[i].first;
+        const size_t n     = std::min(ranges[i].second, mesh_.n_vertices()) - first;
+        if ( first >= mesh_.n_vertices() )
+            break;
+
+        switch (_attr)
+        {
+        case MeshBuffers::Position:
+            staging.resize(4*n);
+            quantize_positions(&mesh_.points()[first][0], n, qmin, qsize, &staging[0]);
+            break;
+        case MeshBuffers::Normal:
+            staging.resize(2*n);
+            encode_octahedral(&mesh_.vertex_normals()[first][0], n,
+                              reinterpret_cast<short*>(&staging[0]));
+            break;
+        case MeshBuffers::TexCoord:
+            staging.resize(2*n);
+            encode_half(&mesh_.texcoords2D()[first][0], 2*n, &staging[0]);
+            break;
+        default:
+            return;
+        }
+        buffers_.write(_attr, first, n, &staging[0]);
+    }
+    buffers_.clear_dirty(_attr);
+}
+
+template <typename M>
+bool TCViewerT<M>::enable_decoder_attribute(MeshBuffers::Attribute _attr)
+{
+    /// the position always comes first and sets up the program
+    if ( _attr == MeshBuffers::Position )
+    {
+        decoder_->bind();
+        decoder_->setUniformValue("box_min",  qbox_min_[0],  qbox_min_[1],  qbox_min_[2]);
+        decoder_->setUniformValue("box_size", qbox_size_[0], qbox_size_[1], qbox_size_[2]);
+        decoder_->setUniformValue("lighting",     static_cast<GLint>(glIsEnabled(GL_LIGHTING)));
+        decoder_->setUniformValue("has_color",    static_cast<GLint>(0));
+        decoder_->setUniformValue("has_texcoord", static_cast<GLint>(0));
+        decoder_->setUniformValue("color_material", static_cast<GLint>(glIsEnabled(GL_COLOR_MATERIAL)));
+        GLfloat on[3];
+        for (int i = 0; i < 3; ++i)
+            on[i] = glIsEnabled(GL_LIGHT0+i) ? 1.0f : 0.0f;
+        decoder_->setUniformValueArray("light_on", on, 3, 1);
+    }
+
+    if ( !buffers_.bind(_attr) )
+        return false;
+
+    switch (_attr)
+    {
+    case MeshBuffers::Position:
+        decoder_->setAttributeBuffer(QPosition, GL_UNSIGNED_SHORT, 0, 4);
+        decoder_->enableAttributeArray(QPosition);
+        break;
+    case MeshBuffers::Normal:
+        decoder_->setAttributeBuffer(QNormal, GL_SHORT, 0, 2);
+        decoder_->enableAttributeArray(QNormal);
+        break;
+    case MeshBuffers::Color:
+    case MeshBuffers::Occlusion:
+        decoder_->setAttributeBuffer(QColor, GL_UNSIGNED_BYTE, 0, 3);
+        decoder_->enableAttributeArray(QColor);
+        decoder_->setUniformValue("has_color", static_cast<GLint>(1));
+        break;
+    case MeshBuffers::TexCoord:
+        decoder_->setAttributeBuffer(QTexCoord, GL_HALF_FLOAT, 0, 2);
+        decoder_->enableAttributeArray(QTexCoord);
+        decoder_->setUniformValue("has_texcoord", static_cast<GLint>(1));
+        break;
+    case MeshBuffers::Scalar:
+        /// scalars stay float, as the first texture coordinate
+        decoder_->setAttributeBuffer(QTexCoord, GL_FLOAT, 0, 1);
+        decoder_->enableAttributeArray(QTexCoord);
+        decoder_->setUniformValue("has_texcoord", static_cast<GLint>(1));
+        break;
+    default:
+        break;
+    }
+
+    buffers_.release(_attr);
+    return true;
+}
+
+template <typename M>
+bool TCViewerT<M>::enable_array(MeshBuffers::Attribute _attr)
+{
+    if ( encoded_ )
+        return enable_decoder_attribute(_attr);
+
+    if ( !buffers_.bind(_attr) )
+        return false;
+
+    /// attributes of an interleaved layout sit at their offset in the vertex
+    const GLsizei stride = static_cast<GLsizei>(buffers_.stride(_attr));
+    const GLvoid* offset = reinterpret_cast<const GLvoid*>(buffers_.offset(_attr));
+
+    switch (_attr)
+    {
+    case MeshBuffers::Position:
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(3, GL_FLOAT, stride, offset);
+        break;
+    case MeshBuffers::Normal:
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glNormalPointer(GL_FLOAT, stride, offset);
+        break;
+    case MeshBuffers::Color:
+    case MeshBuffers::Occlusion:
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(3, GL_UNSIGNED_BYTE, stride, offset);
+        break;
+    case MeshBuffers::TexCoord:
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, stride, offset);
+        break;
+    case MeshBuffers::Scalar:
+        /// scalars index a 1D colormap texture
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(1, GL_FLOAT, 0, 0);
+        break;
+    default:
+        break;
+    }
+
+    buffers_.release(_attr);
+    return true;
+}
+
+template <typename M>
+void TCViewerT<M>::enable_vertices()
+{
+    if ( !encoded_ )
+    {
+        switch (layout_)
+        {
+        case LayoutP:   enable_interleaved<LayoutP>();   return;
+        case LayoutPN:  enable_interleaved<LayoutPN>();  return;
+        case LayoutPNC: enable_interleaved<LayoutPNC>(); return;
+        case LayoutPNT: enable_interleaved<LayoutPNT>(); return;
+        default:        break;
+        }
+    }
+    enable_array(MeshBuffers::Position);
+    enable_array(MeshBuffers::Normal);
+}
+
+template <typename M>
+template <int Layout>
+void TCViewerT<M>::enable_interleaved()
+{
+    typedef InterleavedVertex<Layout> Vertex;
+
+    if ( !buffers_.bind(MeshBuffers::Vertices) )
+        return;
+
+    /// the conditions are constants of the layout and compile away
+    const GLsizei stride = sizeof(Vertex);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, stride, 0);
+    if ( Vertex::has_normal )
+    {
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glNormalPointer(GL_FLOAT, stride, reinterpret_cast<const GLvoid*>(Vertex::normal_offset));
+    }
+    if ( Vertex::has_color )
+    {
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(3, GL_UNSIGNED_BYTE, stride, reinterpret_cast<const GLvoid*>(Vertex::color_offset));
+    }
+    if ( Vertex::has_texcoord )
+    {
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, stride, reinterpret_cast<const GLvoid*>(Vertex::texcoord_offset));
+    }
+    buffers_.release(MeshBuffers::Vertices);
+}
+
+template <typename M>
+void TCViewerT<M>::disable_arrays()
+{
+    if ( encoded_ )
+    {
+        decoder_->disableAttributeArray(QPosition);
+        decoder_->disableAttributeArray(QNormal);
+        decoder_->disableAttributeArray(QColor);
+        decoder_->disableAttributeArray(QTexCoord);
+        decoder_->release();
+        return;
+    }
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+}
+
+template <typename M>
+void TCViewerT<M>::draw_triangles()
+{
+    if ( !buffers_.bind(MeshBuffers::Index) )
+        return;
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(buffers_.n_elements(MeshBuffers::Index)),
+                   GL_UNSIGNED_INT, 0);
+    buffers_.release(MeshBuffers::Index);
+}
+
+//-----------------------------------------------------------------------------
+template <typename M>
+void TCViewerT<M>::update_vertices(const std::vector<typename M::VertexHandle>& _vhs)
+{
+    if ( _vhs.empty() || !mesh_.n_vertices() )
+        return;
+
+    /// modified vertices and the faces around them
+    std::vector<unsigned int> vertices, faces, normals;
+    vertices.reserve(_vhs.size());
+    faces.reserve(6*_vhs.size());
+    for (size_t i = 0; i < _vhs.size(); ++i)
+    {
+        vertices.push_back(_vhs[i].idx());
+        bb_min_.minimize(mesh_.point(_vhs[i]));
+        bb_max_.maximize(mesh_.point(_vhs[i]));
+        for (typename Mesh::VertexFaceIter vf_it=mesh_.vf_iter(_vhs[i]); vf_it.is_valid(); ++vf_it)
+            faces.push_back(vf_it->idx());
+    }
+    std::sort(vertices.begin(), vertices.end());
+    vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+    std::sort(faces.begin(), faces.end());
+    faces.erase(std::unique(faces.begin(), faces.end()), faces.end());
+
+    /// every vertex of an affected face needs its normal re-averaged
+    normals.reserve(3*faces.size());
+    for (size_t i = 0; i < faces.size(); ++i)
+        for (typename Mesh::FaceVertexIter fv_it=mesh_.fv_iter(typename Mesh::FaceHandle(faces[i])); fv_it.is_valid(); ++fv_it)
+            normals.push_back(fv_it->idx());
+    std::sort(normals.begin(), normals.end());
+    normals.erase(std::unique(normals.begin(), normals.end()), normals.end());
+
+    /// the kernel of full updates, so edited vertices shade as after one
+    update_normals(mesh_, faces, normals, normal_weights_);
+    if ( fp_normal_base_.is_valid() )
+        face_centroids(mesh_, fp_normal_base_, &faces);
+    if ( mesh_.has_vertex_normals() )
+        buffers_.mark_dirty(MeshBuffers::Normal, normals);
+    buffers_.mark_dirty(MeshBuffers::Position, vertices);
+
+    update_derived(vertices, faces);
+
+    request_redraw();
+}
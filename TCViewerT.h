@@ -3,12 +3,21 @@
 
 //== INCLUDES =================================================================
 #include <string>
+#include <vector>
 #include <OpenMesh/Core/IO/MeshIO.hh>
 #include <OpenMesh/Core/IO/Options.hh>
 #include <OpenMesh/Core/Mesh/Attributes.hh>
 #include <OpenMesh/Tools/Utils/Timer.hh>
 
 #include <QGLViewer/qglviewer.h>
+#include <QGLShaderProgram>
+#include <QBasicTimer>
+#include <QElapsedTimer>
+
+#include "MeshBuffers.h"
+#include "MeshKernelsT.h"
+#include "VertexLayouts.h"
+#include "VertexSplit.h"
 
 //== FORWARDS =================================================================
 class QImage;
@@ -30,8 +39,22 @@ public:
           use_color_(true),
           show_vnormals_(false),
           show_fnormals_(false),
+          quantized_(false),
+          encoded_(false),
+          interleaved_(true),
+          layout_(SeparateArrays),
+          normal_weights_(AreaWeights),
+          decoder_(0),
+          last_frame_ns_(0),
+          redraw_pending_(false),
+          interacting_(false),
+          scene_version_(0),
+          skipped_frames_(0),
           draw_mode_("Smooth")
-          {}
+          {
+              frame_clock_.start();
+              last_frame_.version = ~0u;
+          }
     
     ///destructor
     ~TCViewerT() {}
@@ -42,14 +65,110 @@ public:
     Mesh& mesh() { return mesh_; }
     const Mesh& mesh() const { return mesh_; }
 
+    /// Propagate position changes of _vhs: recompute normals and face normal
+    /// base points of the affected faces/vertices only, and schedule the
+    /// touched sub-ranges of the GPU buffers for re-upload.
+    virtual void update_vertices(const std::vector<typename Mesh::VertexHandle>& _vhs);
+
+    /// Store positions, normals and texcoords in the compact layout of
+    /// VertexQuantization.h and decode them in a vertex shader. Re-uploads
+    /// the current mesh; falls back to floats without GLSL support.
+    void set_quantized(bool _on);
+    bool quantized() const { return quantized_; }
+    /// GPU bytes per vertex of the vertex attribute buffers
+    size_t vertex_bytes() const;
+
+    /// Keep the float attributes of a mesh interleaved in one buffer, in
+    /// the layout of VertexLayouts.h matching its attribute set (default),
+    /// or in one buffer each. Re-uploads the current mesh.
+    void set_interleaved(bool _on);
+    bool interleaved() const { return interleaved_; }
+    VertexLayout vertex_layout() const { return layout_; }
+
+    /// Ask for a repaint. Requests are merged into at most one frame per
+    /// display refresh. Unless _changed, the frame is dropped when camera,
+    /// viewport and draw mode equal those of the last drawn frame.
+    void request_redraw(bool _changed=true);
+    /// the camera moved within the last quarter second; renderers may take
+    /// cheaper paths, a full frame follows once it settles
+    bool interacting() const { return interacting_; }
+    /// scheduled frames dropped because nothing visible changed
+    size_t skipped_frames() const { return skipped_frames_; }
+
 protected :
     void setDefaultMaterial();
     void setDefaultLight();
+
+    /// upload points, normals, colors, texcoords and triangle indices
+    void upload_mesh();
+    /// mesh vertices behind the buffers, also after release_mesh(); the
+    /// buffers hold more if vertices were split for per-corner attributes
+    size_t n_mesh_vertices() const;
+    /// recompute everything derived from positions after all of them changed,
+    /// keeps file provided normals unless _recompute_normals is set
+    void refresh_geometry(bool _recompute_normals);
+    /// Drop the CPU-side mesh once everything is on the GPU. With
+    /// _keep_topology the triangle list stays in triangles_ for picking
+    /// and analysis; all other attributes are gone until the next load.
+    void release_mesh(bool _keep_topology);
+    /// re-upload the dirty buffer ranges left by update_vertices()
+    void flush_buffers();
+    /// bind a buffer to its fixed-function client array, or to the decoder's
+    /// attribute when quantized
+    bool enable_array(MeshBuffers::Attribute _attr);
+    /// Enable position and normal and whatever else the vertex layout
+    /// interleaves with them, binding the layout's buffer once
+    void enable_vertices();
+    void disable_arrays();
+    /// draw all triangles through the index buffer
+    void draw_triangles();
+
+private:
+    /// Split the vertices of a mesh with face colors or halfedge texcoords
+    /// where its corners differ and gather the render vertices' colors and
+    /// texcoords; clears the split for meshes without either
+    void build_vertex_split();
+    /// compile the quantized layout's vertex shader once, false if unsupported
+    bool init_decoder();
+    /// encode and re-upload the dirty ranges of a quantized attribute
+    void flush_encoded(MeshBuffers::Attribute _attr);
+    /// bounding box plus a margin, so that small edits keep the encoding
+    void set_quantization_box();
+    bool enable_decoder_attribute(MeshBuffers::Attribute _attr);
+
+    /// per-layout kernels: pack and upload all vertices, repack the dirty
+    /// ranges of the interleaved attributes, set the client arrays
+    template <int Layout> void upload_interleaved();
+    template <int Layout> void flush_interleaved();
+    template <int Layout> void enable_interleaved();
+    VertexArrays vertex_arrays() const;
+
+    /// what a frame depends on besides the buffers' contents
+    struct FrameState
+    {
+        GLdouble    modelview[16], projection[16];
+        int         width, height;
+        std::string mode;
+        unsigned    version;
+        bool        interacting;
+    };
+    void frame_state(FrameState& _state);
+    static bool same_camera(const FrameState& _a, const FrameState& _b);
+
+protected:
+
+    /// hook for values derived from positions, called by update_vertices()
+    /// with sorted lists of the modified vertices and affected faces, and by
+    /// refresh_geometry() with two empty lists for the whole mesh
+    virtual void update_derived(const std::vector<unsigned int>& /*_vertices*/,
+                                const std::vector<unsigned int>& /*_faces*/) {}
     
     virtual void draw();
     virtual void init();
     virtual QString helpString() const;
     virtual void postDraw();
+    virtual void paintGL();
+    virtual void timerEvent(QTimerEvent* _e);
 
     virtual void keyPressEvent(QKeyEvent *e);
 
@@ -64,6 +183,34 @@ protected:
     bool                   show_fnormals_;
     float                  normal_scale_;
     OpenMesh::FPropHandleT< typename Mesh::Point > fp_normal_base_;
+    typename Mesh::Point   bb_min_, bb_max_;
+
+    MeshBuffers            buffers_;
+    std::vector<unsigned int> triangles_; // topology kept by release_mesh()
+
+    /// render vertices of per-corner attributes, empty without; their colors
+    /// and texcoords are fixed until the next upload_mesh()
+    VertexSplit            split_;
+    std::vector<typename Mesh::Color>      split_colors_;
+    std::vector<typename Mesh::TexCoord2D> split_texcoords_;
+
+    bool                   quantized_;  // requested layout
+    bool                   encoded_;    // layout of the current buffers
+    bool                   interleaved_; // requested
+    VertexLayout           layout_;     // of the current float buffers
+    NormalWeights          normal_weights_; // of every computed vertex normal
+    QGLShaderProgram*      decoder_;
+    typename Mesh::Point   qbox_min_, qbox_size_;
+
+    /// frame scheduling
+    QBasicTimer            redraw_timer_, idle_timer_;
+    QElapsedTimer          frame_clock_;
+    qint64                 last_frame_ns_;
+    bool                   redraw_pending_;
+    bool                   interacting_;
+    unsigned               scene_version_;
+    size_t                 skipped_frames_;
+    FrameState             last_frame_;
 
     std::string            draw_mode_;
 };
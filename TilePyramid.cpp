@@ -0,0 +1,359 @@
+//== INCLUDES =================================================================
+#include <algorithm>
+#include <cstring>
+
+#include <QBuffer>
+#include <QImageReader>
+#include <QImageIOHandler>
+#include <QElapsedTimer>
+
+#include "TilePyramid.h"
+
+//== IMPLEMENTATION ==========================================================
+namespace {
+
+/// start of a pack file, in host byte order: packs are local caches
+struct PackHeader
+{
+    char   magic[4];
+    qint32 version;
+    qint32 width, height, tile, levels;
+};
+
+const char   pack_magic[4] = { 'T', 'C', 'V', 'T' };
+const qint32 pack_version  = 1;
+
+/// source rows per strip, in tiles
+const int strip_tiles = 8;
+
+/// 2x2 box filter of the pixels at columns _c0 and _c1 of rows _a and _b
+inline QRgb average(const QRgb* _a, const QRgb* _b, int _c0, int _c1)
+{
+    const QRgb p[4] = { _a[_c0], _a[_c1], _b[_c0], _b[_c1] };
+    int r = 2, g = 2, b = 2, a = 2;
+    for (int i = 0; i < 4; ++i)
+    {
+        r += qRed(p[i]);
+        g += qGreen(p[i]);
+        b += qBlue(p[i]);
+        a += qAlpha(p[i]);
+    }
+    return qRgba(r/4, g/4, b/4, a/4);
+}
+
+}
+
+/// Receives the rows of level 0 top down, reduces every pair of rows into
+/// the next level as soon as both are there, and cuts a level's rows into
+/// tiles once a band of tile_size()+1 rows is complete. Only one band per
+/// level is held at any time.
+class PyramidWriter
+{
+public:
+    PyramidWriter(TilePyramid& _pyramid, QFile& _out, const char* _format, int _quality)
+        : pyramid_(_pyramid), out_(_out), format_(_format), quality_(_quality), ok_(true),
+          levels_(_pyramid.levels())
+    {
+        int w = pyramid_.width(), h = pyramid_.height();
+        for (size_t l = 0; l < levels_.size(); ++l)
+        {
+            levels_[l].width  = w;
+            levels_[l].height = h;
+            w = (w+1)/2;
+            h = (h+1)/2;
+        }
+    }
+
+    bool ok() const { return ok_; }
+
+    /// append one row of _level
+    void push_row(int _level, const QRgb* _row)
+    {
+        Level& level = levels_[_level];
+        const int w = level.width;
+        level.rows.insert(level.rows.end(), _row, _row+w);
+
+        if ( _level+1 < static_cast<int>(levels_.size()) )
+        {
+            if ( !level.has_odd )
+            {
+                level.odd.assign(_row, _row+w);
+                level.has_odd = true;
+            }
+            else
+            {
+                reduce(_level, &level.odd[0], _row);
+                level.has_odd = false;
+            }
+        }
+
+        /// a band is complete with its extra row, or at the bottom
+        const int tile = pyramid_.tile_size();
+        for (;;)
+        {
+            const int needed = std::min(tile+1, level.height-level.first);
+            if ( needed <= 0 || static_cast<int>(level.rows.size()/w) < needed )
+                break;
+            write_band(_level, needed);
+            level.rows.erase(level.rows.begin(),
+                             level.rows.begin() + std::min(level.rows.size(), static_cast<size_t>(tile)*w));
+            level.first += tile;
+        }
+    }
+
+    /// a level with an odd row count reduces its last row with itself
+    void finish()
+    {
+        for (size_t l = 0; l+1 < levels_.size(); ++l)
+            if ( levels_[l].has_odd )
+            {
+                levels_[l].has_odd = false;
+                reduce(static_cast<int>(l), &levels_[l].odd[0], &levels_[l].odd[0]);
+            }
+    }
+
+private:
+    struct Level
+    {
+        Level() : width(0), height(0), first(0), has_odd(false) {}
+
+        int               width, height;
+        int               first;    ///< level row of rows[0]
+        std::vector<QRgb> rows;
+        std::vector<QRgb> odd;      ///< first row of a pair
+        bool              has_odd;
+    };
+
+    void reduce(int _level, const QRgb* _a, const QRgb* _b)
+    {
+        const int w = levels_[_level].width;
+        std::vector<QRgb> row(levels_[_level+1].width);
+        for (int j = 0; j < static_cast<int>(row.size()); ++j)
+            row[j] = average(_a, _b, 2*j, std::min(2*j+1, w-1));
+        push_row(_level+1, &row[0]);
+    }
+
+    void write_band(int _level, int _rows)
+    {
+        const Level& level = levels_[_level];
+        const int tile = pyramid_.tile_size(), w = level.width;
+        const int n = (w + tile-1)/tile, y = level.first/tile;
+
+        /// encoding dominates, tiles of a band are independent
+        std::vector<QByteArray> blobs(n);
+#pragma omp parallel for schedule(dynamic)
+        for (int x = 0; x < n; ++x)
+        {
+            QImage image(tile+1, tile+1, QImage::Format_ARGB32);
+            for (int j = 0; j <= tile; ++j)
+            {
+                const QRgb* src = &level.rows[std::min(j, _rows-1)*w];
+                QRgb* dst = reinterpret_cast<QRgb*>(image.scanLine(j));
+                for (int i = 0; i <= tile; ++i)
+                    dst[i] = src[std::min(x*tile+i, w-1)];
+            }
+            QBuffer buffer(&blobs[x]);
+            buffer.open(QIODevice::WriteOnly);
+            image.save(&buffer, format_, quality_);
+        }
+
+        for (int x = 0; x < n && ok_; ++x)
+        {
+            const size_t i = pyramid_.index(_level, x, y);
+            pyramid_.offsets_[i] = out_.pos();
+            pyramid_.sizes_[i]   = blobs[x].size();
+            ok_ = !blobs[x].isEmpty() && out_.write(blobs[x]) == blobs[x].size();
+        }
+    }
+
+    TilePyramid&       pyramid_;
+    QFile&             out_;
+    const char*        format_;
+    int                quality_;
+    bool               ok_;
+    std::vector<Level> levels_;
+};
+
+//-----------------------------------------------------------------------------
+TilePyramid::TilePyramid()
+    : width_(0), height_(0), tile_(0), levels_(0)
+{
+}
+
+TilePyramid::~TilePyramid()
+{
+    close();
+}
+
+void TilePyramid::set_layout(int _width, int _height, int _tile, int _levels)
+{
+    width_  = _width;
+    height_ = _height;
+    tile_   = _tile;
+    levels_ = _levels;
+
+    level_offsets_.resize(_levels);
+    size_t n = 0;
+    for (int l = 0; l < _levels; ++l)
+    {
+        level_offsets_[l] = n;
+        n += static_cast<size_t>(tiles(l))*tiles(l);
+    }
+    offsets_.assign(n, 0);
+    sizes_.assign(n, 0);
+}
+
+bool TilePyramid::build(const QString& _image, const QString& _pack, int _tile, std::ostream* _log)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QImageReader probe(_image);
+    const QSize size = probe.size();
+    if ( !size.isValid() || _tile < 16 )
+        return false;
+
+    int levels = 1;
+    while ( (static_cast<qint64>(_tile) << (levels-1)) < std::max(size.width(), size.height()) )
+        ++levels;
+
+    TilePyramid pyramid;
+    pyramid.set_layout(size.width(), size.height(), _tile, levels);
+
+    /// written aside and renamed at the end, a pack is either complete or absent
+    QFile out(_pack + ".part");
+    if ( !out.open(QIODevice::WriteOnly | QIODevice::Truncate) )
+        return false;
+
+    PackHeader header;
+    std::memcpy(header.magic, pack_magic, 4);
+    header.version = pack_version;
+    header.width   = size.width();
+    header.height  = size.height();
+    header.tile    = _tile;
+    header.levels  = levels;
+    const qint64 table = sizeof(header);
+    const qint64 table_bytes = pyramid.n_tiles()*(sizeof(quint64)+sizeof(quint32));
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(QByteArray(static_cast<int>(table_bytes), '\0'));
+
+    /// photographs as JPEG, anything with alpha lossless
+    const bool alpha = QImage(1, 1, probe.imageFormat()).hasAlphaChannel();
+    PyramidWriter writer(pyramid, out, alpha ? "PNG" : "JPG", alpha ? -1 : 92);
+
+    /// strips where the reader can clip, otherwise the image in one piece
+    const bool strips = probe.supportsOption(QImageIOHandler::ClipRect);
+    const int  strip  = strips ? strip_tiles*_tile : size.height();
+    for (int y0 = 0; y0 < size.height() && writer.ok(); y0 += strip)
+    {
+        const int rows = std::min(strip, size.height()-y0);
+        QImageReader reader(_image);
+        if ( strips )
+            reader.setClipRect(QRect(0, y0, size.width(), rows));
+        QImage part = reader.read();
+        if ( part.isNull() || part.width() != size.width() || part.height() != rows )
+        {
+            if ( _log )
+                *_log << "Tiling: cannot read rows " << y0 << "-" << y0+rows << ": "
+                      << reader.errorString().toLocal8Bit().constData() << std::endl;
+            out.close();
+            out.remove();
+            return false;
+        }
+        part = part.convertToFormat(QImage::Format_ARGB32);
+
+        for (int r = 0; r < rows && writer.ok(); ++r)
+            writer.push_row(0, reinterpret_cast<const QRgb*>(part.constScanLine(r)));
+        if ( _log && strips )
+            *_log << "\rTiling: " << 100*(y0+rows)/size.height() << "%" << std::flush;
+    }
+    writer.finish();
+    if ( _log && strips )
+        *_log << std::endl;
+
+    bool ok = writer.ok() && out.seek(table);
+    if ( ok )
+    {
+        const qint64 n = pyramid.n_tiles();
+        ok = out.write(reinterpret_cast<const char*>(&pyramid.offsets_[0]), n*sizeof(quint64)) == n*qint64(sizeof(quint64)) &&
+             out.write(reinterpret_cast<const char*>(&pyramid.sizes_[0]),   n*sizeof(quint32)) == n*qint64(sizeof(quint32));
+    }
+    const qint64 bytes = out.size();
+    out.close();
+    QFile::remove(_pack);
+    if ( !ok || !out.rename(_pack) )
+    {
+        out.remove();
+        return false;
+    }
+
+    if ( _log )
+        *_log << "Tiled " << size.width() << "x" << size.height() << " into " << levels
+              << " levels of " << _tile << "^2 tiles, " << bytes/(1024.0*1024.0) << " MB ["
+              << 1e-3*timer.elapsed() << " s]" << std::endl;
+    return true;
+}
+
+bool TilePyramid::open(const QString& _pack)
+{
+    close();
+    file_.setFileName(_pack);
+    if ( !file_.open(QIODevice::ReadOnly) )
+        return false;
+
+    PackHeader header;
+    if ( file_.read(reinterpret_cast<char*>(&header), sizeof(header)) != qint64(sizeof(header)) ||
+         std::memcmp(header.magic, pack_magic, 4) != 0 || header.version != pack_version ||
+         header.width <= 0 || header.height <= 0 || header.tile < 16 ||
+         header.levels < 1 || header.levels > 16 )
+    {
+        close();
+        return false;
+    }
+
+    set_layout(header.width, header.height, header.tile, header.levels);
+    const qint64 n = n_tiles();
+    if ( file_.read(reinterpret_cast<char*>(&offsets_[0]), n*sizeof(quint64)) != n*qint64(sizeof(quint64)) ||
+         file_.read(reinterpret_cast<char*>(&sizes_[0]),   n*sizeof(quint32)) != n*qint64(sizeof(quint32)) )
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TilePyramid::close()
+{
+    if ( file_.isOpen() )
+        file_.close();
+    width_ = height_ = tile_ = levels_ = 0;
+    std::vector<size_t>().swap(level_offsets_);
+    std::vector<quint64>().swap(offsets_);
+    std::vector<quint32>().swap(sizes_);
+}
+
+bool TilePyramid::read_tile(size_t _index, QImage& _image) const
+{
+    if ( _index >= n_tiles() || !has_tile(_index) )
+        return false;
+
+    QByteArray data;
+    {
+        QMutexLocker lock(&mutex_);
+        if ( !file_.seek(offsets_[_index]) )
+            return false;
+        data = file_.read(sizes_[_index]);
+    }
+    if ( data.size() != static_cast<int>(sizes_[_index]) || !_image.loadFromData(data) )
+        return false;
+
+    if ( _image.format() != QImage::Format_ARGB32 && _image.format() != QImage::Format_RGB32 )
+        _image = _image.convertToFormat(QImage::Format_ARGB32);
+    return _image.width() == tile_+1 && _image.height() == tile_+1;
+}
+
+size_t TilePyramid::bytes() const
+{
+    return level_offsets_.capacity()*sizeof(size_t) + offsets_.capacity()*sizeof(quint64) +
+           sizes_.capacity()*sizeof(quint32);
+}
@@ -0,0 +1,76 @@
+#ifndef TILEPYRAMID_H
+#define TILEPYRAMID_H
+
+//== INCLUDES =================================================================
+#include <vector>
+#include <ostream>
+#include <cstddef>
+
+#include <QString>
+#include <QImage>
+#include <QFile>
+#include <QMutex>
+
+//== CLASS DEFINITION =========================================================
+/// Mipmap pyramid of an image, cut into square tiles and stored in a single
+/// pack file. Level 0 is the image; level l+1 halves level l (rounding up)
+/// until the whole image fits into one tile. Every level is laid out on a
+/// grid of tiles(l)^2 tiles, a power of two, so the tiles of level l+1 are
+/// exactly the parents of 2x2 tiles of level l; grid cells outside the image
+/// hold no tile.
+/// Tiles are stored with one extra row and column taken from their right and
+/// bottom neighbors (edge pixels repeated at the image border), so bilinear
+/// lookups never need a neighboring tile.
+class TilePyramid
+{
+public:
+    TilePyramid();
+    ~TilePyramid();
+
+    /// Write the pyramid of image file _image to _pack. Source rows are read
+    /// in strips where the image format supports clip rects, so images past
+    /// QImage's 2 GB limit can be tiled; tiles of a strip are encoded in
+    /// parallel.
+    static bool build(const QString& _image, const QString& _pack, int _tile=128,
+                      std::ostream* _log=0);
+
+    bool open(const QString& _pack);
+    void close();
+    bool is_open() const { return file_.isOpen(); }
+
+    int width() const     { return width_; }
+    int height() const    { return height_; }
+    int tile_size() const { return tile_; }
+    int levels() const    { return levels_; }
+    /// grid cells per side of _level
+    int tiles(int _level) const { return 1 << (levels_-1-_level); }
+
+    /// tiles of all levels, level by level, rows top down
+    size_t n_tiles() const { return sizes_.size(); }
+    size_t index(int _level, int _x, int _y) const
+    { return level_offsets_[_level] + static_cast<size_t>(_y)*tiles(_level) + _x; }
+    bool has_tile(size_t _index) const { return sizes_[_index] != 0; }
+
+    /// Decode tile _index into a (tile_size()+1)^2 ARGB32 image, rows top
+    /// down. Safe to call from several threads: only the file read is
+    /// serialized, decoding runs concurrently.
+    bool read_tile(size_t _index, QImage& _image) const;
+
+    /// bytes of the tile table
+    size_t bytes() const;
+
+private:
+    friend class PyramidWriter;
+    void set_layout(int _width, int _height, int _tile, int _levels);
+
+    int                  width_, height_, tile_, levels_;
+    std::vector<size_t>  level_offsets_;  ///< first tile index of each level
+    std::vector<quint64> offsets_;        ///< file offset of each tile
+    std::vector<quint32> sizes_;          ///< encoded bytes, 0: no tile
+    mutable QFile        file_;
+    mutable QMutex       mutex_;
+};
+
+//=============================================================================
+#endif // TILEPYRAMID_H defined
+//=============================================================================
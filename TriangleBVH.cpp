@@ -0,0 +1,495 @@
+//== INCLUDES =================================================================
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <utility>
+
+#include "TriangleBVH.h"
+
+//== IMPLEMENTATION ==========================================================
+/// triangles per leaf
+static const unsigned int leaf_size = 4;
+
+/// Nodes of a subtree over _n triangles: one, or one plus both halves
+/// (floor and ceil of _n/2). Both halves of any count are again floor and
+/// ceil of a single value, so carrying (f(m), f(m+1)) down needs one step
+/// per level.
+static std::pair<unsigned int, unsigned int> node_counts(unsigned int _m)
+{
+    if ( _m+1 <= leaf_size )
+        return std::make_pair(1u, 1u);
+    if ( _m <= leaf_size )
+    {
+        /// f(_m) is a leaf, f(_m+1) splits into leaves
+        return std::make_pair(1u, 3u);
+    }
+    const std::pair<unsigned int, unsigned int> h = node_counts(_m/2);
+    if ( _m % 2 == 0 )   // _m: (m/2, m/2), _m+1: (m/2, m/2+1)
+        return std::make_pair(1 + 2*h.first, 1 + h.first + h.second);
+    else                 // _m: (m/2, m/2+1), _m+1: (m/2+1, m/2+1)
+        return std::make_pair(1 + h.first + h.second, 1 + 2*h.second);
+}
+
+static unsigned int node_count(unsigned int _n)
+{
+    return node_counts(_n).first;
+}
+
+static inline float dot(const float* _a, const float* _b)
+{
+    return _a[0]*_b[0] + _a[1]*_b[1] + _a[2]*_b[2];
+}
+
+/// squared distance from _p to the box [_lo,_hi], 0 inside
+static inline float box_distance2(const float* _p, const float* _lo, const float* _hi)
+{
+    float d2 = 0.0f;
+    for (int k = 0; k < 3; ++k)
+    {
+        const float d = std::max(std::max(_lo[k]-_p[k], _p[k]-_hi[k]), 0.0f);
+        d2 += d*d;
+    }
+    return d2;
+}
+
+/// closest point to _p on triangle _t (9 floats), by Voronoi regions
+/// (Ericson, Real-Time Collision Detection, 5.1.5)
+static void closest_on_triangle(const float* _p, const float* _t, float* _q)
+{
+    const float* a = _t;
+    const float* b = _t+3;
+    const float* c = _t+6;
+    float ab[3], ac[3], ap[3];
+    for (int k = 0; k < 3; ++k)
+    {
+        ab[k] = b[k]-a[k];
+        ac[k] = c[k]-a[k];
+        ap[k] = _p[k]-a[k];
+    }
+
+    const float d1 = dot(ab, ap), d2 = dot(ac, ap);
+    if ( d1 <= 0.0f && d2 <= 0.0f )
+    {
+        _q[0] = a[0]; _q[1] = a[1]; _q[2] = a[2];
+        return;
+    }
+
+    float bp[3] = { _p[0]-b[0], _p[1]-b[1], _p[2]-b[2] };
+    const float d3 = dot(ab, bp), d4 = dot(ac, bp);
+    if ( d3 >= 0.0f && d4 <= d3 )
+    {
+        _q[0] = b[0]; _q[1] = b[1]; _q[2] = b[2];
+        return;
+    }
+
+    const float vc = d1*d4 - d3*d2;
+    if ( vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f )
+    {
+        const float v = d1/(d1-d3);
+        for (int k = 0; k < 3; ++k)
+            _q[k] = a[k] + v*ab[k];
+        return;
+    }
+
+    float cp[3] = { _p[0]-c[0], _p[1]-c[1], _p[2]-c[2] };
+    const float d5 = dot(ab, cp), d6 = dot(ac, cp);
+    if ( d6 >= 0.0f && d5 <= d6 )
+    {
+        _q[0] = c[0]; _q[1] = c[1]; _q[2] = c[2];
+        return;
+    }
+
+    const float vb = d5*d2 - d1*d6;
+    if ( vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f )
+    {
+        const float w = d2/(d2-d6);
+        for (int k = 0; k < 3; ++k)
+            _q[k] = a[k] + w*ac[k];
+        return;
+    }
+
+    const float va = d3*d6 - d5*d4;
+    if ( va <= 0.0f && (d4-d3) >= 0.0f && (d5-d6) >= 0.0f )
+    {
+        const float w = (d4-d3)/((d4-d3) + (d5-d6));
+        for (int k = 0; k < 3; ++k)
+            _q[k] = b[k] + w*(c[k]-b[k]);
+        return;
+    }
+
+    const float denom = va + vb + vc;
+    const float v = denom != 0.0f ? vb/denom : 0.0f;
+    const float w = denom != 0.0f ? vc/denom : 0.0f;
+    for (int k = 0; k < 3; ++k)
+        _q[k] = a[k] + ab[k]*v + ac[k]*w;
+}
+
+/// whether the ray enters the box [_lo,_hi] before _max_t, slab test with
+/// the inverse direction
+static inline bool ray_box(const float* _o, const float* _inv, const float* _lo, const float* _hi,
+                           float _max_t)
+{
+    const float ax = (_lo[0]-_o[0])*_inv[0], bx = (_hi[0]-_o[0])*_inv[0];
+    const float ay = (_lo[1]-_o[1])*_inv[1], by = (_hi[1]-_o[1])*_inv[1];
+    const float az = (_lo[2]-_o[2])*_inv[2], bz = (_hi[2]-_o[2])*_inv[2];
+    const float t0 = std::max(std::max(std::min(ax, bx), std::min(ay, by)),
+                              std::max(std::min(az, bz), 0.0f));
+    const float t1 = std::min(std::min(std::max(ax, bx), std::max(ay, by)),
+                              std::min(std::max(az, bz), _max_t));
+    return t0 <= t1;
+}
+
+/// ray against triangle _t (9 floats), both sides, hit for 0 < t < _max_t
+/// (Moeller and Trumbore, Fast, Minimum Storage Ray/Triangle Intersection)
+static inline bool ray_triangle(const float* _o, const float* _d, const float* _t, float _max_t)
+{
+    float e1[3], e2[3], s[3];
+    for (int k = 0; k < 3; ++k)
+    {
+        e1[k] = _t[3+k]-_t[k];
+        e2[k] = _t[6+k]-_t[k];
+        s[k]  = _o[k]-_t[k];
+    }
+    const float p[3] = { _d[1]*e2[2]-_d[2]*e2[1], _d[2]*e2[0]-_d[0]*e2[2], _d[0]*e2[1]-_d[1]*e2[0] };
+    const float det = dot(e1, p);
+    if ( det == 0.0f )
+        return false;
+    const float inv = 1.0f/det;
+
+    const float u = dot(s, p)*inv;
+    if ( u < 0.0f || u > 1.0f )
+        return false;
+    const float q[3] = { s[1]*e1[2]-s[2]*e1[1], s[2]*e1[0]-s[0]*e1[2], s[0]*e1[1]-s[1]*e1[0] };
+    const float v = dot(_d, q)*inv;
+    if ( v < 0.0f || u+v > 1.0f )
+        return false;
+    const float t = dot(e2, q)*inv;
+    return t > 0.0f && t < _max_t;
+}
+
+//-----------------------------------------------------------------------------
+TriangleBVH::TriangleBVH()
+{
+}
+
+void TriangleBVH::clear()
+{
+    std::vector<Node>().swap(nodes_);
+    std::vector<unsigned int>().swap(order_);
+    std::vector<float>().swap(corners_);
+}
+
+size_t TriangleBVH::bytes() const
+{
+    return nodes_.capacity()*sizeof(Node) + order_.capacity()*sizeof(unsigned int) +
+           corners_.capacity()*sizeof(float);
+}
+
+void TriangleBVH::build(const float* _points, size_t /*_n_vertices*/,
+                        const unsigned int* _triangles, size_t _n_faces)
+{
+    clear();
+    if ( !_n_faces )
+        return;
+
+    const long nf = static_cast<long>(_n_faces);
+    order_.resize(_n_faces);
+    corners_.resize(9*_n_faces);
+
+    /// corners in input order first, centroids for the splits
+    std::vector<float> centroids(3*_n_faces);
+#pragma omp parallel for schedule(static)
+    for (long f = 0; f < nf; ++f)
+    {
+        order_[f] = static_cast<unsigned int>(f);
+        for (int i = 0; i < 3; ++i)
+            for (int k = 0; k < 3; ++k)
+                corners_[9*f+3*i+k] = _points[3*_triangles[3*f+i]+k];
+        for (int k = 0; k < 3; ++k)
+            centroids[3*f+k] = (corners_[9*f+k] + corners_[9*f+3+k] + corners_[9*f+6+k])/3.0f;
+    }
+
+    nodes_.resize(node_count(static_cast<unsigned int>(_n_faces)));
+
+#pragma omp parallel
+#pragma omp single nowait
+    build_range(0, 0, static_cast<unsigned int>(_n_faces), &centroids[0], 0);
+
+    /// corners in leaf order, so a leaf reads one contiguous block
+    std::vector<float> sorted(9*_n_faces);
+#pragma omp parallel for schedule(static)
+    for (long f = 0; f < nf; ++f)
+        std::copy(&corners_[9*order_[f]], &corners_[9*order_[f]]+9, &sorted[9*f]);
+    corners_.swap(sorted);
+}
+
+void TriangleBVH::build_range(unsigned int _node, unsigned int _begin, unsigned int _end,
+                              const float* _centroids, int _depth)
+{
+    Node& node = nodes_[_node];
+    const unsigned int n = _end-_begin;
+
+    if ( n <= leaf_size )
+    {
+        node.first = _begin;
+        node.count = n;
+        for (int k = 0; k < 3; ++k)
+        {
+            node.lo[k] =  std::numeric_limits<float>::max();
+            node.hi[k] = -std::numeric_limits<float>::max();
+        }
+        for (unsigned int i = _begin; i < _end; ++i)
+            for (int c = 0; c < 3; ++c)
+                for (int k = 0; k < 3; ++k)
+                {
+                    const float x = corners_[9*order_[i]+3*c+k];
+                    node.lo[k] = std::min(node.lo[k], x);
+                    node.hi[k] = std::max(node.hi[k], x);
+                }
+        return;
+    }
+
+    /// split at the median centroid along the longest centroid extent
+    float lo[3], hi[3];
+    for (int k = 0; k < 3; ++k)
+    {
+        lo[k] =  std::numeric_limits<float>::max();
+        hi[k] = -std::numeric_limits<float>::max();
+    }
+    for (unsigned int i = _begin; i < _end; ++i)
+        for (int k = 0; k < 3; ++k)
+        {
+            const float x = _centroids[3*order_[i]+k];
+            lo[k] = std::min(lo[k], x);
+            hi[k] = std::max(hi[k], x);
+        }
+    int axis = 0;
+    for (int k = 1; k < 3; ++k)
+        if ( hi[k]-lo[k] > hi[axis]-lo[axis] )
+            axis = k;
+
+    const unsigned int mid = _begin + n/2;
+    std::nth_element(order_.begin()+_begin, order_.begin()+mid, order_.begin()+_end,
+                     [&](unsigned int _a, unsigned int _b)
+                     { return _centroids[3*_a+axis] < _centroids[3*_b+axis]; });
+
+    const unsigned int left = _node+1, right = left + node_count(mid-_begin);
+    node.first = right;
+    node.count = 0;
+
+    /// the top levels fan out into tasks, deeper ones run inline; arguments
+    /// are plain values since tasks copy whatever they capture
+#pragma omp task if(_depth < 10 && n > 4096)
+    build_range(left, _begin, mid, _centroids, _depth+1);
+#pragma omp task if(_depth < 10 && n > 4096)
+    build_range(right, mid, _end, _centroids, _depth+1);
+#pragma omp taskwait
+
+    for (int k = 0; k < 3; ++k)
+    {
+        node.lo[k] = std::min(nodes_[left].lo[k], nodes_[right].lo[k]);
+        node.hi[k] = std::max(nodes_[left].hi[k], nodes_[right].hi[k]);
+    }
+}
+
+float TriangleBVH::closest_point(const float _p[3], float* _closest, unsigned int* _face,
+                                 float _max_dist2) const
+{
+    float best = _max_dist2 >= 0.0f ? _max_dist2 : std::numeric_limits<float>::max();
+    if ( nodes_.empty() )
+        return best;
+
+    float q[3];
+
+    /// nodes with the squared distance to their box
+    std::pair<unsigned int, float> stack[64];
+    int top = 0;
+    stack[top++] = std::make_pair(0u, box_distance2(_p, nodes_[0].lo, nodes_[0].hi));
+
+    while ( top )
+    {
+        const std::pair<unsigned int, float> entry = stack[--top];
+        if ( entry.second >= best )
+            continue;
+        const Node& node = nodes_[entry.first];
+
+        if ( node.count )
+        {
+            for (unsigned int i = node.first; i < node.first+node.count; ++i)
+            {
+                closest_on_triangle(_p, &corners_[9*i], q);
+                const float d[3] = { q[0]-_p[0], q[1]-_p[1], q[2]-_p[2] };
+                const float d2 = dot(d, d);
+                if ( d2 < best )
+                {
+                    best = d2;
+                    if ( _closest )
+                    {
+                        _closest[0] = q[0]; _closest[1] = q[1]; _closest[2] = q[2];
+                    }
+                    if ( _face )
+                        *_face = order_[i];
+                }
+            }
+            continue;
+        }
+
+        /// nearer child on top of the stack
+        const unsigned int left = entry.first+1, right = node.first;
+        const float dl = box_distance2(_p, nodes_[left].lo, nodes_[left].hi);
+        const float dr = box_distance2(_p, nodes_[right].lo, nodes_[right].hi);
+        if ( dl < dr )
+        {
+            if ( dr < best ) stack[top++] = std::make_pair(right, dr);
+            if ( dl < best ) stack[top++] = std::make_pair(left, dl);
+        }
+        else
+        {
+            if ( dl < best ) stack[top++] = std::make_pair(left, dl);
+            if ( dr < best ) stack[top++] = std::make_pair(right, dr);
+        }
+    }
+    return best;
+}
+
+float TriangleBVH::distances(const float* _points, size_t _n, float* _out) const
+{
+    const long n = static_cast<long>(_n);
+    float largest = 0.0f;
+
+    /// chunks of consecutive points keep the traversals coherent
+#pragma omp parallel for schedule(dynamic, 1024) reduction(max:largest)
+    for (long i = 0; i < n; ++i)
+    {
+        _out[i] = std::sqrt(closest_point(&_points[3*i]));
+        largest = std::max(largest, _out[i]);
+    }
+    return largest;
+}
+
+bool TriangleBVH::occluded(const float _origin[3], const float _dir[3], float _max_t) const
+{
+    if ( nodes_.empty() )
+        return false;
+
+    const float inv[3] = { 1.0f/_dir[0], 1.0f/_dir[1], 1.0f/_dir[2] };
+    unsigned int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+
+    while ( top )
+    {
+        const unsigned int id = stack[--top];
+        const Node& node = nodes_[id];
+        if ( !ray_box(_origin, inv, node.lo, node.hi, _max_t) )
+            continue;
+
+        if ( node.count )
+        {
+            for (unsigned int i = node.first; i < node.first+node.count; ++i)
+                if ( ray_triangle(_origin, _dir, &corners_[9*i], _max_t) )
+                    return true;
+            continue;
+        }
+
+        /// any hit ends the query, so the visiting order matters little
+        stack[top++] = node.first;
+        stack[top++] = id+1;
+    }
+    return false;
+}
+
+/// whether the plane passes through the box [_lo,_hi]
+static inline bool plane_box(const float* _plane, const float* _lo, const float* _hi)
+{
+    float center = _plane[3], radius = 0.0f;
+    for (int k = 0; k < 3; ++k)
+    {
+        center += 0.5f*_plane[k]*(_lo[k]+_hi[k]);
+        radius += 0.5f*std::fabs(_plane[k])*(_hi[k]-_lo[k]);
+    }
+    return std::fabs(center) <= radius;
+}
+
+/// the segment where the plane cuts triangle _t (9 floats) into _segment,
+/// if given; false if the triangle lies on one side
+static inline bool plane_triangle(const float* _plane, const float* _t, float* _segment)
+{
+    float d[3];
+    bool  front[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        d[i]     = dot(_plane, _t+3*i) + _plane[3];
+        front[i] = d[i] >= 0.0f;
+    }
+    if ( front[0] == front[1] && front[1] == front[2] )
+        return false;
+    if ( !_segment )
+        return true;
+
+    for (int i = 0, k = 0; i < 3; ++i)
+    {
+        const int j = (i+1) % 3;
+        if ( front[i] == front[j] )
+            continue;
+        const int b = front[i] ? j : i, f = front[i] ? i : j;
+        const float s = d[b]/(d[b]-d[f]);
+        for (int c = 0; c < 3; ++c)
+            _segment[3*k+c] = _t[3*b+c] + s*(_t[3*f+c]-_t[3*b+c]);
+        ++k;
+    }
+    return true;
+}
+
+void TriangleBVH::slice(const float _plane[4], std::vector<float>& _segments) const
+{
+    _segments.clear();
+    if ( nodes_.empty() )
+        return;
+
+    /// leaves the plane passes through; a plane meets few of them
+    std::vector<unsigned int> leaves;
+    unsigned int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while ( top )
+    {
+        const unsigned int id = stack[--top];
+        const Node& node = nodes_[id];
+        if ( !plane_box(_plane, node.lo, node.hi) )
+            continue;
+        if ( node.count )
+            leaves.push_back(id);
+        else
+        {
+            stack[top++] = node.first;
+            stack[top++] = id+1;
+        }
+    }
+
+    /// count, then fill at the prefix sums
+    const long n = static_cast<long>(leaves.size());
+    std::vector<unsigned int> offsets(n+1, 0);
+#pragma omp parallel for schedule(dynamic, 256)
+    for (long l = 0; l < n; ++l)
+    {
+        const Node& node = nodes_[leaves[l]];
+        unsigned int count = 0;
+        for (unsigned int i = node.first; i < node.first+node.count; ++i)
+            count += plane_triangle(_plane, &corners_[9*i], 0);
+        offsets[l+1] = count;
+    }
+    for (long l = 0; l < n; ++l)
+        offsets[l+1] += offsets[l];
+
+    _segments.resize(6*static_cast<size_t>(offsets[n]));
+#pragma omp parallel for schedule(dynamic, 256)
+    for (long l = 0; l < n; ++l)
+    {
+        const Node& node = nodes_[leaves[l]];
+        float* out = _segments.empty() ? 0 : &_segments[6*static_cast<size_t>(offsets[l])];
+        for (unsigned int i = node.first; i < node.first+node.count; ++i)
+            if ( plane_triangle(_plane, &corners_[9*i], out) )
+                out += 6;
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef TRIANGLEBVH_H
+#define TRIANGLEBVH_H
+
+//== INCLUDES =================================================================
+#include <vector>
+#include <cstddef>
+
+//== CLASS DEFINITION =========================================================
+/// Bounding volume hierarchy over a triangle soup given as flat arrays, for
+/// closest point and ray queries. Built by median splits along the longest axis of
+/// the centroid bounds; since split positions depend on triangle counts
+/// only, every subtree's node range is known up front and the subtrees are
+/// built as parallel tasks. Queries are read-only and may run concurrently.
+class TriangleBVH
+{
+public:
+    TriangleBVH();
+
+    /// _points: 3 floats per vertex, _triangles: 3 indices per face; both
+    /// are copied
+    void build(const float* _points, size_t _n_vertices,
+               const unsigned int* _triangles, size_t _n_faces);
+    void clear();
+
+    bool   empty() const { return nodes_.empty(); }
+    size_t n_faces() const { return order_.size(); }
+    size_t bytes() const;
+
+    /// Squared distance from _p to the closest point of the mesh, written to
+    /// _closest if given, along with its face. Triangles farther than
+    /// sqrt(_max_dist2) are skipped; returns _max_dist2 if none is closer.
+    float closest_point(const float _p[3], float* _closest=0, unsigned int* _face=0,
+                        float _max_dist2=-1.0f) const;
+
+    /// distance of each of the _n points (3 floats each) to the mesh, in
+    /// parallel; returns the largest, i.e. the one-sided Hausdorff distance
+    /// of the point set
+    float distances(const float* _points, size_t _n, float* _out) const;
+
+    /// whether the ray _origin + t*_dir hits any triangle for 0 < t < _max_t;
+    /// stops at the first hit found, in no particular order
+    bool occluded(const float _origin[3], const float _dir[3], float _max_t) const;
+
+    /// Segments where the plane _plane[0..2].x + _plane[3] = 0 cuts the
+    /// mesh, 6 floats each, from the leaves whose box the plane passes
+    /// through only. Corners on the plane count as in front, and each
+    /// crossing is interpolated from the corner behind, so the segments of
+    /// neighboring triangles meet exactly. Leaves are cut in parallel.
+    void slice(const float _plane[4], std::vector<float>& _segments) const;
+
+private:
+    struct Node
+    {
+        float        lo[3], hi[3];
+        unsigned int first;   ///< leaf: first index into order_; inner: right child
+        unsigned int count;   ///< leaf: triangle count; inner: 0, left child is next
+    };
+
+    void build_range(unsigned int _node, unsigned int _begin, unsigned int _end,
+                     const float* _centroids, int _depth);
+
+    std::vector<Node>         nodes_;
+    std::vector<unsigned int> order_;      ///< triangle ids in leaf order
+    std::vector<float>        corners_;    ///< 9 floats per triangle, leaf order
+};
+
+//=============================================================================
+#endif // TRIANGLEBVH_H defined
+//=============================================================================
@@ -0,0 +1,86 @@
+//== INCLUDES =================================================================
+#include <QElapsedTimer>
+
+#include "VertexAnimation.h"
+
+//== IMPLEMENTATION ==========================================================
+VertexAnimation::VertexAnimation()
+    : n_vertices_(0), weights_(AreaWeights), front_(0)
+{
+    reset_stats();
+}
+
+bool VertexAnimation::open(const QString& _file, const unsigned int* _triangles, size_t _n_faces,
+                           size_t _n_vertices, NormalWeights _weights)
+{
+    close();
+    if ( !_n_faces || !frames_.open(_file, 3*_n_vertices) )
+        return false;
+
+    n_vertices_ = _n_vertices;
+    weights_    = _weights;
+    triangles_.assign(_triangles, _triangles + 3*_n_faces);
+    vertex_corners(&triangles_[0], _n_faces, n_vertices_, corners_);
+
+    for (int b = 0; b < 2; ++b)
+    {
+        buffers_[b].index = -1;
+        buffers_[b].points.resize(3*n_vertices_);
+        buffers_[b].vertex_normals.resize(3*n_vertices_);
+        buffers_[b].face_normals.resize(triangles_.size());
+    }
+    cross_.resize(triangles_.size());
+    front_ = 0;
+    reset_stats();
+    return true;
+}
+
+void VertexAnimation::close()
+{
+    frames_.close();
+    n_vertices_ = 0;
+    std::vector<unsigned int>().swap(triangles_);
+    corners_ = VertexCorners();
+    std::vector<float>().swap(cross_);
+    for (int b = 0; b < 2; ++b)
+        buffers_[b] = Frame();
+}
+
+void VertexAnimation::prepare(size_t _i)
+{
+    if ( !is_open() || _i >= n_frames() )
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    Frame& frame = buffers_[1-front_];
+    frames_.read(_i, &frame.points[0]);
+
+    compute_normals(&frame.points[0], &triangles_[0], n_faces(), corners_, weights_, cross_,
+                    &frame.face_normals[0], &frame.vertex_normals[0]);
+
+    frame.index = static_cast<long>(_i);
+    prepare_seconds_ += 1e-9*timer.nsecsElapsed();
+    ++n_prepared_;
+}
+
+void VertexAnimation::reset_stats()
+{
+    frames_.reset_stats();
+    prepare_seconds_ = 0.0;
+    n_prepared_      = 0;
+}
+
+size_t VertexAnimation::bytes() const
+{
+    size_t bytes = (triangles_.capacity() + corners_.offsets.capacity() + corners_.corners.capacity())
+                   *sizeof(unsigned int)
+                 + cross_.capacity()*sizeof(float);
+    for (int b = 0; b < 2; ++b)
+        bytes += (buffers_[b].points.capacity() + buffers_[b].face_normals.capacity() +
+                  buffers_[b].vertex_normals.capacity())*sizeof(float);
+    return bytes;
+}
+
+//=============================================================================
@@ -0,0 +1,84 @@
+#ifndef VERTEXANIMATION_H
+#define VERTEXANIMATION_H
+
+//== INCLUDES =================================================================
+#include <vector>
+#include <cstddef>
+
+#include <QString>
+
+#include "ScalarSequence.h"
+#include "MeshKernelsT.h"
+
+//== CLASS DEFINITION =========================================================
+/// Deforming mesh with fixed triangles: frames of xyz float32 positions of
+/// every vertex, packed back to back in one file and streamed through a
+/// ScalarSequence of 3*n_vertices() floats per frame.
+/// prepare() reads a frame into a back buffer and recomputes its face and
+/// vertex normals with compute_normals(), so it can run on a worker while
+/// the front buffer is shown; swap() exchanges them.
+/// One prepare() at a time, swap() only while none is running.
+class VertexAnimation
+{
+public:
+    VertexAnimation();
+
+    /// map _file as frames of _n_vertices positions of the _n_faces
+    /// triangles, whose indices are copied; vertex normals weighted as _weights
+    bool open(const QString& _file, const unsigned int* _triangles, size_t _n_faces,
+              size_t _n_vertices, NormalWeights _weights=AreaWeights);
+    void close();
+    bool is_open() const { return frames_.is_open(); }
+
+    size_t n_frames() const   { return frames_.n_frames(); }
+    size_t n_vertices() const { return n_vertices_; }
+    size_t n_faces() const    { return triangles_.size()/3; }
+    /// the mapped frames, for their read statistics
+    const ScalarSequence& frames() const { return frames_; }
+
+    /// read frame _i into the back buffer and compute its normals, in parallel
+    void prepare(size_t _i);
+    /// frame in the back buffer, -1 if none
+    long prepared() const { return buffers_[1-front_].index; }
+    /// the back buffer becomes the front buffer
+    void swap() { front_ = 1-front_; }
+
+    /// front buffer: frame, positions, face and vertex normals
+    long         frame() const          { return buffers_[front_].index; }
+    const float* points() const         { return &buffers_[front_].points[0]; }
+    const float* face_normals() const   { return &buffers_[front_].face_normals[0]; }
+    const float* vertex_normals() const { return &buffers_[front_].vertex_normals[0]; }
+
+    /// seconds spent in prepare() and the frames prepared
+    double prepare_seconds() const { return prepare_seconds_; }
+    size_t n_prepared() const      { return n_prepared_; }
+    void   reset_stats();
+
+    size_t bytes() const;
+
+private:
+    struct Frame
+    {
+        Frame() : index(-1) {}
+
+        long               index;
+        std::vector<float> points, face_normals, vertex_normals;
+    };
+
+    ScalarSequence            frames_;
+    size_t                    n_vertices_;
+    std::vector<unsigned int> triangles_;
+    VertexCorners             corners_;
+    NormalWeights             weights_;
+    std::vector<float>        cross_;   ///< per face (p1-p0) x (p2-p0) of the last prepare
+
+    Frame                     buffers_[2];
+    int                       front_;
+
+    double                    prepare_seconds_;
+    size_t                    n_prepared_;
+};
+
+//=============================================================================
+#endif // VERTEXANIMATION_H defined
+//=============================================================================
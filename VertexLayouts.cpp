@@ -0,0 +1,22 @@
+//== INCLUDES =================================================================
+#include "VertexLayouts.h"
+
+//== IMPLEMENTATION ==========================================================
+VertexLayout choose_vertex_layout(bool _normals, bool _colors, bool _texcoords)
+{
+    if ( !_normals )
+        return (_colors || _texcoords) ? SeparateArrays : LayoutP;
+    if ( _colors && _texcoords )
+        return SeparateArrays;
+    if ( _colors )
+        return LayoutPNC;
+    if ( _texcoords )
+        return LayoutPNT;
+    return LayoutPN;
+}
+
+const char* vertex_layout_name(VertexLayout _layout)
+{
+    static const char* names[NVertexLayouts] = { "separate", "p", "pn", "pnc", "pnt" };
+    return _layout < NVertexLayouts ? names[_layout] : "?";
+}
@@ -0,0 +1,139 @@
+#ifndef VERTEXLAYOUTS_H
+#define VERTEXLAYOUTS_H
+
+//== INCLUDES =================================================================
+#include <cstddef>
+
+//== TYPES ====================================================================
+/// Interleaved float vertex formats, one per attribute set of a mesh, so a
+/// draw reads a single stream holding exactly the attributes the mesh has.
+/// Every set gets its own vertex type and packing kernel below; the viewer
+/// picks one when uploading and binds it through the compile-time offsets,
+/// without per-attribute branches. Sets without a layout keep one buffer
+/// per attribute.
+enum VertexLayout
+{
+    SeparateArrays = 0,   ///< one buffer per attribute, also for quantized vertices
+    LayoutP,              ///< position
+    LayoutPN,             ///< position, normal
+    LayoutPNC,            ///< position, normal, RGB color
+    LayoutPNT,            ///< position, normal, 2D texture coordinate
+    NVertexLayouts
+};
+
+/// the layout of a mesh with the given attributes
+VertexLayout choose_vertex_layout(bool _normals, bool _colors, bool _texcoords);
+const char*  vertex_layout_name(VertexLayout _layout);
+
+/// the per-vertex arrays a layout is packed from; only those of its
+/// attributes are read. With split vertices (VertexSplit.h) points and
+/// normals stay per mesh vertex and are read through source, colors and
+/// texcoords are per render vertex.
+struct VertexArrays
+{
+    VertexArrays() : points(0), normals(0), colors(0), texcoords(0), source(0) {}
+
+    const float*         points;      ///< 3 per vertex
+    const float*         normals;     ///< 3 per vertex
+    const unsigned char* colors;      ///< 3 per vertex
+    const float*         texcoords;   ///< 2 per vertex
+    const unsigned int*  source;      ///< mesh vertex of each vertex, 0 if the same
+
+    size_t mesh_vertex(size_t _v) const { return source ? source[_v] : _v; }
+};
+
+template <int Layout> struct InterleavedVertex;
+
+template <> struct InterleavedVertex<LayoutP>
+{
+    enum { has_normal = 0, has_color = 0, has_texcoord = 0,
+           normal_offset = 0, color_offset = 0, texcoord_offset = 0 };
+    float position[3];
+};
+
+template <> struct InterleavedVertex<LayoutPN>
+{
+    enum { has_normal = 1, has_color = 0, has_texcoord = 0,
+           normal_offset = 12, color_offset = 0, texcoord_offset = 0 };
+    float position[3];
+    float normal[3];
+};
+
+/// the color is padded to 4 bytes, 28 bytes per vertex
+template <> struct InterleavedVertex<LayoutPNC>
+{
+    enum { has_normal = 1, has_color = 1, has_texcoord = 0,
+           normal_offset = 12, color_offset = 24, texcoord_offset = 0 };
+    float         position[3];
+    float         normal[3];
+    unsigned char color[4];
+};
+
+template <> struct InterleavedVertex<LayoutPNT>
+{
+    enum { has_normal = 1, has_color = 0, has_texcoord = 1,
+           normal_offset = 12, color_offset = 0, texcoord_offset = 24 };
+    float position[3];
+    float normal[3];
+    float texcoord[2];
+};
+
+static_assert(sizeof(InterleavedVertex<LayoutP>)   == 12, "padded vertex layout");
+static_assert(sizeof(InterleavedVertex<LayoutPN>)  == 24, "padded vertex layout");
+static_assert(sizeof(InterleavedVertex<LayoutPNC>) == 28, "padded vertex layout");
+static_assert(sizeof(InterleavedVertex<LayoutPNT>) == 32, "padded vertex layout");
+static_assert(offsetof(InterleavedVertex<LayoutPNC>, color)    == InterleavedVertex<LayoutPNC>::color_offset, "color offset");
+static_assert(offsetof(InterleavedVertex<LayoutPNT>, texcoord) == InterleavedVertex<LayoutPNT>::texcoord_offset, "texcoord offset");
+
+//== FUNCTIONS ================================================================
+/// straight copies of vertex _v, one overload per layout
+inline void pack_vertex(const VertexArrays& _in, size_t _v, InterleavedVertex<LayoutP>& _out)
+{
+    const float* p = _in.points + 3*_in.mesh_vertex(_v);
+    _out.position[0] = p[0]; _out.position[1] = p[1]; _out.position[2] = p[2];
+}
+
+inline void pack_vertex(const VertexArrays& _in, size_t _v, InterleavedVertex<LayoutPN>& _out)
+{
+    const size_t m = _in.mesh_vertex(_v);
+    const float* p = _in.points + 3*m;
+    const float* n = _in.normals + 3*m;
+    _out.position[0] = p[0]; _out.position[1] = p[1]; _out.position[2] = p[2];
+    _out.normal[0]   = n[0]; _out.normal[1]   = n[1]; _out.normal[2]   = n[2];
+}
+
+inline void pack_vertex(const VertexArrays& _in, size_t _v, InterleavedVertex<LayoutPNC>& _out)
+{
+    const size_t         m = _in.mesh_vertex(_v);
+    const float*         p = _in.points + 3*m;
+    const float*         n = _in.normals + 3*m;
+    const unsigned char* c = _in.colors + 3*_v;
+    _out.position[0] = p[0]; _out.position[1] = p[1]; _out.position[2] = p[2];
+    _out.normal[0]   = n[0]; _out.normal[1]   = n[1]; _out.normal[2]   = n[2];
+    _out.color[0]    = c[0]; _out.color[1]    = c[1]; _out.color[2]    = c[2]; _out.color[3] = 255;
+}
+
+inline void pack_vertex(const VertexArrays& _in, size_t _v, InterleavedVertex<LayoutPNT>& _out)
+{
+    const size_t m = _in.mesh_vertex(_v);
+    const float* p = _in.points + 3*m;
+    const float* n = _in.normals + 3*m;
+    const float* t = _in.texcoords + 2*_v;
+    _out.position[0] = p[0]; _out.position[1] = p[1]; _out.position[2] = p[2];
+    _out.normal[0]   = n[0]; _out.normal[1]   = n[1]; _out.normal[2]   = n[2];
+    _out.texcoord[0] = t[0]; _out.texcoord[1] = t[1];
+}
+
+/// pack vertices [_first,_first+_n) into _out[0.._n), in parallel
+template <int Layout>
+void pack_vertices(const VertexArrays& _in, size_t _first, size_t _n, InterleavedVertex<Layout>* _out)
+{
+    const long n = static_cast<long>(_n);
+#pragma omp parallel for schedule(static) if (n > 65536)
+    for (long i = 0; i < n; ++i)
+        pack_vertex(_in, _first+i, _out[i]);
+}
+
+//=============================================================================
+#endif // VERTEXLAYOUTS_H defined
+//=============================================================================
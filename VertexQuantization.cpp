@@ -0,0 +1,184 @@
+//== INCLUDES =================================================================
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "VertexQuantization.h"
+
+//== IMPLEMENTATION ==========================================================
+static inline int round_clamped(float _v, float _lo, float _hi)
+{
+    return static_cast<int>(std::floor(std::max(_lo, std::min(_hi, _v)) + 0.5f));
+}
+
+void quantize_positions(const float* _points, size_t _n, const float _min[3],
+                        const float _size[3], unsigned short* _out)
+{
+    float scale[3];
+    for (int k = 0; k < 3; ++k)
+        scale[k] = _size[k] > 0.0f ? 65535.0f/_size[k] : 0.0f;
+
+    const long n = static_cast<long>(_n);
+#pragma omp parallel for schedule(static)
+    for (long i = 0; i < n; ++i)
+    {
+        for (int k = 0; k < 3; ++k)
+            _out[4*i+k] = static_cast<unsigned short>(
+                round_clamped((_points[3*i+k]-_min[k])*scale[k], 0.0f, 65535.0f));
+        _out[4*i+3] = 0;
+    }
+}
+
+void encode_octahedral(const float* _normals, size_t _n, short* _out)
+{
+    const long n = static_cast<long>(_n);
+#pragma omp parallel for schedule(static)
+    for (long i = 0; i < n; ++i)
+    {
+        const float* v = _normals + 3*i;
+        float l1 = std::fabs(v[0]) + std::fabs(v[1]) + std::fabs(v[2]);
+        float u = l1 > 0.0f ? v[0]/l1 : 0.0f;
+        float w = l1 > 0.0f ? v[1]/l1 : 0.0f;
+
+        /// fold the lower hemisphere over the diagonals
+        if ( v[2] < 0.0f )
+        {
+            float fu = (1.0f - std::fabs(w)) * (u >= 0.0f ? 1.0f : -1.0f);
+            float fw = (1.0f - std::fabs(u)) * (w >= 0.0f ? 1.0f : -1.0f);
+            u = fu;
+            w = fw;
+        }
+        _out[2*i]   = static_cast<short>(round_clamped(u*32767.0f, -32767.0f, 32767.0f));
+        _out[2*i+1] = static_cast<short>(round_clamped(w*32767.0f, -32767.0f, 32767.0f));
+    }
+}
+
+void encode_half(const float* _values, size_t _n, unsigned short* _out)
+{
+    const long n = static_cast<long>(_n);
+#pragma omp parallel for schedule(static)
+    for (long i = 0; i < n; ++i)
+        _out[i] = float_to_half(_values[i]);
+}
+
+unsigned short float_to_half(float _f)
+{
+    unsigned int x;
+    std::memcpy(&x, &_f, sizeof(x));
+    const unsigned int sign = (x >> 16) & 0x8000u;
+    const unsigned int mag  = x & 0x7fffffffu;
+
+    if ( mag >= 0x7f800000u )                      // inf, nan
+        return static_cast<unsigned short>(sign | 0x7c00u | (mag > 0x7f800000u ? 0x200u : 0u));
+    if ( mag >= 0x477ff000u )                      // rounds beyond 65504
+        return static_cast<unsigned short>(sign | 0x7c00u);
+
+    unsigned int h, rem, halfway;
+    if ( mag < 0x38800000u )                       // half subnormal or zero
+    {
+        if ( mag < 0x33000000u )
+            return static_cast<unsigned short>(sign);
+        const unsigned int m     = (mag & 0x7fffffu) | 0x800000u;
+        const unsigned int shift = 126u - (mag >> 23);
+        h       = m >> shift;
+        rem     = m & ((1u << shift) - 1u);
+        halfway = 1u << (shift - 1u);
+    }
+    else
+    {
+        h       = (mag - 0x38000000u) >> 13;
+        rem     = mag & 0x1fffu;
+        halfway = 0x1000u;
+    }
+    if ( rem > halfway || (rem == halfway && (h & 1u)) )
+        ++h;
+    return static_cast<unsigned short>(sign | h);
+}
+
+float half_to_float(unsigned short _h)
+{
+    const unsigned int sign = (_h & 0x8000u) << 16;
+    const unsigned int exp  = (_h >> 10) & 0x1fu;
+    const unsigned int man  = _h & 0x3ffu;
+
+    unsigned int x;
+    if ( exp == 0x1fu )
+        x = sign | 0x7f800000u | (man << 13);
+    else if ( exp != 0 )
+        x = sign | ((exp + 112u) << 23) | (man << 13);
+    else if ( man == 0 )
+        x = sign;
+    else
+    {
+        /// subnormal: normalize the mantissa
+        unsigned int e = 113u, m = man;
+        while ( !(m & 0x400u) )
+        {
+            m <<= 1;
+            --e;
+        }
+        x = sign | (e << 23) | ((m & 0x3ffu) << 13);
+    }
+
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+//-----------------------------------------------------------------------------
+/// Lighting mirrors the fixed function model for the viewer's three
+/// directional lights and the front material; vertex colors replace
+/// gl_Color like an enabled color array would.
+const char* quantized_vertex_shader =
+    "#version 120\n"
+    "attribute vec4 q_position;\n"
+    "attribute vec2 q_normal;\n"
+    "attribute vec4 q_color;\n"
+    "attribute vec2 q_texcoord;\n"
+    "uniform vec3  box_min;\n"
+    "uniform vec3  box_size;\n"
+    "uniform bool  lighting;\n"
+    "uniform bool  has_color;\n"
+    "uniform bool  has_texcoord;\n"
+    "uniform bool  color_material;\n"
+    "uniform float light_on[3];\n"
+    "\n"
+    "vec3 octahedral_decode(vec2 e)\n"
+    "{\n"
+    "    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));\n"
+    "    if ( n.z < 0.0 )\n"
+    "        n.xy = (1.0 - abs(n.yx)) * vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);\n"
+    "    return normalize(n);\n"
+    "}\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 eye = gl_ModelViewMatrix * vec4(box_min + q_position.xyz*box_size, 1.0);\n"
+    "    gl_Position     = gl_ProjectionMatrix * eye;\n"
+    "    gl_ClipVertex   = eye;\n"
+    "    gl_FogFragCoord = abs(eye.z);\n"
+    "\n"
+    "    vec4 color = has_color ? q_color : gl_Color;\n"
+    "    if ( lighting )\n"
+    "    {\n"
+    "        vec3 n = normalize(gl_NormalMatrix * octahedral_decode(q_normal));\n"
+    "        vec4 c = gl_FrontLightModelProduct.sceneColor;\n"
+    "        for (int i = 0; i < 3; ++i)\n"
+    "        {\n"
+    "            vec3  l = normalize(gl_LightSource[i].position.xyz);\n"
+    "            float d = max(dot(n, l), 0.0);\n"
+    "            vec4  s = vec4(0.0);\n"
+    "            if ( d > 0.0 )\n"
+    "                s = pow(max(dot(n, normalize(l + vec3(0.0, 0.0, 1.0))), 0.0),\n"
+    "                        gl_FrontMaterial.shininess) * gl_FrontLightProduct[i].specular;\n"
+    "            vec4  m = color_material ? color*gl_LightSource[i].diffuse\n"
+    "                                     : gl_FrontLightProduct[i].diffuse;\n"
+    "            c += light_on[i] * (gl_FrontLightProduct[i].ambient + d*m + s);\n"
+    "        }\n"
+    "        color = vec4(c.rgb, gl_FrontMaterial.diffuse.a);\n"
+    "    }\n"
+    "    gl_FrontColor = color;\n"
+    "    gl_BackColor  = color;\n"
+    "    gl_TexCoord[0] = has_texcoord ? gl_TextureMatrix[0] * vec4(q_texcoord, 0.0, 1.0)\n"
+    "                                  : vec4(0.0, 0.0, 0.0, 1.0);\n"
+    "}\n";
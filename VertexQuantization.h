@@ -0,0 +1,36 @@
+#ifndef VERTEXQUANTIZATION_H
+#define VERTEXQUANTIZATION_H
+
+//== INCLUDES =================================================================
+#include <cstddef>
+
+//== FUNCTIONS ================================================================
+/// Compact GPU encodings of the per-vertex arrays, decoded again by
+/// quantized_vertex_shader:
+///   position  4 x uint16, (p-_min)/_size in [0,1], 4th component padding
+///   normal    2 x int16, octahedral map of the unit sphere onto [-1,1]^2
+///   texcoord  2 x half float
+/// 16 bytes per vertex instead of 32 for float positions, normals and UVs.
+/// All encoders work on _n consecutive elements and run in parallel.
+
+/// _points: 3 floats per vertex, _out: 4 per vertex
+void quantize_positions(const float* _points, size_t _n, const float _min[3],
+                        const float _size[3], unsigned short* _out);
+
+/// _normals: 3 floats per vertex, _out: 2 per vertex
+void encode_octahedral(const float* _normals, size_t _n, short* _out);
+
+/// _values: _n floats, _out: _n halves
+void encode_half(const float* _values, size_t _n, unsigned short* _out);
+
+/// IEEE 754 binary16 with round to nearest even, and back
+unsigned short float_to_half(float _f);
+float          half_to_float(unsigned short _h);
+
+/// GLSL 1.20 vertex shader decoding the layout above, with the fixed
+/// function fragment stage left in place (texturing, fog)
+extern const char* quantized_vertex_shader;
+
+//=============================================================================
+#endif // VERTEXQUANTIZATION_H defined
+//=============================================================================
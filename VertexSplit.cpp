@@ -0,0 +1,161 @@
+//== INCLUDES =================================================================
+#include <algorithm>
+#include <cstring>
+
+#include "VertexSplit.h"
+#include "MeshKernelsT.h"
+
+//== IMPLEMENTATION ==========================================================
+namespace {
+
+/// the attributes of one corner
+struct CornerAttributes
+{
+    const unsigned char* colors;
+    const float*         texcoords;
+
+    /// FNV-1a over the bytes of corner _c
+    unsigned int hash(unsigned int _c) const
+    {
+        unsigned int h = 2166136261u;
+        if ( colors )
+            for (int k = 0; k < 3; ++k)
+                h = (h ^ colors[3*_c+k]) * 16777619u;
+        if ( texcoords )
+        {
+            const unsigned char* t = reinterpret_cast<const unsigned char*>(texcoords + 2*_c);
+            for (size_t k = 0; k < 2*sizeof(float); ++k)
+                h = (h ^ t[k]) * 16777619u;
+        }
+        return h;
+    }
+
+    bool equal(unsigned int _a, unsigned int _b) const
+    {
+        return ( !colors    || std::memcmp(colors + 3*_a, colors + 3*_b, 3) == 0 ) &&
+               ( !texcoords || std::memcmp(texcoords + 2*_a, texcoords + 2*_b, 2*sizeof(float)) == 0 );
+    }
+};
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+void VertexSplit::build(const unsigned int* _triangles, size_t _n_faces, size_t _n_vertices,
+                        const unsigned char* _colors, const float* _texcoords)
+{
+    clear();
+    const size_t nc = 3*_n_faces;
+    const CornerAttributes attributes = { _colors, _texcoords };
+
+    /// corner rows, sorted in place below
+    VertexCorners rows;
+    vertex_corners(_triangles, _n_faces, _n_vertices, rows);
+    const std::vector<unsigned int>& offsets = rows.offsets;
+    std::vector<unsigned int>&       corners = rows.corners;
+
+    std::vector<unsigned int> hash(nc), group(nc);
+    const long n = static_cast<long>(nc);
+#pragma omp parallel for schedule(static)
+    for (long c = 0; c < n; ++c)
+        hash[c] = attributes.hash(static_cast<unsigned int>(c));
+
+    /// per vertex: sort the row by hash, then within a run of equal hashes
+    /// a corner joins the first earlier corner it equals or opens a group;
+    /// groups are numbered in row order
+    first_.assign(_n_vertices+1, 0);
+    const long nv = static_cast<long>(_n_vertices);
+#pragma omp parallel for schedule(dynamic,4096)
+    for (long v = 0; v < nv; ++v)
+    {
+        unsigned int* row = &corners[0] + offsets[v];
+        unsigned int* end = &corners[0] + offsets[v+1];
+        std::sort(row, end, [&hash](unsigned int _a, unsigned int _b)
+                  { return hash[_a] < hash[_b] || (hash[_a] == hash[_b] && _a < _b); });
+
+        unsigned int groups = 0;
+        for (unsigned int* run = row; run != end; )
+        {
+            unsigned int* run_end = run+1;
+            while ( run_end != end && hash[*run_end] == hash[*run] )
+                ++run_end;
+            for (unsigned int* c = run; c != run_end; ++c)
+            {
+                unsigned int* same = run;
+                while ( same != c && !attributes.equal(*same, *c) )
+                    ++same;
+                group[*c] = (same != c) ? group[*same] : groups++;
+            }
+            run = run_end;
+        }
+        /// vertices without faces keep one render vertex
+        first_[v+1] = std::max(groups, 1u);
+    }
+    for (size_t v = 0; v < _n_vertices; ++v)
+        first_[v+1] += first_[v];
+
+    /// number the render vertices, each one's first corner represents it
+    source_.resize(first_[_n_vertices]);
+    corner_.resize(first_[_n_vertices]);
+    indices_.resize(nc);
+#pragma omp parallel for schedule(dynamic,4096)
+    for (long v = 0; v < nv; ++v)
+    {
+        const unsigned int base = first_[v];
+        source_[base] = static_cast<unsigned int>(v);
+        corner_[base] = ~0u;
+
+        unsigned int next = 0;
+        for (unsigned int j = offsets[v]; j < offsets[v+1]; ++j)
+        {
+            const unsigned int c = corners[j];
+            indices_[c] = base + group[c];
+            if ( group[c] == next )
+            {
+                source_[base+next] = static_cast<unsigned int>(v);
+                corner_[base+next] = c;
+                ++next;
+            }
+        }
+    }
+}
+
+void VertexSplit::clear()
+{
+    std::vector<unsigned int>().swap(first_);
+    std::vector<unsigned int>().swap(source_);
+    std::vector<unsigned int>().swap(corner_);
+    std::vector<unsigned int>().swap(indices_);
+}
+
+void VertexSplit::gather(const void* _in, size_t _size, size_t _first, size_t _n, void* _out) const
+{
+    const unsigned char* in  = static_cast<const unsigned char*>(_in);
+    unsigned char*       out = static_cast<unsigned char*>(_out);
+    const long n = static_cast<long>(std::min(_n, source_.size() - std::min(_first, source_.size())));
+#pragma omp parallel for schedule(static) if (n > 65536)
+    for (long r = 0; r < n; ++r)
+        std::memcpy(out + r*_size, in + source_[_first+r]*_size, _size);
+}
+
+void VertexSplit::gather_corners(const void* _in, size_t _size, void* _out) const
+{
+    const unsigned char* in  = static_cast<const unsigned char*>(_in);
+    unsigned char*       out = static_cast<unsigned char*>(_out);
+    const long n = static_cast<long>(corner_.size());
+#pragma omp parallel for schedule(static) if (n > 65536)
+    for (long r = 0; r < n; ++r)
+    {
+        if ( corner_[r] == ~0u )
+            std::memset(out + r*_size, 0, _size);
+        else
+            std::memcpy(out + r*_size, in + corner_[r]*_size, _size);
+    }
+}
+
+size_t VertexSplit::bytes() const
+{
+    return (first_.capacity() + source_.capacity() + corner_.capacity() + indices_.capacity())
+           *sizeof(unsigned int);
+}
+
+//=============================================================================
@@ -0,0 +1,62 @@
+#ifndef VERTEXSPLIT_H
+#define VERTEXSPLIT_H
+
+//== INCLUDES =================================================================
+#include <vector>
+#include <cstddef>
+
+//== CLASS DEFINITION =========================================================
+/// Render vertices of a triangle mesh whose corners carry attributes of
+/// their own, face colors or per-halfedge texture coordinates: a vertex is
+/// split only where the attributes of its corners differ, so a seam gets a
+/// second vertex and a uniformly colored patch none, and the triangles keep
+/// an index list instead of three unshared vertices each.
+/// The render vertices of mesh vertex v are first(v) .. first(v+1)-1, in
+/// vertex order, so per mesh vertex data maps to them by a gather and a
+/// range of mesh vertices to one range of render vertices.
+class VertexSplit
+{
+public:
+    VertexSplit() {}
+
+    /// Group the corners 3f+k around each vertex: _colors holds 3 bytes and
+    /// _texcoords 2 floats per corner, either may be 0, and corners with
+    /// bitwise equal attributes share a render vertex. Corners are hashed,
+    /// sorted by hash within each vertex and compared exactly inside a run
+    /// of equal hashes, one vertex per iteration of a parallel loop.
+    void build(const unsigned int* _triangles, size_t _n_faces, size_t _n_vertices,
+               const unsigned char* _colors, const float* _texcoords);
+    void clear();
+    bool empty() const { return source_.empty(); }
+
+    size_t n_vertices() const        { return first_.empty() ? 0 : first_.size()-1; }
+    size_t n_render_vertices() const { return source_.size(); }
+    /// render vertices per mesh vertex, 1 if nothing was split
+    double ratio() const { return n_vertices() ? double(n_render_vertices())/n_vertices() : 1.0; }
+
+    /// first render vertex of mesh vertex _v, _v == n_vertices() is the end
+    unsigned int first(size_t _v) const { return first_[_v]; }
+    /// mesh vertex of each render vertex
+    const std::vector<unsigned int>& source() const  { return source_; }
+    /// three render vertices per triangle
+    const std::vector<unsigned int>& indices() const { return indices_; }
+
+    /// _out[r] = _in[source[r]] for render vertices [_first,_first+_n) and
+    /// elements of _size bytes; _out holds just those
+    void gather(const void* _in, size_t _size, size_t _first, size_t _n, void* _out) const;
+    /// _out[r] = the attribute of a corner of render vertex r, for all render
+    /// vertices; zero for vertices without a face
+    void gather_corners(const void* _in, size_t _size, void* _out) const;
+
+    size_t bytes() const;
+
+private:
+    std::vector<unsigned int> first_;     ///< n_vertices+1
+    std::vector<unsigned int> source_;
+    std::vector<unsigned int> corner_;    ///< representative corner, ~0u if none
+    std::vector<unsigned int> indices_;
+};
+
+//=============================================================================
+#endif // VERTEXSPLIT_H defined
+//=============================================================================
@@ -0,0 +1,602 @@
+//== INCLUDES =================================================================
+#include <cmath>
+#include <limits>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+
+#include <QtConcurrent/QtConcurrentRun>
+#include <QGLShaderProgram>
+#include <QGLFramebufferObject>
+
+#include "VirtualTexture.h"
+
+//== IMPLEMENTATION ==========================================================
+namespace {
+
+/// feedback pixels are this many view pixels wide and high
+const int feedback_scale = 8;
+
+/// tiles decoded per worker run, at most this many uploads per frame
+const size_t load_batch = 64;
+
+/// last_used of the top level tile, never evicted
+const unsigned int pinned = std::numeric_limits<unsigned int>::max();
+
+/// slot_of_ of tiles that failed to decode, not requested again
+const int unreadable = -2;
+
+/// the fixed function lighting of quantized_vertex_shader, from client arrays
+const char* vertex_shader =
+    "#version 120\n"
+    "uniform bool  lighting;\n"
+    "uniform bool  color_material;\n"
+    "uniform float light_on[3];\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 eye = gl_ModelViewMatrix * gl_Vertex;\n"
+    "    gl_Position     = gl_ProjectionMatrix * eye;\n"
+    "    gl_ClipVertex   = eye;\n"
+    "    gl_FogFragCoord = abs(eye.z);\n"
+    "\n"
+    "    vec4 color = gl_Color;\n"
+    "    if ( lighting )\n"
+    "    {\n"
+    "        vec3 n = normalize(gl_NormalMatrix * gl_Normal);\n"
+    "        vec4 c = gl_FrontLightModelProduct.sceneColor;\n"
+    "        for (int i = 0; i < 3; ++i)\n"
+    "        {\n"
+    "            vec3  l = normalize(gl_LightSource[i].position.xyz);\n"
+    "            float d = max(dot(n, l), 0.0);\n"
+    "            vec4  s = vec4(0.0);\n"
+    "            if ( d > 0.0 )\n"
+    "                s = pow(max(dot(n, normalize(l + vec3(0.0, 0.0, 1.0))), 0.0),\n"
+    "                        gl_FrontMaterial.shininess) * gl_FrontLightProduct[i].specular;\n"
+    "            vec4  m = color_material ? color*gl_LightSource[i].diffuse\n"
+    "                                     : gl_FrontLightProduct[i].diffuse;\n"
+    "            c += light_on[i] * (gl_FrontLightProduct[i].ambient + d*m + s);\n"
+    "        }\n"
+    "        color = vec4(c.rgb, gl_FrontMaterial.diffuse.a);\n"
+    "    }\n"
+    "    gl_FrontColor  = color;\n"
+    "    gl_BackColor   = color;\n"
+    "    gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;\n"
+    "}\n";
+
+/// level and tile of a fragment, shared by both fragment programs; texture
+/// coordinates wrap like GL_REPEAT, t = 1 is the top image row
+const char* tile_lookup =
+    "#version 120\n"
+    "uniform vec2  image_size;\n"
+    "uniform float tile_size;\n"
+    "uniform float top_level;\n"
+    "uniform float lod_bias;\n"
+    "\n"
+    "vec2 texel_position(vec2 st)\n"
+    "{\n"
+    "    return vec2(fract(st.s), 1.0 - fract(st.t)) * image_size;\n"
+    "}\n"
+    "\n"
+    "float level_of(vec2 st)\n"
+    "{\n"
+    "    vec2  dx  = dFdx(st*image_size), dy = dFdy(st*image_size);\n"
+    "    float lod = 0.5*log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)) + lod_bias;\n"
+    "    return clamp(floor(lod + 0.5), 0.0, top_level);\n"
+    "}\n";
+
+/// page table entry: slot x, slot y, level of the mapped tile
+const char* draw_fragment_shader =
+    "uniform sampler2D cache;\n"
+    "uniform sampler2D page_table;\n"
+    "uniform vec2  cache_size;\n"
+    "uniform vec2  table_size;\n"
+    "uniform bool  modulate;\n"
+    "uniform bool  fog;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    vec2  st    = gl_TexCoord[0].st;\n"
+    "    float level = level_of(st);\n"
+    "    vec2  p     = texel_position(st);\n"
+    "    vec2  tile  = floor(p / (tile_size*exp2(level)));\n"
+    "    vec2  entry_at = vec2(table_size.x*(1.0 - exp2(-level)), 0.0) + tile + 0.5;\n"
+    "    vec4  entry = floor(texture2D(page_table, entry_at/table_size)*255.0 + 0.5);\n"
+    "\n"
+    "    vec2  f = p / (tile_size*exp2(entry.b));\n"
+    "    f -= floor(f);\n"
+    "    vec2  texel = entry.rg*(tile_size + 1.0) + 0.5 + f*tile_size;\n"
+    "    vec4  color = texture2D(cache, texel/cache_size);\n"
+    "\n"
+    "    if ( modulate )\n"
+    "        color *= gl_Color;\n"
+    "    if ( fog )\n"
+    "        color.rgb = mix(gl_Fog.color.rgb, color.rgb,\n"
+    "                        clamp((gl_Fog.end - gl_FogFragCoord)*gl_Fog.scale, 0.0, 1.0));\n"
+    "    gl_FragColor = color;\n"
+    "}\n";
+
+/// tile x and y in 12 bits each, level + 1 in alpha (0: background)
+const char* feedback_fragment_shader =
+    "void main()\n"
+    "{\n"
+    "    vec2  st    = gl_TexCoord[0].st;\n"
+    "    float level = level_of(st);\n"
+    "    vec2  tile  = floor(texel_position(st) / (tile_size*exp2(level)));\n"
+    "    vec2  high  = floor(tile/256.0);\n"
+    "    vec2  low   = tile - 256.0*high;\n"
+    "    gl_FragColor = vec4(low, high.x + 16.0*high.y, level + 1.0) / 255.0;\n"
+    "}\n";
+
+/// runs on a pool thread, touches nothing but _images
+void decode_tiles(const TilePyramid* _pyramid, const std::vector<size_t>* _tiles,
+                  std::vector<QImage>* _images)
+{
+    const int n = static_cast<int>(_tiles->size());
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < n; ++i)
+        if ( !_pyramid->read_tile((*_tiles)[i], (*_images)[i]) )
+            (*_images)[i] = QImage();
+}
+
+inline unsigned int table_entry(int _x, int _y, int _level)
+{
+    return _x | (_y << 8) | (_level << 16) | (255u << 24);
+}
+
+}
+
+//-----------------------------------------------------------------------------
+VirtualTexture::VirtualTexture(QObject* _parent)
+    : QObject(_parent),
+      budget_(0),
+      cache_id_(0),
+      slots_x_(0),
+      slots_y_(0),
+      n_resident_(0),
+      table_id_(0),
+      table_w_(0),
+      table_h_(0),
+      table_dirty_(false),
+      draw_program_(0),
+      feedback_program_(0),
+      feedback_fbo_(0),
+      gl_failed_(false),
+      previous_fbo_(0),
+      frame_(1),
+      lod_bias_(0.0f)
+{
+    connect(&loader_, SIGNAL(finished()), this, SLOT(load_finished()));
+}
+
+VirtualTexture::~VirtualTexture()
+{
+    /// GL objects go with the context
+    loader_.waitForFinished();
+}
+
+bool VirtualTexture::open(const QString& _pack, size_t _budget)
+{
+    clear();
+    if ( !pyramid_.open(_pack) )
+        return false;
+
+    budget_ = _budget;
+    slot_of_.assign(pyramid_.n_tiles(), -1);
+    requested_.assign(pyramid_.n_tiles(), 0);
+    table_w_ = 1 << pyramid_.levels();
+    table_h_ = 1 << (pyramid_.levels()-1);
+    table_.assign(static_cast<size_t>(table_w_)*table_h_, 0);
+    return true;
+}
+
+void VirtualTexture::clear()
+{
+    loader_.waitForFinished();
+    loading_.clear();
+    loaded_.clear();
+
+    if ( cache_id_ )
+        glDeleteTextures(1, &cache_id_);
+    if ( table_id_ )
+        glDeleteTextures(1, &table_id_);
+    cache_id_ = table_id_ = 0;
+    delete draw_program_;
+    delete feedback_program_;
+    delete feedback_fbo_;
+    draw_program_ = feedback_program_ = 0;
+    feedback_fbo_ = 0;
+    gl_failed_ = false;
+
+    pyramid_.close();
+    std::vector<Slot>().swap(slots_);
+    std::vector<int>().swap(slot_of_);
+    std::vector<unsigned int>().swap(table_);
+    std::vector<unsigned int>().swap(requested_);
+    std::vector<size_t>().swap(pending_);
+    n_resident_ = 0;
+    slots_x_ = slots_y_ = table_w_ = table_h_ = 0;
+    frame_ = 1;
+    lod_bias_ = 0.0f;
+}
+
+bool VirtualTexture::init_gl()
+{
+    if ( gl_failed_ || !is_open() )
+        return false;
+    if ( cache_id_ )
+        return true;
+
+    /// stays set if anything below fails
+    gl_failed_ = true;
+
+    const QGLContext* context = QGLContext::currentContext();
+    if ( !QGLShaderProgram::hasOpenGLShaderPrograms(context) ||
+         !QGLFramebufferObject::hasOpenGLFramebufferObjects() )
+    {
+        std::cerr << "Virtual textures need GLSL 1.20 and framebuffer objects" << std::endl;
+        return false;
+    }
+    gl_.initializeGLFunctions(context);
+
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    if ( table_w_ > max_size )
+    {
+        std::cerr << "Virtual texture: page table exceeds GL_MAX_TEXTURE_SIZE" << std::endl;
+        return false;
+    }
+
+    /// as many pages as the budget holds, 8 bit slot coordinates
+    const int page = pyramid_.tile_size()+1;
+    const int side = std::min(max_size/page, 256);
+    const size_t wanted = std::max<size_t>(budget_/(4*page*page), 4);
+    const int n = static_cast<int>(std::min<size_t>(wanted, static_cast<size_t>(side)*side));
+    slots_x_ = std::min(side, static_cast<int>(std::ceil(std::sqrt(double(n)))));
+    slots_y_ = std::min(side, (n + slots_x_-1)/slots_x_);
+    slots_.assign(slots_x_*slots_y_, Slot());
+
+    glGenTextures(1, &cache_id_);
+    glBindTexture(GL_TEXTURE_2D, cache_id_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, slots_x_*page, slots_y_*page, 0,
+                 GL_BGRA, GL_UNSIGNED_BYTE, 0);
+
+    glGenTextures(1, &table_id_);
+    glBindTexture(GL_TEXTURE_2D, table_id_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, table_w_, table_h_, 0,
+                 GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    draw_program_     = new QGLShaderProgram(context, this);
+    feedback_program_ = new QGLShaderProgram(context, this);
+    const QString lookup(tile_lookup);
+    if ( !draw_program_->addShaderFromSourceCode(QGLShader::Vertex, vertex_shader) ||
+         !draw_program_->addShaderFromSourceCode(QGLShader::Fragment, lookup + draw_fragment_shader) ||
+         !draw_program_->link() ||
+         !feedback_program_->addShaderFromSourceCode(QGLShader::Vertex, vertex_shader) ||
+         !feedback_program_->addShaderFromSourceCode(QGLShader::Fragment, lookup + feedback_fragment_shader) ||
+         !feedback_program_->link() )
+    {
+        std::cerr << draw_program_->log().toLocal8Bit().constData()
+                  << feedback_program_->log().toLocal8Bit().constData() << std::endl;
+        return false;
+    }
+
+    /// the top level is the fallback of every lookup
+    const size_t top = pyramid_.index(pyramid_.levels()-1, 0, 0);
+    QImage image;
+    if ( !pyramid_.read_tile(top, image) )
+    {
+        std::cerr << "Virtual texture: cannot read the top level tile" << std::endl;
+        return false;
+    }
+    upload(0, image);
+    slots_[0].tile      = static_cast<long>(top);
+    slots_[0].last_used = pinned;
+    slot_of_[top]       = 0;
+    n_resident_         = 1;
+    table_dirty_        = true;
+
+    std::clog << "Virtual texture cache: " << slots_x_*slots_y_ << " tiles of " << page << "^2, "
+              << gpu_bytes()/(1024.0*1024.0) << " MB" << std::endl;
+
+    gl_failed_ = false;
+    return true;
+}
+
+void VirtualTexture::upload(int _slot, const QImage& _tile)
+{
+    const int page = pyramid_.tile_size()+1;
+    glBindTexture(GL_TEXTURE_2D, cache_id_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    /// ARGB32 words hold blue in the low byte
+    glTexSubImage2D(GL_TEXTURE_2D, 0, (_slot % slots_x_)*page, (_slot / slots_x_)*page, page, page,
+                    GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, _tile.constBits());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+bool VirtualTexture::update()
+{
+    if ( !init_gl() )
+        return false;
+
+    /// polled rather than signaled, so offscreen exports stream too
+    if ( !loading_.empty() && loader_.future().isFinished() )
+    {
+        for (size_t i = 0; i < loading_.size(); ++i)
+        {
+            const size_t tile = loading_[i];
+            if ( slot_of_[tile] >= 0 )
+                continue;
+            if ( loaded_[i].isNull() )
+            {
+                slot_of_[tile] = unreadable;
+                continue;
+            }
+            const int slot = evict();
+            if ( slot < 0 )
+                break;
+
+            if ( slots_[slot].tile >= 0 )
+            {
+                slot_of_[slots_[slot].tile] = -1;
+                --n_resident_;
+            }
+            upload(slot, loaded_[i]);
+            slots_[slot].tile      = static_cast<long>(tile);
+            slots_[slot].last_used = frame_;
+            slot_of_[tile] = slot;
+            ++n_resident_;
+            table_dirty_ = true;
+        }
+        loading_.clear();
+        loaded_.clear();
+    }
+
+    if ( table_dirty_ )
+        update_page_table();
+    start_loading();
+    return true;
+}
+
+int VirtualTexture::evict()
+{
+    int best = -1;
+    unsigned int oldest = frame_;
+    for (size_t s = 0; s < slots_.size(); ++s)
+    {
+        if ( slots_[s].tile < 0 )
+            return static_cast<int>(s);
+        if ( slots_[s].last_used < oldest )
+        {
+            oldest = slots_[s].last_used;
+            best = static_cast<int>(s);
+        }
+    }
+    return best;
+}
+
+void VirtualTexture::update_page_table()
+{
+    /// top down, missing tiles inherit their parent's entry
+    const int levels = pyramid_.levels();
+    for (int l = levels-1; l >= 0; --l)
+    {
+        const int n  = pyramid_.tiles(l);
+        const int x0 = table_w_ - (table_w_ >> l);
+        const int px = table_w_ - (table_w_ >> (l+1));
+        for (int y = 0; y < n; ++y)
+            for (int x = 0; x < n; ++x)
+            {
+                const int slot = slot_of_[pyramid_.index(l, x, y)];
+                unsigned int& entry = table_[static_cast<size_t>(y)*table_w_ + x0 + x];
+                if ( slot >= 0 )
+                    entry = table_entry(slot % slots_x_, slot / slots_x_, l);
+                else if ( l+1 < levels )
+                    entry = table_[static_cast<size_t>(y/2)*table_w_ + px + x/2];
+                else
+                    entry = 0;
+            }
+    }
+
+    glBindTexture(GL_TEXTURE_2D, table_id_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, table_w_, table_h_,
+                    GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, &table_[0]);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    table_dirty_ = false;
+}
+
+void VirtualTexture::start_loading()
+{
+    if ( !loading_.empty() || pending_.empty() )
+        return;
+
+    size_t i = 0;
+    for (; i < pending_.size() && loading_.size() < load_batch; ++i)
+        if ( slot_of_[pending_[i]] == -1 )
+            loading_.push_back(pending_[i]);
+    pending_.erase(pending_.begin(), pending_.begin()+i);
+    if ( loading_.empty() )
+        return;
+
+    loaded_.assign(loading_.size(), QImage());
+    loader_.setFuture(QtConcurrent::run(decode_tiles, &pyramid_, &loading_, &loaded_));
+}
+
+void VirtualTexture::load_finished()
+{
+    emit tiles_ready();
+}
+
+void VirtualTexture::set_uniforms(QGLShaderProgram* _program, float _lod_bias)
+{
+    _program->setUniformValue("image_size", GLfloat(pyramid_.width()), GLfloat(pyramid_.height()));
+    _program->setUniformValue("tile_size",  GLfloat(pyramid_.tile_size()));
+    _program->setUniformValue("top_level",  GLfloat(pyramid_.levels()-1));
+    _program->setUniformValue("lod_bias",   _lod_bias + lod_bias_);
+    _program->setUniformValue("lighting",   static_cast<GLint>(glIsEnabled(GL_LIGHTING)));
+    _program->setUniformValue("color_material", static_cast<GLint>(glIsEnabled(GL_COLOR_MATERIAL)));
+    GLfloat on[3];
+    for (int i = 0; i < 3; ++i)
+        on[i] = glIsEnabled(GL_LIGHT0+i) ? 1.0f : 0.0f;
+    _program->setUniformValueArray("light_on", on, 3, 1);
+}
+
+bool VirtualTexture::begin_feedback()
+{
+    if ( !init_gl() )
+        return false;
+
+    /// the frame may itself go to a framebuffer object, e.g. when exporting
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous_fbo_);
+    glGetIntegerv(GL_VIEWPORT, previous_viewport_);
+
+    const int w = std::max(1, previous_viewport_[2]/feedback_scale);
+    const int h = std::max(1, previous_viewport_[3]/feedback_scale);
+    if ( !feedback_fbo_ || feedback_fbo_->width() != w || feedback_fbo_->height() != h )
+    {
+        delete feedback_fbo_;
+        feedback_fbo_ = new QGLFramebufferObject(w, h, QGLFramebufferObject::Depth);
+    }
+    if ( !feedback_fbo_->isValid() )
+        return false;
+
+    glPushAttrib(GL_COLOR_BUFFER_BIT | GL_ENABLE_BIT);
+
+    feedback_fbo_->bind();
+    glViewport(0, 0, w, h);
+    glDisable(GL_BLEND);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    /// feedback pixels see feedback_scale times coarser derivatives
+    feedback_program_->bind();
+    set_uniforms(feedback_program_, -std::log(double(feedback_scale))/std::log(2.0));
+    return true;
+}
+
+void VirtualTexture::end_feedback()
+{
+    feedback_program_->release();
+
+    const int w = feedback_fbo_->width(), h = feedback_fbo_->height();
+    std::vector<unsigned char> pixels(4*w*h);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+
+    glPopAttrib();
+    gl_.glBindFramebuffer(GL_FRAMEBUFFER, previous_fbo_);
+    glViewport(previous_viewport_[0], previous_viewport_[1], previous_viewport_[2], previous_viewport_[3]);
+
+    /// every tile once per frame: resident ones are touched along with the
+    /// ancestor standing in for them, missing ones queued coarse first
+    ++frame_;
+    std::vector<size_t> missing;
+    size_t seen = 0;
+    const int levels = pyramid_.levels();
+    for (size_t p = 0; p < pixels.size(); p += 4)
+    {
+        if ( !pixels[p+3] )
+            continue;
+        const int level = pixels[p+3]-1;
+        const int x = pixels[p]   + 256*(pixels[p+2] & 15);
+        const int y = pixels[p+1] + 256*(pixels[p+2] >> 4);
+        if ( level >= levels || x >= pyramid_.tiles(level) || y >= pyramid_.tiles(level) )
+            continue;
+
+        const size_t tile = pyramid_.index(level, x, y);
+        if ( requested_[tile] == frame_ )
+            continue;
+        requested_[tile] = frame_;
+
+        ++seen;
+        if ( slot_of_[tile] == -1 && pyramid_.has_tile(tile) )
+            missing.push_back(tile);
+        for (int l = level; l < levels; ++l)
+        {
+            const int slot = slot_of_[pyramid_.index(l, x >> (l-level), y >> (l-level))];
+            if ( slot >= 0 )
+            {
+                if ( slots_[slot].last_used != pinned )
+                    slots_[slot].last_used = frame_;
+                break;
+            }
+        }
+    }
+
+    /// A view needing most of the cache is drawn a level coarser, and a
+    /// level finer again once that would fit comfortably; a level step
+    /// changes the tile count about fourfold, hence the gap.
+    if ( 4*seen > 3*slots_.size() && lod_bias_ < levels-1 )
+    {
+        lod_bias_ += 1.0f;
+        std::clog << "Virtual texture: " << seen << " tiles in view, level bias " << lod_bias_ << std::endl;
+    }
+    else if ( 16*seen < 3*slots_.size() && lod_bias_ > 0.0f )
+        lod_bias_ -= 1.0f;
+
+    /// coarser levels have larger indices
+    std::sort(missing.begin(), missing.end(), std::greater<size_t>());
+    pending_.swap(missing);
+    start_loading();
+}
+
+bool VirtualTexture::bind(bool _modulate)
+{
+    if ( !init_gl() )
+        return false;
+
+    gl_.glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, table_id_);
+    gl_.glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, cache_id_);
+
+    const int page = pyramid_.tile_size()+1;
+    draw_program_->bind();
+    set_uniforms(draw_program_, 0.0f);
+    draw_program_->setUniformValue("cache", 0);
+    draw_program_->setUniformValue("page_table", 1);
+    draw_program_->setUniformValue("cache_size", GLfloat(slots_x_*page), GLfloat(slots_y_*page));
+    draw_program_->setUniformValue("table_size", GLfloat(table_w_), GLfloat(table_h_));
+    draw_program_->setUniformValue("modulate", static_cast<GLint>(_modulate));
+    draw_program_->setUniformValue("fog", static_cast<GLint>(glIsEnabled(GL_FOG)));
+    return true;
+}
+
+void VirtualTexture::release()
+{
+    draw_program_->release();
+    gl_.glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    gl_.glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+size_t VirtualTexture::gpu_bytes() const
+{
+    const size_t page = pyramid_.tile_size()+1;
+    size_t bytes = 0;
+    if ( cache_id_ )
+        bytes += 4*page*page*slots_.size() + 4*table_.size();
+    if ( feedback_fbo_ )
+        bytes += 8*feedback_fbo_->width()*feedback_fbo_->height();
+    return bytes;
+}
+
+size_t VirtualTexture::cpu_bytes() const
+{
+    return pyramid_.bytes() + slots_.capacity()*sizeof(Slot) + slot_of_.capacity()*sizeof(int) +
+           table_.capacity()*sizeof(unsigned int) + requested_.capacity()*sizeof(unsigned int) +
+           pending_.capacity()*sizeof(size_t);
+}
@@ -0,0 +1,135 @@
+#ifndef VIRTUALTEXTURE_H
+#define VIRTUALTEXTURE_H
+
+//== INCLUDES =================================================================
+#include <vector>
+#include <cstddef>
+
+#include <QObject>
+#include <QImage>
+#include <QFutureWatcher>
+#include <QGLFunctions>
+
+#include "TilePyramid.h"
+
+class QGLShaderProgram;
+class QGLFramebufferObject;
+
+//== CLASS DEFINITION =========================================================
+/// Texture of any size drawn from a TilePyramid, with only the tiles in
+/// view resident in a fixed size GPU cache:
+/// - a feedback pass renders tile ids and levels of the visible surface
+///   into a framebuffer at 1/8 of the view size, read back every frame;
+/// - missing tiles are decoded on a worker thread, coarse levels first, and
+///   uploaded into cache slots at the start of the next frame, evicting the
+///   least recently seen tiles;
+/// - a page table with one texel per tile of every level points at the
+///   tile's slot, or at its closest resident ancestor, so every lookup
+///   finds some texel; the top level is loaded up front and never evicted.
+/// Drawing uses GLSL 1.20 programs fed by the fixed function client arrays
+/// (positions, normals, texture coordinates), lit like the fixed pipeline.
+/// All methods need the owning widget's context to be current.
+class VirtualTexture : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit VirtualTexture(QObject* _parent=0);
+    ~VirtualTexture();
+
+    /// use the pyramid in _pack with at most _budget bytes of resident
+    /// tiles; GL objects are created on the first update()
+    bool open(const QString& _pack, size_t _budget);
+    void clear();
+    bool is_open() const { return pyramid_.is_open(); }
+
+    /// Upload tiles decoded since the last call and refresh the page table.
+    /// False if the GL objects cannot be created.
+    bool update();
+
+    /// Render the geometry drawn between these calls into the feedback
+    /// buffer, at 1/8 of the current viewport with the current matrices,
+    /// then read it back and request the tiles it shows
+    bool begin_feedback();
+    void end_feedback();
+
+    /// tiles requested by the last feedback pass still on their way, and a
+    /// blocking wait for the batch being decoded (frames that have to be
+    /// final, e.g. exports)
+    bool loading() const { return !loading_.empty() || !pending_.empty(); }
+    void wait_for_tiles() { loader_.waitForFinished(); }
+
+    /// bind program and textures for drawing, _modulate as GL_MODULATE
+    bool bind(bool _modulate);
+    void release();
+
+    size_t gpu_bytes() const;
+    size_t cpu_bytes() const;
+    size_t resident_tiles() const { return n_resident_; }
+    int    width() const  { return pyramid_.width(); }
+    int    height() const { return pyramid_.height(); }
+
+signals:
+    /// decoded tiles wait for the next update(), time for a redraw
+    void tiles_ready();
+
+private slots:
+    void load_finished();
+
+private:
+    struct Slot
+    {
+        Slot() : tile(-1), last_used(0) {}
+
+        long         tile;        ///< pyramid tile index, -1: free
+        unsigned int last_used;   ///< feedback frame that last showed it
+    };
+
+    bool init_gl();
+    void set_uniforms(QGLShaderProgram* _program, float _lod_bias);
+    void upload(int _slot, const QImage& _tile);
+    void start_loading();
+    /// slot for a new tile: a free one, else the least recently used tile
+    /// not seen in the current frame; -1 if every slot is in view
+    int  evict();
+    void update_page_table();
+
+    TilePyramid               pyramid_;
+    size_t                    budget_;
+
+    /// cache of tile_size()+1 pixel pages, slots_x_ by slots_y_
+    GLuint                    cache_id_;
+    int                       slots_x_, slots_y_;
+    std::vector<Slot>         slots_;
+    std::vector<int>          slot_of_;      ///< per tile, -1: not resident, -2: unreadable
+    size_t                    n_resident_;
+
+    /// all levels side by side, level l at x = 2^levels - 2^(levels-l)
+    GLuint                    table_id_;
+    int                       table_w_, table_h_;
+    std::vector<unsigned int> table_;
+    bool                      table_dirty_;
+
+    QGLShaderProgram*         draw_program_;
+    QGLShaderProgram*         feedback_program_;
+    QGLFramebufferObject*     feedback_fbo_;
+    QGLFunctions              gl_;
+    bool                      gl_failed_;
+    GLint                     previous_fbo_;
+    GLint                     previous_viewport_[4];
+
+    /// feedback frame counter and the frame each tile was last requested in
+    unsigned int              frame_;
+    std::vector<unsigned int> requested_;
+    std::vector<size_t>       pending_;      ///< missing tiles, coarse first
+    float                     lod_bias_;     ///< levels coarser while the view overfills the cache
+
+    /// worker decoding loading_ into loaded_, empty while idle
+    QFutureWatcher<void>      loader_;
+    std::vector<size_t>       loading_;
+    std::vector<QImage>       loaded_;
+};
+
+//=============================================================================
+#endif // VIRTUALTEXTURE_H defined
+//=============================================================================
@@ -0,0 +1,131 @@
+//== INCLUDES =================================================================
+#include <cmath>
+#include <random>
+#include <unordered_map>
+
+#include "MeshGenerators.h"
+
+//== IMPLEMENTATION ==========================================================
+typedef TCMesh::Point Point;
+
+static unsigned int midpoint(unsigned int _a, unsigned int _b, MeshArrays& _out,
+                             std::unordered_map<unsigned long long, unsigned int>& _cache)
+{
+    unsigned long long key = (_a < _b) ? (static_cast<unsigned long long>(_a) << 32) | _b
+                                       : (static_cast<unsigned long long>(_b) << 32) | _a;
+    std::unordered_map<unsigned long long, unsigned int>::iterator it = _cache.find(key);
+    if ( it != _cache.end() )
+        return it->second;
+
+    Point m = _out.points[_a] + _out.points[_b];
+    _out.points.push_back(m/m.norm());
+    unsigned int idx = static_cast<unsigned int>(_out.points.size()-1);
+    _cache[key] = idx;
+    return idx;
+}
+
+void make_icosphere(size_t _faces, MeshArrays& _out)
+{
+    /// 20*4^level faces, pick the level closest on a log scale
+    int level = 0;
+    while ( 20.0*std::pow(4.0, level+0.5) < _faces )
+        ++level;
+
+    const float t = (1.0f+std::sqrt(5.0f))/2.0f;
+    const float v[12][3] = { {-1, t, 0}, { 1, t, 0}, {-1,-t, 0}, { 1,-t, 0},
+                             { 0,-1, t}, { 0, 1, t}, { 0,-1,-t}, { 0, 1,-t},
+                             { t, 0,-1}, { t, 0, 1}, {-t, 0,-1}, {-t, 0, 1} };
+    const unsigned int f[20][3] = { {0,11,5}, {0,5,1}, {0,1,7}, {0,7,10}, {0,10,11},
+                                    {1,5,9}, {5,11,4}, {11,10,2}, {10,7,6}, {7,1,8},
+                                    {3,9,4}, {3,4,2}, {3,2,6}, {3,6,8}, {3,8,9},
+                                    {4,9,5}, {2,4,11}, {6,2,10}, {8,6,7}, {9,8,1} };
+
+    _out.points.clear();
+    _out.triangles.clear();
+    for (int i = 0; i < 12; ++i)
+    {
+        Point p(v[i][0], v[i][1], v[i][2]);
+        _out.points.push_back(p/p.norm());
+    }
+    _out.triangles.assign(&f[0][0], &f[0][0]+60);
+
+    for (int l = 0; l < level; ++l)
+    {
+        std::unordered_map<unsigned long long, unsigned int> cache;
+        cache.reserve(_out.triangles.size()/2*3);
+        std::vector<unsigned int> tris;
+        tris.reserve(4*_out.triangles.size());
+
+        for (size_t i = 0; i < _out.triangles.size(); i += 3)
+        {
+            unsigned int a = _out.triangles[i], b = _out.triangles[i+1], c = _out.triangles[i+2];
+            unsigned int ab = midpoint(a, b, _out, cache);
+            unsigned int bc = midpoint(b, c, _out, cache);
+            unsigned int ca = midpoint(c, a, _out, cache);
+            unsigned int sub[12] = { a,ab,ca, b,bc,ab, c,ca,bc, ab,bc,ca };
+            tris.insert(tris.end(), sub, sub+12);
+        }
+        _out.triangles.swap(tris);
+    }
+}
+
+void make_noisy_grid(size_t _faces, float _noise, MeshArrays& _out)
+{
+    /// 2*(n-1)^2 faces
+    size_t n = static_cast<size_t>(std::sqrt(_faces/2.0)) + 1;
+    if ( n < 2 )
+        n = 2;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> noise(-_noise, _noise);
+
+    _out.points.resize(n*n);
+    for (size_t j = 0; j < n; ++j)
+        for (size_t i = 0; i < n; ++i)
+            _out.points[j*n+i] = Point(float(i)/(n-1), float(j)/(n-1), noise(rng));
+
+    _out.triangles.clear();
+    _out.triangles.reserve(6*(n-1)*(n-1));
+    for (size_t j = 0; j+1 < n; ++j)
+        for (size_t i = 0; i+1 < n; ++i)
+        {
+            unsigned int v00 = j*n+i, v10 = v00+1, v01 = v00+n, v11 = v01+1;
+            unsigned int quad[6] = { v00,v10,v11, v00,v11,v01 };
+            _out.triangles.insert(_out.triangles.end(), quad, quad+6);
+        }
+}
+
+void make_triangle_soup(size_t _faces, MeshArrays& _out)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> pos(0.0f, 1.0f), offset(-0.01f, 0.01f);
+
+    _out.points.resize(3*_faces);
+    _out.triangles.resize(3*_faces);
+    for (size_t i = 0; i < _faces; ++i)
+    {
+        Point c(pos(rng), pos(rng), pos(rng));
+        for (int k = 0; k < 3; ++k)
+        {
+            _out.points[3*i+k]    = c + Point(offset(rng), offset(rng), offset(rng));
+            _out.triangles[3*i+k] = static_cast<unsigned int>(3*i+k);
+        }
+    }
+}
+
+void build_mesh(const MeshArrays& _arrays, TCMesh& _mesh)
+{
+    const size_t nv = _arrays.points.size(), nf = _arrays.n_faces();
+
+    _mesh.clear();
+    _mesh.reserve(nv, nv+nf, nf);
+
+    std::vector<TCMesh::VertexHandle> vhs(nv);
+    for (size_t i = 0; i < nv; ++i)
+        vhs[i] = _mesh.add_vertex(_arrays.points[i]);
+
+    for (size_t i = 0; i < nf; ++i)
+        _mesh.add_face(vhs[_arrays.triangles[3*i]],
+                       vhs[_arrays.triangles[3*i+1]],
+                       vhs[_arrays.triangles[3*i+2]]);
+}
@@ -0,0 +1,38 @@
+#ifndef MESHGENERATORS_H
+#define MESHGENERATORS_H
+
+//== INCLUDES =================================================================
+#include <vector>
+#include <cstddef>
+
+#include "TCMesh.h"
+
+//== CLASS DEFINITION =========================================================
+/// flat point and triangle arrays, filled by the generators below
+struct MeshArrays
+{
+    std::vector<TCMesh::Point> points;
+    std::vector<unsigned int>  triangles;
+
+    size_t n_faces() const { return triangles.size()/3; }
+};
+
+//== FUNCTIONS ================================================================
+/// Synthetic meshes of controllable size for benchmarking. Sizes are given as
+/// approximate face counts; output is deterministic for a given size.
+
+/// unit sphere from a subdivided icosahedron, level chosen closest to _faces
+void make_icosphere(size_t _faces, MeshArrays& _out);
+
+/// regular grid in [0,1]^2 with uniform z noise of amplitude _noise
+void make_noisy_grid(size_t _faces, float _noise, MeshArrays& _out);
+
+/// _faces unconnected triangles scattered in the unit cube
+void make_triangle_soup(size_t _faces, MeshArrays& _out);
+
+/// fill _mesh (whose attributes are already requested) from _arrays
+void build_mesh(const MeshArrays& _arrays, TCMesh& _mesh);
+
+//=============================================================================
+#endif // MESHGENERATORS_H defined
+//=============================================================================
@@ -0,0 +1,8 @@
+TEMPLATE = app
+TARGET   = TCViewerBench
+
+include(../TCViewer.pri)
+
+HEADERS  += MeshGenerators.h
+SOURCES  += bench_main.cpp \
+    MeshGenerators.cpp
@@ -0,0 +1,434 @@
+//== INCLUDES =================================================================
+#include <iostream>
+#include <string>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include <QApplication>
+#include <QTemporaryFile>
+
+#include "TCViewer.h"
+#include "MeshAnalysis.h"
+#include "MeshKernelsT.h"
+#include "MeshSmoothing.h"
+#include "TriangleBVH.h"
+#include "IsoLines.h"
+#include "AmbientOcclusion.h"
+#include "FrameExporter.h"
+#include "VertexLayouts.h"
+#include "VertexSplit.h"
+#include "ScalarSequence.h"
+#include "VertexAnimation.h"
+#include "MeshGenerators.h"
+
+//== CLASS DEFINITION =========================================================
+/// exposes a single synchronous frame for timing
+class BenchViewer : public TCViewer
+{
+public:
+    void render_frame()
+    {
+        preDraw();
+        draw();
+        glFinish();
+    }
+
+    /// give the mesh exactly these vertex attributes, made up where missing,
+    /// and upload it again, interleaved or not
+    void set_attributes(bool _normals, bool _colors, bool _texcoords, bool _interleaved)
+    {
+        TCMesh& m = mesh();
+        if ( _normals && !m.has_vertex_normals() )
+        {
+            m.request_vertex_normals();
+            update_normals(m, false, true);
+        }
+        else if ( !_normals && m.has_vertex_normals() )
+            m.release_vertex_normals();
+
+        if ( _colors && !m.has_vertex_colors() )
+        {
+            m.request_vertex_colors();
+            for (TCMesh::VertexIter v_it=m.vertices_begin(); v_it!=m.vertices_end(); ++v_it)
+                m.set_color(*v_it, TCMesh::Color(200, 180, 160));
+        }
+        else if ( !_colors && m.has_vertex_colors() )
+            m.release_vertex_colors();
+
+        if ( _texcoords && !m.has_vertex_texcoords2D() )
+        {
+            m.request_vertex_texcoords2D();
+            for (TCMesh::VertexIter v_it=m.vertices_begin(); v_it!=m.vertices_end(); ++v_it)
+                m.set_texcoord2D(*v_it, TCMesh::TexCoord2D(m.point(*v_it)[0], m.point(*v_it)[1]));
+        }
+        else if ( !_texcoords && m.has_vertex_texcoords2D() )
+            m.release_vertex_texcoords2D();
+
+        interleaved_ = _interleaved;
+        makeCurrent();
+        upload_mesh();
+    }
+};
+
+//== IMPLEMENTATION ==========================================================
+static void report(const std::string& _generator, const TCMesh& _mesh,
+                   const std::string& _kernel, double _seconds)
+{
+    /// CSV: generator,faces,vertices,kernel,seconds,mfaces_per_s
+    std::cout << _generator << "," << _mesh.n_faces() << "," << _mesh.n_vertices() << ","
+              << _kernel << "," << _seconds << ","
+              << (_seconds > 0.0 ? _mesh.n_faces()/_seconds*1e-6 : 0.0) << std::endl;
+}
+
+/// best of _repeats runs of _kernel()
+template <typename Kernel>
+static double best_of(int _repeats, Kernel _kernel)
+{
+    double best = std::numeric_limits<double>::max();
+    for (int r = 0; r < _repeats; ++r)
+    {
+        OpenMesh::Utils::Timer t;
+        t.start();
+        _kernel();
+        t.stop();
+        best = std::min(best, t.seconds());
+    }
+    return best;
+}
+
+/// best of _repeats packings of all vertices into Layout
+template <int Layout>
+static double time_packing(int _repeats, const VertexArrays& _arrays, size_t _n)
+{
+    std::vector< InterleavedVertex<Layout> > vertices(_n);
+    return best_of(_repeats, [&]{ pack_vertices<Layout>(_arrays, 0, _n, &vertices[0]); });
+}
+
+static void usage_and_exit(const char* _cmd)
+{
+    std::cerr << "Usage: " << _cmd << " [options]\n\n"
+              << "  -m <n>    largest mesh in faces (default 50000000)\n"
+              << "  -r <n>    repetitions per kernel, best is reported (default 3)\n"
+              << "  -g <s>    generators: any of i(cosphere), g(rid), s(oup) (default igs)\n"
+              << "  -R        skip the render modes\n\n"
+              << "Writes CSV rows generator,faces,vertices,kernel,seconds,mfaces_per_s\n";
+    exit(1);
+}
+
+//== MAIN FUNCTION ============================================================
+int main(int argc, char** argv)
+{
+    QApplication application(argc, argv);
+
+    size_t max_faces = 50000000;
+    int repeats = 3;
+    std::string generators = "igs";
+    bool render = true;
+
+    int c;
+    while ( (c = getopt(argc, argv, "m:r:g:Rh")) != -1 )
+    {
+        switch (c)
+        {
+        case 'm': max_faces = strtoul(optarg, 0, 10); break;
+        case 'r': repeats = std::max(1, atoi(optarg)); break;
+        case 'g': generators = optarg; break;
+        case 'R': render = false; break;
+        default:  usage_and_exit(argv[0]);
+        }
+    }
+
+    /// hidden viewer for the GL context, frames go to an offscreen target
+    BenchViewer viewer;
+    viewer.setAttribute(Qt::WA_DontShowOnScreen);
+    viewer.resize(1280, 720);
+    viewer.show();
+    viewer.makeCurrent();
+
+    FrameExporter target(1280, 720, QString());
+    if ( render && !target.begin() )
+        render = false;
+
+    const char* modes[] = { "Smooth", "Flat", "Wireframe", "Points", "Hidden-Line",
+                            "Valence", "GaussianCurvature", "MeanCurvature" };
+    const size_t sizes[] = { 10000, 100000, 1000000, 10000000, 50000000 };
+
+    /// parallel normals against OpenMesh's on a grid of strongly varying
+    /// triangle sizes: only UniformWeights reproduces it, the other
+    /// weightings show how far the viewer's shading moved
+    {
+        MeshArrays arrays;
+        make_noisy_grid(20000, 0.05f, arrays);
+        TCMesh mesh;
+        TCViewer::request_attributes(mesh);
+        build_mesh(arrays, mesh);
+        mesh.update_face_normals();
+        mesh.update_vertex_normals();
+        std::vector<TCMesh::Normal> reference(mesh.vertex_normals(), mesh.vertex_normals()+mesh.n_vertices());
+
+        const NormalWeights weights[] = { UniformWeights, AreaWeights, AngleWeights };
+        const char* names[] = { "uniform", "area", "angle" };
+        VertexCorners corners;
+        vertex_corners(mesh, corners);
+        for (int w = 0; w < 3; ++w)
+        {
+            update_normals(mesh, corners, true, true, weights[w]);
+            float deviation = 0.0f;
+            for (size_t i = 0; i < reference.size(); ++i)
+                deviation = std::max(deviation, (mesh.normal(TCMesh::VertexHandle(i)) - reference[i]).norm());
+            std::cerr << "irregular grid: " << names[w] << " normals deviate by "
+                      << deviation << " from OpenMesh" << std::endl;
+        }
+    }
+
+    std::cout << "generator,faces,vertices,kernel,seconds,mfaces_per_s" << std::endl;
+
+    for (size_t g = 0; g < generators.size(); ++g)
+    {
+        for (size_t s = 0; s < sizeof(sizes)/sizeof(sizes[0]) && sizes[s] <= max_faces; ++s)
+        {
+            std::string name;
+            MeshArrays arrays;
+            switch (generators[g])
+            {
+            case 'i': name = "icosphere"; make_icosphere(sizes[s], arrays); break;
+            case 'g': name = "grid";      make_noisy_grid(sizes[s], 0.002f, arrays); break;
+            case 's': name = "soup";      make_triangle_soup(sizes[s], arrays); break;
+            default:  continue;
+            }
+
+            TCMesh& mesh = viewer.mesh();
+            TCViewer::request_attributes(mesh);
+            build_mesh(arrays, mesh);
+            arrays = MeshArrays();
+
+            /// CPU kernels of the load pipeline
+            TCMesh::Point bb_min, bb_max;
+            report(name, mesh, "bbox",
+                   best_of(repeats, [&]{ bounding_box(mesh, bb_min, bb_max); }));
+
+            OpenMesh::FPropHandleT<TCMesh::Point> centroids;
+            mesh.add_property(centroids);
+            report(name, mesh, "face_centroids",
+                   best_of(repeats, [&]{ face_centroids(mesh, centroids); }));
+            mesh.remove_property(centroids);
+
+            std::vector<float> values;
+            report(name, mesh, "valence",
+                   best_of(repeats, [&]{ compute_valence(mesh, values); }));
+            report(name, mesh, "face_normals",
+                   best_of(repeats, [&]{ mesh.update_face_normals(); }));
+            report(name, mesh, "vertex_normals",
+                   best_of(repeats, [&]{ mesh.update_vertex_normals(); }));
+
+            VertexCorners corners;
+            report(name, mesh, "vertex_corners",
+                   best_of(repeats, [&]{ vertex_corners(mesh, corners); }));
+            report(name, mesh, "normals_parallel",
+                   best_of(repeats, [&]{ update_normals(mesh, corners); }));
+            report(name, mesh, "normals_parallel_angle",
+                   best_of(repeats, [&]{ update_normals(mesh, corners, true, true, AngleWeights); }));
+            report(name, mesh, "normals_parallel_uniform",
+                   best_of(repeats, [&]{ update_normals(mesh, corners, true, true, UniformWeights); }));
+
+            std::vector<unsigned int> indices;
+            report(name, mesh, "index_buffer",
+                   best_of(repeats, [&]{ triangle_indices(mesh, indices); }));
+
+            /// packing kernel of every interleaved layout, with made up
+            /// colors and texture coordinates
+            {
+                const size_t nv = mesh.n_vertices();
+                std::vector<unsigned char> colors(3*nv, 200);
+                std::vector<float> texcoords(2*nv, 0.5f);
+                VertexArrays arrays;
+                arrays.points    = &mesh.points()[0][0];
+                arrays.normals   = &mesh.vertex_normals()[0][0];
+                arrays.colors    = &colors[0];
+                arrays.texcoords = &texcoords[0];
+                report(name, mesh, "pack_p",   time_packing<LayoutP>(repeats, arrays, nv));
+                report(name, mesh, "pack_pn",  time_packing<LayoutPN>(repeats, arrays, nv));
+                report(name, mesh, "pack_pnc", time_packing<LayoutPNC>(repeats, arrays, nv));
+                report(name, mesh, "pack_pnt", time_packing<LayoutPNT>(repeats, arrays, nv));
+            }
+
+            /// render vertices for made up face colors, runs of 64 faces
+            /// alike, and packing through the split
+            {
+                std::vector<unsigned char> corner_colors(3*indices.size());
+                for (size_t c = 0; c < indices.size(); ++c)
+                    corner_colors[3*c] = static_cast<unsigned char>(c/(3*64));
+                VertexSplit split;
+                report(name, mesh, "vertex_split",
+                       best_of(repeats, [&]{ split.build(&indices[0], mesh.n_faces(), mesh.n_vertices(),
+                                                         &corner_colors[0], 0); }));
+                std::cerr << name << " " << mesh.n_faces() << ": vertex_split ratio "
+                          << split.ratio() << std::endl;
+
+                std::vector<unsigned char> colors(3*split.n_render_vertices());
+                split.gather_corners(&corner_colors[0], 3, &colors[0]);
+                VertexArrays arrays;
+                arrays.points  = &mesh.points()[0][0];
+                arrays.normals = &mesh.vertex_normals()[0][0];
+                arrays.colors  = &colors[0];
+                arrays.source  = &split.source()[0];
+                report(name, mesh, "pack_pnc_split",
+                       time_packing<LayoutPNC>(repeats, arrays, split.n_render_vertices()));
+            }
+
+            /// closest point queries of the vertices against their own mesh
+            TriangleBVH bvh;
+            report(name, mesh, "bvh_build",
+                   best_of(repeats, [&]{ bvh.build(&mesh.points()[0][0], mesh.n_vertices(),
+                                                   &indices[0], mesh.n_faces()); }));
+            std::vector<float> distances(mesh.n_vertices());
+            double seconds = best_of(repeats, [&]{ bvh.distances(&mesh.points()[0][0], mesh.n_vertices(),
+                                                                 &distances[0]); });
+            report(name, mesh, "closest_point", seconds);
+            std::cerr << name << " " << mesh.n_faces() << ": "
+                      << 1e-6*mesh.n_vertices()/std::max(seconds, 1e-9) << " M closest point queries/s"
+                      << std::endl;
+
+            /// cross-section through the center, tilted against all axes
+            TCMesh::Point lo, hi;
+            bounding_box(mesh, lo, hi);
+            const TCMesh::Point center = 0.5f*(lo+hi), normal = TCMesh::Point(0.3f, 0.5f, 0.81f).normalized();
+            const float plane[4] = { normal[0], normal[1], normal[2], -(normal|center) };
+            std::vector<float> section;
+            seconds = best_of(repeats, [&]{ bvh.slice(plane, section); });
+            report(name, mesh, "cross_section", seconds);
+            std::cerr << name << " " << mesh.n_faces() << ": cross-section of " << section.size()/6
+                      << " segments in " << 1e3*seconds << " ms" << std::endl;
+            bvh.clear();
+
+            /// occlusion bake at the viewer's default radius: BVH plus the
+            /// first pass, then one refining pass
+            AmbientOcclusion occlusion;
+            report(name, mesh, "occlusion_first_pass",
+                   best_of(1, [&]{ occlusion.begin(&mesh.points()[0][0], &mesh.vertex_normals()[0][0],
+                                                   mesh.n_vertices(), &indices[0], mesh.n_faces(),
+                                                   0.03f*(hi-lo).norm());
+                                   occlusion.refine(4); }));
+            seconds = best_of(1, [&]{ occlusion.refine(8); });
+            report(name, mesh, "occlusion_pass", seconds);
+            std::cerr << name << " " << mesh.n_faces() << ": "
+                      << 8e-6*mesh.n_vertices()/std::max(seconds, 1e-9) << " M occlusion rays/s"
+                      << std::endl;
+            occlusion.clear();
+
+            /// ten levels of the height field, slicing every mesh across
+            std::vector<float> heights(mesh.n_vertices()), levels, segments;
+            for (size_t i = 0; i < heights.size(); ++i)
+                heights[i] = mesh.point(TCMesh::VertexHandle(static_cast<int>(i)))[1];
+            even_levels(*std::min_element(heights.begin(), heights.end()),
+                        *std::max_element(heights.begin(), heights.end()), 10, levels);
+            report(name, mesh, "isolines",
+                   best_of(repeats, [&]{ extract_isolines(&mesh.points()[0][0], &heights[0], &indices[0],
+                                                          mesh.n_faces(), levels, segments); }));
+
+            /// per-frame read of a scalar sequence, the file in the OS cache
+            {
+                const size_t n_frames = 16;
+                QTemporaryFile file;
+                ScalarSequence sequence;
+                if ( file.open() )
+                {
+                    for (size_t f = 0; f < n_frames; ++f)
+                        file.write(reinterpret_cast<const char*>(&heights[0]), heights.size()*sizeof(float));
+                    file.flush();
+                }
+                if ( sequence.open(file.fileName(), heights.size()) )
+                {
+                    std::vector<float> frame(heights.size());
+                    seconds = best_of(repeats, [&]{ for (size_t f = 0; f < n_frames; ++f)
+                                                        sequence.read(f, &frame[0]); })/n_frames;
+                    report(name, mesh, "sequence_frame", seconds);
+                    std::cerr << name << " " << mesh.n_faces() << ": sequence frames read at "
+                              << sequence.frame_bytes()/(1024.0*1024.0)/std::max(seconds, 1e-9) << " MB/s"
+                              << std::endl;
+                }
+            }
+
+            /// per-frame work of a vertex animation on the worker: read
+            /// positions, face and vertex normals
+            {
+                const size_t n_frames = 4;
+                QTemporaryFile file;
+                VertexAnimation animation;
+                if ( file.open() )
+                {
+                    for (size_t f = 0; f < n_frames; ++f)
+                        file.write(reinterpret_cast<const char*>(&mesh.points()[0][0]),
+                                   mesh.n_vertices()*sizeof(TCMesh::Point));
+                    file.flush();
+                }
+                if ( animation.open(file.fileName(), &indices[0], mesh.n_faces(), mesh.n_vertices()) )
+                    report(name, mesh, "animation_frame",
+                           best_of(repeats, [&]{ for (size_t f = 0; f < n_frames; ++f)
+                                                     animation.prepare(f); })/n_frames);
+            }
+
+            VertexAdjacency adjacency;
+            report(name, mesh, "vertex_adjacency",
+                   best_of(repeats, [&]{ build_vertex_adjacency(mesh, adjacency); }));
+            std::vector<TCMesh::Point> scratch;
+            report(name, mesh, "smooth_taubin",
+                   best_of(repeats, [&]{ smooth_iteration(adjacency, &mesh.point(TCMesh::VertexHandle(0)),
+                                                          scratch, true, 0.5f); }));
+
+            /// whole pipeline incl. curvature, histograms and upload
+            viewer.makeCurrent();
+            report(name, mesh, "prepare_mesh",
+                   best_of(1, [&]{ viewer.prepare_mesh(OpenMesh::IO::Options()); }));
+
+            if ( !render )
+                continue;
+
+            /// every mode with float and with quantized vertex buffers
+            viewer.camera()->setScreenWidthAndHeight(target.width(), target.height());
+            for (int q = 0; q < 2; ++q)
+            {
+                viewer.makeCurrent();
+                viewer.set_quantized(q == 1);
+                std::cerr << name << " " << mesh.n_faces() << ": "
+                          << viewer.vertex_bytes() << " bytes/vertex" << std::endl;
+
+                target.bind();
+                for (size_t m = 0; m < sizeof(modes)/sizeof(modes[0]); ++m)
+                {
+                    viewer.set_draw_mode(modes[m]);
+                    viewer.render_frame();   // warm up, uploads lazy buffers
+                    report(name, mesh, std::string("draw_") + modes[m] + (q ? "_quantized" : ""),
+                           best_of(repeats, [&]{ viewer.render_frame(); }));
+                }
+                target.release();
+            }
+
+            /// Smooth shading per attribute set, from its interleaved
+            /// layout and from one buffer per attribute
+            const bool sets[4][3] = { { false, false, false }, { true, false, false },
+                                      { true,  true,  false }, { true, false, true  } };
+            viewer.set_quantized(false);
+            viewer.set_draw_mode("Smooth");
+            for (int l = 0; l < 4; ++l)
+            {
+                const std::string layout = vertex_layout_name(choose_vertex_layout(sets[l][0], sets[l][1], sets[l][2]));
+                for (int i = 0; i < 2; ++i)
+                {
+                    viewer.set_attributes(sets[l][0], sets[l][1], sets[l][2], i == 0);
+                    target.bind();
+                    viewer.render_frame();
+                    report(name, mesh, "draw_layout_" + layout + (i ? "_separate" : ""),
+                           best_of(repeats, [&]{ viewer.render_frame(); }));
+                    target.release();
+                }
+            }
+            viewer.set_attributes(true, false, false, true);
+        }
+    }
+
+    return 0;
+}
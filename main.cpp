@@ -1,6 +1,9 @@
 //== INCLUDES =================================================================
 #include <iostream>
 #include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
 #include <QApplication>
 #include <QMessageBox>
 #include <QMainWindow>
@@ -9,10 +12,60 @@
 
 #include "MainWindow.h"
 #include "TCViewer.h"
+#include "BatchAnalysis.h"
 
 //== MAIN FUNCTION ============================================================
+static void usage_and_exit(const char* _cmd)
+{
+    std::cerr << "Usage: " << _cmd << " [options] [mesh [texture]]\n\n"
+              << "  -v         view-only: drop the CPU mesh after GPU upload\n"
+              << "  -q         quantized GPU vertex layout\n"
+              << "  -a         bake ambient occlusion of every loaded mesh\n"
+              << "  -r <mesh>  reference mesh for the Distance mode\n"
+              << "  -S <file>  scalar sequence of float32 frames, one value per vertex\n"
+              << "  -A <file>  vertex animation of float32 xyz frames, one position per vertex\n"
+              << "  -F <fps>   sequence playback rate (default 30)\n"
+              << "  -e <dir>   render frames offscreen into <dir> and quit\n"
+              << "  -n <n>     number of exported frames (default 120)\n"
+              << "  -s <WxH>   export resolution (default 1280x720)\n"
+              << "  -k <i>     follow camera key frame path <i> instead of a turntable\n"
+              << "  -j <n>     PNG encoder threads (default: cores-1)\n"
+              << "  -t <MB>    GPU budget of streamed texture tiles (default 256)\n\n"
+              << "       " << _cmd << " -b [batch options] <mesh|dir|@list>...\n\n"
+              << "  -o <file>  write rows to <file>, JSON lines for *.json(l) (default: CSV to stdout)\n"
+              << "  -j <n>     meshes analyzed at once (default: cores)\n"
+              << "  -m <MB>    memory budget of the meshes in flight (default 4096)\n";
+    exit(1);
+}
+
+/// headless analysis of many meshes, no display needed
+static int batch_main(int argc, char** argv, const char* _cmd)
+{
+    BatchOptions options;
+    int c;
+    while ( (c = getopt(argc, argv, "o:j:m:h")) != -1 )
+    {
+        switch (c)
+        {
+        case 'o': options.output = optarg; break;
+        case 'j': options.jobs = atoi(optarg); break;
+        case 'm': if ( atoi(optarg) <= 0 ) usage_and_exit(_cmd); options.memory_mb = atoi(optarg); break;
+        default:  usage_and_exit(_cmd);
+        }
+    }
+    for (int i = optind; i < argc; ++i)
+        options.inputs << QString::fromLocal8Bit(argv[i]);
+    if ( options.inputs.isEmpty() )
+        usage_and_exit(_cmd);
+
+    return run_batch(options, std::clog) == 0 ? 0 : 1;
+}
+
 int main(int argc, char** argv)
 {
+    if ( argc > 1 && std::string(argv[1]) == "-b" )
+        return batch_main(argc-1, argv+1, argv[0]);
+
     // OpenGL check
     QApplication::setColorSpec(QApplication::CustomColor);
     QApplication application(argc,argv);
@@ -23,6 +76,33 @@ int main(int argc, char** argv)
         return -1;
     }
 
+    /// command line options
+    QString export_dir, reference, sequence, animation;
+    int frames = 120, width = 1280, height = 720, keyframes = -1, jobs = 0, texture_mb = 256;
+    double fps = 30.0;
+    bool view_only = false, quantized = false, occlusion = false;
+    int c;
+    while ( (c = getopt(argc, argv, "vqar:S:A:F:e:n:s:k:j:t:h")) != -1 )
+    {
+        switch (c)
+        {
+        case 'v': view_only = true; break;
+        case 'q': quantized = true; break;
+        case 'a': occlusion = true; break;
+        case 'r': reference = optarg; break;
+        case 'S': sequence = optarg; break;
+        case 'A': animation = optarg; break;
+        case 'F': fps = atof(optarg); if ( fps <= 0.0 ) usage_and_exit(argv[0]); break;
+        case 'e': export_dir = optarg; break;
+        case 'n': frames = atoi(optarg); break;
+        case 's': if ( sscanf(optarg, "%dx%d", &width, &height) != 2 ) usage_and_exit(argv[0]); break;
+        case 'k': keyframes = atoi(optarg); break;
+        case 'j': jobs = atoi(optarg); break;
+        case 't': texture_mb = atoi(optarg); if ( texture_mb <= 0 ) usage_and_exit(argv[0]); break;
+        default:  usage_and_exit(argv[0]);
+        }
+    }
+
     OpenMesh::IO::Options opt;
 
     /// enable most options for now
@@ -36,10 +116,35 @@ int main(int argc, char** argv)
     MainWindow mainWin;
     TCViewer viewer(&mainWin);
     viewer.setOptions(opt);
+    viewer.set_texture_budget(static_cast<size_t>(texture_mb)*1024*1024);
+    viewer.set_sequence_fps(fps);
     mainWin.setCentralWidget(&viewer);
     viewer.setWindowTitle("TCViewer");
     mainWin.createActions(&viewer);
     mainWin.createMenus();
+    mainWin.viewOnlyAct->setChecked(view_only);
+    mainWin.quantizeAct->setChecked(quantized);
+    mainWin.occlusionAct->setChecked(occlusion);
+    if ( !reference.isEmpty() && !viewer.open_reference(reference.toLocal8Bit()) )
+        std::cerr << "Cannot read reference mesh '" << reference.toLocal8Bit().constData() << "'" << std::endl;
+
+    /// headless export: the window provides the GL context but is never mapped
+    if ( !export_dir.isEmpty() )
+    {
+        mainWin.setAttribute(Qt::WA_DontShowOnScreen);
+        mainWin.show();
+
+        if ( optind >= argc || !viewer.open_mesh(argv[optind], opt) )
+        {
+            std::cerr << "Export needs a readable mesh file" << std::endl;
+            return 1;
+        }
+        if ( optind+1 < argc )
+            viewer.open_texture(argv[optind+1]);
+
+        return viewer.export_animation(export_dir, frames, width, height, keyframes, jobs) ? 0 : 1;
+    }
+
     mainWin.show();
     
     /// load scene if specified on the command line
@@ -53,6 +158,11 @@ int main(int argc, char** argv)
         viewer.open_texture_gui(argv[optind]);
     }
 
+    if ( !sequence.isEmpty() && !viewer.open_scalar_sequence(sequence) )
+        std::cerr << "Cannot map scalar sequence '" << sequence.toLocal8Bit().constData() << "'" << std::endl;
+    if ( !animation.isEmpty() && !viewer.open_animation(animation) )
+        std::cerr << "Cannot map vertex animation '" << animation.toLocal8Bit().constData() << "'" << std::endl;
+
     return application.exec();
 }
 